@@ -0,0 +1,72 @@
+// Reports how long the blob tracker takes on a 640 x 480 mask, against the
+// 1 ms it has on the render thread, and how steady its ids are: CapsuleBodies
+// draws 1, 3 and 6 dancers walking about for 20 seconds, DepthSegmenter
+// cuts them out, and the tracker follows them. Dancers who pass in front of
+// one another merge into one blob for a while, and one who is first seen
+// inside such a blob gets an id of its own only once it steps out, so the
+// ids handed out can be a few more than the dancers; more than twice as
+// many means limbs or merges are being taken for new dancers, and fails.
+// Build and run with `make -C bench blob`.
+
+#include "CapsuleBodies.h"
+#include "DepthSegmenter.h"
+#include "BlobTracker.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    typedef std::chrono::steady_clock clock;
+
+    const int	width = 640;
+    const int	height = 480;
+    const int	numFrames = 600;
+    const float	frameTime = 1 / 30.0f;
+    const int	maxIdsPerDancer = 2;
+}
+
+int main() {
+    CapsuleBodies bodies;
+    bodies.setup(width, height);
+    std::vector<float> scratch(bodies.getScratchSize());
+    std::vector<uint16_t> depth(width * height);
+    std::vector<uint8_t> mask(width * height);
+
+    printf("%d x %d, %d frames\n", width, height, numFrames);
+    int counts[] = { 1, 3, 6 };
+    bool ok = true;
+    for (int c=0; c<3; c++) {
+        DepthSegmenter segmenter;
+        segmenter.setup(width, height);
+        BlobTracker tracker;
+        tracker.setup(width, height);
+
+        double seconds = 0, worst = 0;
+        long numBlobs = 0;
+        int maxId = 0;
+        for (int f=-30; f<numFrames; f++) {
+            // the empty room first, for the background
+            bodies.animate(f * frameTime, f < 0 ? 0 : counts[c]);
+            bodies.renderRows(0, height, depth.data(), scratch.data());
+            segmenter.process(depth.data(), mask.data(), true);
+
+            clock::time_point start = clock::now();
+            tracker.process(mask.data(), depth.data(), true, frameTime);
+            double s = std::chrono::duration<double>(clock::now() - start).count();
+            if (f < 0)
+                continue;
+            seconds += s;
+            worst = s > worst ? s : worst;
+            numBlobs += tracker.getBlobs().size();
+            for (size_t b=0; b<tracker.getBlobs().size(); b++)
+                maxId = tracker.getBlobs()[b].id > maxId ? tracker.getBlobs()[b].id : maxId;
+        }
+        bool steady = maxId <= counts[c] * maxIdsPerDancer;
+        ok = ok && steady;
+        printf("%d dancers: %.3f ms a frame, %.3f ms at worst, %.2f blobs a frame, %d ids%s\n",
+            counts[c], seconds * 1000 / numFrames, worst * 1000, (double)numBlobs / numFrames, maxId, steady ? "" : ", TOO MANY");
+    }
+    printf("%s\n", ok ? "ok" : "WRONG");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+// Reports how long the contour tracer takes on a 640 x 480 foreground mask,
+// against the 0.5 ms it is allowed, and how much the simplification keeps:
+// CapsuleBodies draws 1, 3 and 6 dancers walking about for 20 seconds and
+// DepthSegmenter cuts them out. First it checks the geometry on a ring that
+// moves 3 pixels to the right: one outside and one hole of the right areas,
+// the normals pointing out of the ring, and each corner's speed the 3
+// pixels a frame seen along its normal, to within the pixel the previous
+// boundary is found to and half a pixel of the corner's own rounding.
+// Build and run with `make -C bench contour`.
+
+#include "CapsuleBodies.h"
+#include "DepthSegmenter.h"
+#include "ContourTracer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    typedef std::chrono::steady_clock clock;
+
+    const int	width = 640;
+    const int	height = 480;
+    const int	numFrames = 600;
+    const float	frameTime = 1 / 30.0f;
+
+    // a ring round (_x, 240), 100 pixels out and 40 in
+    void ring(std::vector<uint8_t>& _mask, int _x) {
+        for (int y=0; y<height; y++) {
+            for (int x=0; x<width; x++) {
+                int d2 = (x - _x) * (x - _x) + (y - 240) * (y - 240);
+                _mask[y * width + x] = d2 < 100 * 100 && d2 >= 40 * 40 ? 255 : 0;
+            }
+        }
+    }
+
+    bool check() {
+        std::vector<uint8_t> mask(width * height);
+        ContourTracer tracer;
+        tracer.setup(width, height);
+        ring(mask, 300);
+        tracer.process(mask.data(), frameTime);
+        ring(mask, 303);
+        tracer.process(mask.data(), frameTime);
+
+        const std::vector<Contour>& contours = tracer.getContours();
+        const std::vector<ContourVertex>& vertices = tracer.getVertices();
+        bool ok = contours.size() == 2;
+        for (size_t c=0; ok && c<contours.size(); c++) {
+            const Contour& contour = contours[c];
+            float radius = contour.hole ? 40 : 100;
+            float expected = 3.14159265f * radius * radius;
+            float worstSpeed = 0;
+            bool outwards = true;
+            for (int i=contour.first; i<contour.first+contour.count; i++) {
+                const ContourVertex& v = vertices[i];
+                // out of the ring is away from the middle, or into the hole
+                float rx = v.x - 303, ry = v.y - 240;
+                float out = (rx * v.nx + ry * v.ny) / sqrtf(rx * rx + ry * ry);
+                outwards = outwards && (contour.hole ? out < -0.9f : out > 0.9f);
+                // it moved 3 pixels to the right, seen along the normal
+                float error = fabsf(v.speed * frameTime - 3 * v.nx);
+                worstSpeed = error > worstSpeed ? error : worstSpeed;
+            }
+            printf("  %s: %d corners, area %.0f of %.0f, normals %s, speed %.2f pixels a frame off at worst\n",
+                contour.hole ? "hole" : "outside", contour.count, contour.area, expected, outwards ? "out" : "WRONG", worstSpeed);
+            ok = ok && fabsf(contour.area - expected) < expected * 0.02f && outwards && worstSpeed <= 1.5f;
+        }
+        return ok;
+    }
+}
+
+int main() {
+    printf("ring check:\n");
+    printf("%s\n\n", check() ? "ok" : "WRONG");
+
+    CapsuleBodies bodies;
+    bodies.setup(width, height);
+    std::vector<float> scratch(bodies.getScratchSize());
+    std::vector<uint16_t> depth(width * height);
+    std::vector<uint8_t> mask(width * height);
+
+    printf("%d x %d, %d frames\n", width, height, numFrames);
+    int counts[] = { 1, 3, 6 };
+    for (int c=0; c<3; c++) {
+        DepthSegmenter segmenter;
+        segmenter.setup(width, height);
+        ContourTracer tracer;
+        tracer.setup(width, height);
+
+        double seconds = 0, worst = 0;
+        long numContours = 0, numVertices = 0, numCrossings = 0;
+        for (int f=-30; f<numFrames; f++) {
+            bodies.animate(f * frameTime, f < 0 ? 0 : counts[c]);
+            bodies.renderRows(0, height, depth.data(), scratch.data());
+            segmenter.process(depth.data(), mask.data(), true);
+
+            clock::time_point start = clock::now();
+            tracer.process(mask.data(), frameTime);
+            double s = std::chrono::duration<double>(clock::now() - start).count();
+            if (f < 0)
+                continue;
+            seconds += s;
+            worst = s > worst ? s : worst;
+            numContours += tracer.getContours().size();
+            numVertices += tracer.getVertices().size();
+            numCrossings += tracer.getNumCrossings();
+        }
+        printf("%d dancers: %.3f ms a frame, %.3f ms at worst, %.1f contours, %.0f crossings to %.0f corners\n",
+            counts[c], seconds * 1000 / numFrames, worst * 1000, (double)numContours / numFrames,
+            (double)numCrossings / numFrames, (double)numVertices / numFrames);
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+// Reports the cost of one RealFft transform at every supported size.
+// Build and run with `make -C bench fft`.
+
+#include "RealFft.h"
+#include "Simd.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 0.25;
+
+    printf("RealFft (%s), %.2f s per size\n", simd::getName(), seconds);
+    printf("%8s %14s %14s\n", "size", "ns/transform", "ns/sample");
+
+    for (int size=RealFft::minSize; size<=RealFft::maxSize; size*=2) {
+        RealFft fft;
+        fft.setup(size, REAL_FFT_WINDOW_HANN);
+
+        std::vector<float> input(size);
+        std::vector<float> amplitudes(fft.getNumBins());
+        for (int i=0; i<size; i++)
+            input[i] = sinf(i * 0.05f) + 0.25f * (rand() / (float)RAND_MAX - 0.5f);
+
+        // warm up caches and the branch predictor
+        for (int i=0; i<100; i++)
+            fft.amplitudes(input.data(), amplitudes.data());
+
+        typedef std::chrono::steady_clock clock;
+        long iterations = 0;
+        clock::time_point start = clock::now();
+        double elapsed = 0;
+        while (elapsed < seconds) {
+            for (int i=0; i<64; i++)
+                fft.amplitudes(input.data(), amplitudes.data());
+            iterations += 64;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        }
+
+        double ns = elapsed * 1e9 / iterations;
+        printf("%8d %14.1f %14.3f\n", size, ns, ns / size);
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+// Reports how long DepthFusion takes to stitch 1 to 4 Kinect sized depth
+// images into a 640 x 240 view of the stage, from the front and from above,
+// and so what each sensor adds: the cost should grow by the same step for
+// each. The sensors all see the same CapsuleBodies frame of three dancers,
+// from poses spread along the front of the stage.
+// Build and run with `make -C bench fusion`.
+
+#include "CapsuleBodies.h"
+#include "DepthFusion.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    typedef std::chrono::steady_clock clock;
+
+    const int	width = 640;
+    const int	height = 480;
+    const int	fusedWidth = 640;
+    const int	fusedHeight = 240;
+    const int	numFrames = 300;
+}
+
+int main() {
+    CapsuleBodies bodies;
+    bodies.setup(width, height);
+    bodies.animate(2.0, 3);
+    std::vector<float> scratch(bodies.getScratchSize());
+    std::vector<uint16_t> depth(width * height);
+    bodies.renderRows(0, height, depth.data(), scratch.data());
+    std::vector<uint16_t> fused(fusedWidth * fusedHeight);
+
+    DepthFusion::Box box = { -4, 4, 0.05f, 3, 0, 8 };
+    const char* names[] = { "front", "top" };
+    printf("%d x %d into %d x %d, %d frames\n", width, height, fusedWidth, fusedHeight, numFrames);
+    for (int v=0; v<2; v++) {
+        for (int n=1; n<=4; n++) {
+            DepthFusion fusion;
+            fusion.setup(v == 0 ? DepthFusion::VIEW_FRONT : DepthFusion::VIEW_TOP, fusedWidth, fusedHeight, box);
+            for (int s=0; s<n; s++) {
+                DepthFusion::Pose pose = { -3 + 2.0f * s, 1, 0, -15 + 10.0f * s, -3, 0 };
+                fusion.addSensor(width, height, pose);
+            }
+
+            clock::time_point start = clock::now();
+            for (int f=0; f<numFrames; f++) {
+                fusion.begin();
+                for (int s=0; s<n; s++)
+                    fusion.add(s, depth.data());
+                fusion.end(fused.data());
+            }
+            double ms = std::chrono::duration<double>(clock::now() - start).count() * 1000 / numFrames;
+
+            int covered = 0;
+            for (size_t i=0; i<fused.size(); i++)
+                covered += fused[i] != 0;
+            printf("%s, %d sensors: %.3f ms a frame, %.3f ms a sensor, %.1f%% covered\n",
+                names[v], n, ms, ms / n, 100.0 * covered / fused.size());
+        }
+    }
+    return 0;
+}
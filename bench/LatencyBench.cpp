@@ -0,0 +1,77 @@
+// Checks the latency tracer's percentiles and rows on a made up pipeline and
+// reports what it costs the render thread. The source runs at 30 Hz with
+// its frames 0 to 10 ms old when the 60 Hz app takes them, one in ten
+// dropped on the way; the flow and the mask add 2 ms each, and the stages
+// that run every app frame see every frame twice, the second time 16.7 ms
+// later. Every frame the app takes should reach the end once, and the
+// shown stage's p50, p95 and p99 should be where the uniform spread puts
+// them, to within a ms. Build and run with `make -C bench latency`.
+
+#include "LatencyTracer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    typedef std::chrono::steady_clock clock;
+
+    enum { SOURCE, FLOW, MASK, FLUID, PARTICLES, DRAWN, SHOWN, numStages };
+    const int		numFrames = 30 * 60;
+    const uint64_t	appFrame = 16667;		// us
+}
+
+int main() {
+    LatencyTracer tracer;
+    tracer.setup(numStages, 600);
+
+    int taken = 0, completed = 0, marks = 0;
+    double seconds = 0;
+    uint64_t now = 1000000;
+    srand(1);
+    for (uint64_t sequence=1; sequence<=numFrames; sequence++) {
+        uint64_t captured = now - rand() % 10001;
+        bool dropped = rand() % 10 == 0;
+        // two app frames a depth frame, the stages after the mask on both
+        for (int f=0; f<2; f++) {
+            clock::time_point start = clock::now();
+            if (!dropped) {
+                uint64_t t = now;
+                if (f == 0) {
+                    tracer.mark(SOURCE, sequence, captured, t);
+                    tracer.mark(FLOW, sequence, captured, t += 2000);
+                    tracer.mark(MASK, sequence, captured, t += 2000);
+                    marks += 3;
+                    taken++;
+                }
+                tracer.mark(FLUID, sequence, captured, t += 3000);
+                tracer.mark(PARTICLES, sequence, captured, t += 1000);
+                tracer.mark(DRAWN, sequence, captured, t += 2000);
+                completed += tracer.mark(SHOWN, sequence, captured, now + appFrame) ? 1 : 0;
+                marks += 4;
+            }
+            seconds += std::chrono::duration<double>(clock::now() - start).count();
+            now += appFrame;
+        }
+    }
+
+    clock::time_point start = clock::now();
+    tracer.updateSpreads();
+    double spreadSeconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    // the shown age is 16.7 ms plus the capture's 0 to 10
+    const LatencyTracer::Spread& shown = tracer.getSpread(SHOWN);
+    float p50 = 16.667f + 5.0f, p95 = 16.667f + 9.5f, p99 = 16.667f + 9.9f;
+    bool ok = completed == taken && fabsf(shown.p50 - p50) < 1 && fabsf(shown.p95 - p95) < 1 && fabsf(shown.p99 - p99) < 1;
+
+    const char* names[numStages] = { "source", "flow", "mask", "fluid", "particles", "drawn", "shown" };
+    printf("%d frames, %d taken, %d reached the screen once each\n", numFrames, taken, completed);
+    for (int s=0; s<numStages; s++) {
+        const LatencyTracer::Spread& spread = tracer.getSpread(s);
+        printf("  %-10s p50 %5.1f  p95 %5.1f  p99 %5.1f ms over %d\n", names[s], spread.p50, spread.p95, spread.p99, spread.count);
+    }
+    printf("shown should be p50 %.1f  p95 %.1f  p99 %.1f: %s\n", p50, p95, p99, ok ? "ok" : "WRONG");
+    printf("%.0f ns a mark, %.3f ms for the percentiles\n", seconds * 1e9 / marks, spreadSeconds * 1000);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+// Reports the per hop cost of the onset detector and tempo tracker that run
+// on the analysis thread, on a synthetic click track. The maximum includes
+// the odd hop where the OS preempted us, the 99th percentile is the number
+// to hold against the budget.
+// Build and run with `make -C bench onset`.
+
+#include "RealFft.h"
+#include "OnsetDetector.h"
+#include "TempoTracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+int main(int argc, char** argv) {
+    const int sampleRate = 44100;
+    const int fftSize = 512;
+    const int hopSize = 256;
+    const float bpm = 128;
+    const int seconds = 60;
+
+    // clicks on the beat over some noise
+    std::vector<float> signal(sampleRate * seconds);
+    int period = sampleRate * 60 / bpm;
+    for (size_t i=0; i<signal.size(); i++) {
+        int t = i % period;
+        signal[i] = 0.02f * (rand() / (float)RAND_MAX - 0.5f);
+        if (t < 2000)
+            signal[i] += 0.8f * expf(-t / 300.0f) * sinf(i * 0.3f);
+    }
+
+    RealFft fft;
+    fft.setup(fftSize);
+    std::vector<float> amplitudes(fft.getNumBins());
+    OnsetDetector onsets;
+    onsets.setup(fft.getNumBins(), hopSize / (float)sampleRate);
+    TempoTracker tempo;
+    tempo.setup(hopSize / (float)sampleRate);
+
+    typedef std::chrono::steady_clock clock;
+    std::vector<double> costs;
+    int numOnsets = 0;
+    int numBeats = 0;
+    for (size_t end=fftSize; end<=signal.size(); end+=hopSize) {
+        fft.amplitudes(&signal[end - fftSize], amplitudes.data());
+
+        clock::time_point start = clock::now();
+        numOnsets += onsets.process(amplitudes.data());
+        numBeats += tempo.process(onsets.getNovelty());
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+        costs.push_back(elapsed);
+    }
+
+    double total = 0;
+    for (size_t i=0; i<costs.size(); i++)
+        total += costs[i];
+    std::sort(costs.begin(), costs.end());
+
+    printf("onset + tempo, %d hops of %d samples, budget 200 us/hop\n", (int)costs.size(), hopSize);
+    printf("mean %8.2f us/hop\n", total * 1e6 / costs.size());
+    printf("p99  %8.2f us/hop\n", costs[costs.size() * 99 / 100] * 1e6);
+    printf("max  %8.2f us/hop\n", costs.back() * 1e6);
+    printf("%d onsets, %d beats, %.2f bpm (click track at %.0f)\n", numOnsets, numBeats, tempo.getBpm(), bpm);
+    return 0;
+}
@@ -0,0 +1,58 @@
+// Reports how long DepthProjector takes to turn a 640 x 480 depth frame into
+// its 307200 points, the work the point cloud does on the render thread each
+// frame (16.7 ms at 60 fps, all of it shared with everything else), and
+// checks a point against the pinhole model it is meant to follow.
+// Build and run with `make -C bench project`.
+
+#include "CapsuleBodies.h"
+#include "DepthProjector.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    typedef std::chrono::steady_clock clock;
+
+    const int	width = 640;
+    const int	height = 480;
+    const int	numFrames = 600;
+}
+
+int main() {
+    CapsuleBodies bodies;
+    bodies.setup(width, height);
+    bodies.animate(2.0, 6);
+    std::vector<float> scratch(bodies.getScratchSize());
+    std::vector<uint16_t> depth(width * height);
+    bodies.renderRows(0, height, depth.data(), scratch.data());
+
+    DepthProjector projector;
+    projector.setup(width, height);
+    int n = projector.getNumPoints();
+    std::vector<float> points(n * 3);
+
+    double seconds = 0, worst = 0;
+    for (int f=0; f<numFrames; f++) {
+        clock::time_point start = clock::now();
+        projector.project(depth.data(), &points[0], &points[n], &points[n * 2]);
+        double s = std::chrono::duration<double>(clock::now() - start).count();
+        seconds += s;
+        worst = s > worst ? s : worst;
+    }
+
+    // a pixel up and to the left of the centre, 2 m away
+    int x = 100, y = 50, i = y * width + x;
+    depth[i] = 2000;
+    projector.project(depth.data(), &points[0], &points[n], &points[n * 2]);
+    float focal = 580.0f;
+    float ex = (x - (width - 1) * 0.5f) / focal * 2, ey = ((height - 1) * 0.5f - y) / focal * 2;
+    float error = fabsf(points[i] - ex) + fabsf(points[n + i] - ey) + fabsf(points[n * 2 + i] + 2);
+
+    printf("%d x %d, %d points, %d frames\n", width, height, n, numFrames);
+    printf("project: %.3f ms a frame, %.3f ms at worst, %.1f ns a point\n",
+        seconds * 1000 / numFrames, worst * 1000, seconds * 1e9 / numFrames / n);
+    printf("pinhole check: %s (%.6f m off)\n", error < 1e-4f ? "ok" : "WRONG", error);
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Reports how long the depth segmenter takes on a 640 x 480 frame, the 1 ms
+// it has on the render thread being the budget, and how well it finds the
+// bodies: CapsuleBodies draws a room with 6 dancers in it, with the sensor's
+// noise and a scatter of missing readings, and every mask is compared with
+// where the bodies really are (the same frame drawn without noise, against
+// the empty room). The background is learned from the room for a second
+// first, the way the installation starts up.
+// Build and run with `make -C bench segment`.
+
+#include "CapsuleBodies.h"
+#include "DepthSegmenter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    typedef std::chrono::steady_clock clock;
+
+    const int	width = 640;
+    const int	height = 480;
+    const int	numBodies = 6;
+    const int	numFrames = 600;
+
+    void draw(CapsuleBodies& _bodies, double _seconds, int _numBodies, std::vector<uint16_t>& _depth) {
+        std::vector<float> scratch(_bodies.getScratchSize());
+        _bodies.animate(_seconds, _numBodies);
+        _bodies.renderRows(0, height, _depth.data(), scratch.data());
+    }
+}
+
+int main() {
+    CapsuleBodies bodies, truth;
+    bodies.setup(width, height);
+    truth.setup(width, height);
+    truth.setNoise(0);
+    DepthSegmenter segmenter;
+    segmenter.setup(width, height);
+
+    std::vector<uint16_t> depth(width * height), room(width * height), exact(width * height);
+    std::vector<uint8_t> mask(width * height);
+    draw(truth, 0, 0, room);
+    for (int f=0; f<30; f++) {
+        draw(bodies, f / 30.0, 0, depth);
+        segmenter.process(depth.data(), mask.data(), false);
+    }
+
+    double seconds = 0, worst = 0;
+    long missed = 0, extra = 0, bodyPixels = 0;
+    for (int f=0; f<numFrames; f++) {
+        double t = 1 + f / 30.0;
+        draw(bodies, t, numBodies, depth);
+        draw(truth, t, numBodies, exact);
+        for (int i=0; i<width * height; i++) {
+            if (rand() % 50 == 0)
+                depth[i] = 0;
+        }
+
+        clock::time_point start = clock::now();
+        segmenter.process(depth.data(), mask.data(), false);
+        double s = std::chrono::duration<double>(clock::now() - start).count();
+        seconds += s;
+        worst = s > worst ? s : worst;
+
+        for (int i=0; i<width * height; i++) {
+            bool body = exact[i] > 0 && exact[i] + 150 < room[i] && exact[i] >= 500 && exact[i] <= 4000;
+            bodyPixels += body;
+            missed += body && mask[i] == 0;
+            extra += !body && mask[i] != 0;
+        }
+    }
+
+    printf("%d x %d, %d bodies, %d frames\n", width, height, numBodies, numFrames);
+    printf("process: %.3f ms a frame, %.3f ms at worst\n", seconds * 1000 / numFrames, worst * 1000);
+    printf("body pixels missed %.2f%%, background pixels taken %.2f%% of the bodies' area\n",
+        100.0 * missed / bodyPixels, 100.0 * extra / bodyPixels);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Reports the audio callback cost of the spatializer placing 32 moving
+// sources on a ring of 8 speakers, including the per block gain updates,
+// against the duration of a 256 frame block at 44.1 kHz. A second row holds
+// every source in the middle of the ring, the worst case where each one
+// plays from all the speakers.
+// Build and run with `make -C bench spatial`.
+
+#include "Spatializer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    typedef std::chrono::steady_clock clock;
+
+    const int	sampleRate = 44100;
+    const int	blockSize = 256;
+    const int	numBlocks = 20000;
+    const int	numSources = 32;
+    const int	numSpeakers = 8;
+
+    void run(const char* _label, float _distance) {
+        std::vector<float> azimuths;
+        for (int s=0; s<numSpeakers; s++)
+            azimuths.push_back(-180 + 22.5f + s * 45);
+        Spatializer spatializer;
+        spatializer.setup(azimuths, numSources, blockSize);
+        std::vector<float> output(blockSize * numSpeakers);
+        std::vector<float> signal(numSources * blockSize);
+        for (size_t i=0; i<signal.size(); i++)
+            signal[i] = sinf(i * 0.01f);
+
+        std::vector<double> costs;
+        for (int b=0; b<numBlocks; b++) {
+            clock::time_point start = clock::now();
+            // every source circles at its own speed
+            for (int s=0; s<numSources; s++)
+                spatializer.setSource(s, fmodf(b * (s + 1) * 0.5f, 360.0f), _distance);
+            spatializer.clear(blockSize);
+            float* const* sources = spatializer.getSources();
+            for (int s=0; s<numSources; s++)
+                std::copy(&signal[s * blockSize], &signal[s * blockSize] + blockSize, sources[s]);
+            std::fill(output.begin(), output.end(), 0.0f);
+            spatializer.process(output.data(), blockSize, numSpeakers);
+            costs.push_back(std::chrono::duration<double>(clock::now() - start).count());
+        }
+
+        double total = 0;
+        for (size_t i=0; i<costs.size(); i++)
+            total += costs[i];
+        std::sort(costs.begin(), costs.end());
+        double budget = blockSize / (double)sampleRate;
+        double p99 = costs[costs.size() * 99 / 100];
+        printf("%-10s mean %7.2f us  p99 %7.2f us  %5.2f%% of the block\n",
+               _label, total * 1e6 / costs.size(), p99 * 1e6, 100 * p99 / budget);
+    }
+}
+
+int main(int argc, char** argv) {
+    printf("spatializer, %d sources on %d speakers, %d frame blocks, budget %.0f us/block\n",
+           numSources, numSpeakers, blockSize, blockSize * 1e6 / sampleRate);
+    printf("(the times include copying the test signal into the sources)\n");
+    run("on ring", 1);
+    run("in middle", 0);
+    return 0;
+}
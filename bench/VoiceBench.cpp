@@ -0,0 +1,105 @@
+// Reports the audio callback cost of the sampler's voice pool against the
+// number of voices playing, then under a stream of random triggers like the
+// one movement bursts produce. Each row keeps N voices sounding on a long
+// synthetic sample (retriggering any that end) and times 256 frame blocks;
+// the budget is the block's duration at 44.1 kHz.
+// Build and run with `make -C bench voice`.
+
+#include "VoicePool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    typedef std::chrono::steady_clock clock;
+
+    const int	sampleRate = 44100;
+    const int	blockSize = 256;
+    const int	numBlocks = 4000;
+
+    float random(float _min, float _max) {
+        return _min + (_max - _min) * (rand() / (float)RAND_MAX);
+    }
+
+    void report(const char* _label, std::vector<double>& _costs, double _activeSum) {
+        double total = 0;
+        for (size_t i=0; i<_costs.size(); i++)
+            total += _costs[i];
+        std::sort(_costs.begin(), _costs.end());
+        double budget = blockSize / (double)sampleRate;
+        double mean = total / _costs.size();
+        double p99 = _costs[_costs.size() * 99 / 100];
+        printf("%-18s %6.1f active  mean %7.2f us  p99 %7.2f us  %5.2f%% of the block\n",
+               _label, _activeSum / _costs.size(), mean * 1e6, p99 * 1e6, 100 * p99 / budget);
+    }
+}
+
+int main(int argc, char** argv) {
+    // ten seconds of stereo noise bursts, long enough that voices rarely end
+    const int channels = 2;
+    std::vector<float> sample(sampleRate * 10 * channels);
+    for (size_t i=0; i<sample.size(); i++)
+        sample[i] = 0.25f * sinf(i * 0.01f) + 0.05f * random(-1, 1);
+
+    std::vector<float> left(blockSize);
+    std::vector<float> right(blockSize);
+
+    printf("voice pool, %d blocks of %d frames, budget %.0f us/block\n", numBlocks, blockSize, blockSize * 1e6 / sampleRate);
+
+    const int counts[] = { 0, 8, 16, 32, 64, 128 };
+    for (size_t c=0; c<sizeof(counts) / sizeof(counts[0]); c++) {
+        int count = counts[c];
+        VoicePool pool;
+        pool.setup(std::max(count, 1), sampleRate, blockSize);
+        pool.setSample(sample.data(), sample.size() / channels, channels, 1.0f);
+
+        std::vector<double> costs;
+        double activeSum = 0;
+        for (int b=0; b<numBlocks; b++) {
+            clock::time_point start = clock::now();
+            while (pool.getNumActive() < count)
+                pool.trigger(random(0.5f, 2.0f), random(-1, 1), 0.1f);
+            std::fill(left.begin(), left.end(), 0.0f);
+            std::fill(right.begin(), right.end(), 0.0f);
+            pool.render(left.data(), right.data(), blockSize);
+            costs.push_back(std::chrono::duration<double>(clock::now() - start).count());
+            activeSum += pool.getNumActive();
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "%d voices", count);
+        report(label, costs, activeSum);
+    }
+
+    // random triggers at a few hundred a second into a 64 voice pool, with
+    // random priorities so stealing and rejection both get exercised
+    const float rates[] = { 100, 500, 2000 };
+    for (size_t r=0; r<sizeof(rates) / sizeof(rates[0]); r++) {
+        VoicePool pool;
+        pool.setup(64, sampleRate, blockSize);
+        pool.setSample(sample.data(), sample.size() / channels, channels, 1.0f);
+        float perBlock = rates[r] * blockSize / sampleRate;
+
+        std::vector<double> costs;
+        double activeSum = 0;
+        float owed = 0;
+        for (int b=0; b<numBlocks; b++) {
+            clock::time_point start = clock::now();
+            for (owed += perBlock; owed >= 1; owed -= 1)
+                pool.trigger(random(0.5f, 2.0f), random(-1, 1), 0.1f, random(0, 1));
+            std::fill(left.begin(), left.end(), 0.0f);
+            std::fill(right.begin(), right.end(), 0.0f);
+            pool.render(left.data(), right.data(), blockSize);
+            costs.push_back(std::chrono::duration<double>(clock::now() - start).count());
+            activeSum += pool.getNumActive();
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "%.0f triggers/s", rates[r]);
+        report(label, costs, activeSum);
+        printf("%18s %llu stolen, %llu rejected\n", "", (unsigned long long)pool.getNumStolen(), (unsigned long long)pool.getNumRejected());
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include "AudioAnalyzer.h"
+
+//--------------------------------------------------------------
+AudioAnalyzer::AudioAnalyzer() {
+    track = NULL;
+    input = NULL;
+    latestLatency = -1;
+    reportedFrame = 0;
+    reportedMicros = 0;
+    playing = false;
+    paused = false;
+    droppedFrames = 0;
+    nextHop = 0;
+    sequence = 0;
+
+    parameters.setName("audio analysis");
+    parameters.add(fftSize.set("fft size", 512, RealFft::minSize, RealFft::maxSize));
+    parameters.add(hopSize.set("hop size", 256, 32, 4096));
+    parameters.add(window.set("window", REAL_FFT_WINDOW_HANN, REAL_FFT_WINDOW_RECTANGULAR, REAL_FFT_WINDOW_BLACKMAN_HARRIS));
+    parameters.add(windowName.set("window name", getWindowName(REAL_FFT_WINDOW_HANN)));
+    parameters.add(numBands.set("bands", 16, FilterBank::minBands, FilterBank::maxBands));
+    parameters.add(melScale.set("mel scale", true));
+    parameters.add(inputLatency.set("input latency", 0, 0, 50));
+}
+
+//--------------------------------------------------------------
+AudioAnalyzer::~AudioAnalyzer() {
+    stop();
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::setup(const PcmTrack& _track, int _fftSize, int _hopSize, RealFftWindow _window) {
+    stop();
+
+    track = &_track;
+    fftSize.set(_fftSize);
+    hopSize.set(_hopSize);
+    window.set(_window);
+    windowName.set(getWindowName(_window));
+    fftSize.addListener(this, &AudioAnalyzer::setFftSize);
+    hopSize.addListener(this, &AudioAnalyzer::setHopSize);
+    window.addListener(this, &AudioAnalyzer::setWindow);
+    numBands.addListener(this, &AudioAnalyzer::setNumBands);
+    melScale.addListener(this, &AudioAnalyzer::setMelScale);
+
+    restart();
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::setSource(const PcmTrack& _track) {
+    track = &_track;
+    input = NULL;
+    restart();
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::setSource(LiveAudioInput& _input) {
+    track = NULL;
+    input = &_input;
+    restart();
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::restart() {
+    if (track == NULL && input == NULL)
+        return;
+
+    bool wasRunning = isThreadRunning();
+    stop();
+
+    AudioFeatureConfig config;
+    config.sampleRate = input ? input->getSampleRate() : track->getSampleRate();
+    config.fftSize = fftSize.get();
+    config.hopSize = hopSize.get();
+    config.window = (RealFftWindow)window.get();
+    config.numBands = numBands.get();
+    config.scale = melScale.get() ? FILTER_BANK_MEL : FILTER_BANK_LOG;
+    extractor.setup(config);
+    samples.assign(getFftSize(), 0);
+
+    // a second of frames, far more than update() ever lets pile up
+    frames.setup(ofNextPow2(config.sampleRate / getHopSize() + 1));
+    droppedFrames = 0;
+    sequence = 0;
+    nextHop = 0;
+
+    if (wasRunning)
+        start();
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::start() {
+    if (isThreadRunning())
+        return;
+    if (input == NULL && (track == NULL || !track->isLoaded()))
+        return;
+    startThread();
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::stop() {
+    if (isThreadRunning())
+        waitForThread(true);
+}
+
+//--------------------------------------------------------------
+string AudioAnalyzer::getWindowName(int _window) {
+    switch (_window) {
+        case REAL_FFT_WINDOW_RECTANGULAR:		return "rectangular";
+        case REAL_FFT_WINDOW_HANN:				return "hann";
+        case REAL_FFT_WINDOW_HAMMING:			return "hamming";
+        case REAL_FFT_WINDOW_BLACKMAN_HARRIS:	return "blackman harris";
+        default: return "unknown";
+    }
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::setPlaybackPosition(int _positionMS, bool _isPlaying) {
+    if (track == NULL)
+        return;
+    reportedFrame.store((int64_t)_positionMS * track->getSampleRate() / 1000);
+    reportedMicros.store(ofGetElapsedTimeMicros());
+    playing.store(_isPlaying);
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::setPaused(bool _paused) {
+    paused.store(_paused);
+    // and whatever the thread finished before it saw the flag
+    if (_paused)
+        frames.clear();
+}
+
+//--------------------------------------------------------------
+int64_t AudioAnalyzer::estimatePlayhead() const {
+    int64_t position = reportedFrame.load();
+    if (playing.load()) {
+        uint64_t elapsed = ofGetElapsedTimeMicros() - reportedMicros.load();
+        position += (int64_t)(elapsed * track->getSampleRate() / 1000000);
+    }
+    return position;
+}
+
+//--------------------------------------------------------------
+bool AudioAnalyzer::popFrame(AudioFrame& _frame) {
+    if (frames.pop(_frame)) {
+        if (_frame.capturedMicros > 0)
+            latestLatency = (_frame.analyzedMicros - _frame.capturedMicros) / 1000.0f;
+        return true;
+    }
+    // drained, show the latency of the last frame
+    if (latestLatency >= 0) {
+        inputLatency.set(latestLatency);
+        latestLatency = -1;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::threadedFunction() {
+    if (input)
+        followInput();
+    else
+        followTrack();
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::followTrack() {
+    int hop = getHopSize();
+    nextHop = estimatePlayhead();
+
+    while (isThreadRunning()) {
+        int64_t playhead = estimatePlayhead();
+        if (paused.load()) {
+            nextHop = playhead;
+            sleep(1);
+            continue;
+        }
+
+        // the player looped or was seeked, or we fell hopelessly behind:
+        // continue from the playhead instead of replaying the gap
+        if (playhead < nextHop - 4 * hop || playhead > nextHop + 32 * hop)
+            nextHop = playhead;
+
+        while (nextHop <= playhead && isThreadRunning()) {
+            analyze(nextHop);
+            nextHop += hop;
+        }
+        sleep(1);
+    }
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::followInput() {
+    int size = getFftSize();
+    int hop = getHopSize();
+    int collected = 0;		// new samples at the end of the window
+    int64_t endFrame = 0;
+    input->clear();
+    std::fill(samples.begin(), samples.end(), 0.0f);
+
+    while (isThreadRunning()) {
+        // keep the latency down when we fell behind: skip to the last window
+        if (input->getNumAvailable() > (size_t)(size + 4 * hop))
+            input->discard(input->getNumAvailable() - size);
+
+        collected += input->read(samples.data() + size - hop + collected, hop - collected);
+        if (collected < hop) {
+            sleep(1);
+            continue;
+        }
+        endFrame += hop;
+        frame.capturedMicros = input->getCaptureMicros();
+        extractor.process(samples.data(), frame);
+        publish(endFrame);
+
+        // slide the window on by a hop
+        std::copy(samples.begin() + hop, samples.end(), samples.begin());
+        collected = 0;
+    }
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::analyze(int64_t _endFrame) {
+    int size = getFftSize();
+    track->readMono(_endFrame - size, size, samples.data());
+    frame.capturedMicros = 0;
+    extractor.process(samples.data(), frame);
+    publish(_endFrame);
+}
+
+//--------------------------------------------------------------
+void AudioAnalyzer::publish(int64_t _endFrame) {
+    frame.sequence = sequence++;
+    frame.time = (double)_endFrame / getConfig().sampleRate;
+    frame.analyzedMicros = ofGetElapsedTimeMicros();
+    if (!frames.push(frame))
+        droppedFrames++;
+}
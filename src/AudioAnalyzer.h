@@ -0,0 +1,96 @@
+#pragma once
+
+#include "ofMain.h"
+#include "PcmTrack.h"
+#include "LiveAudioInput.h"
+#include "SpscRing.h"
+#include "FeatureExtractor.h"
+
+// Runs the spectrum analysis on its own thread, at a fixed hop through the
+// decoded PCM of the track that is playing, independent of the frame rate.
+// The render thread only reports the player position and drains finished
+// frames; the two sides share nothing but atomics and a lock free ring.
+// With a live input as the source it instead analyses each hop as soon as
+// the sound card has delivered it.
+// FFT size, hop and window are parameters; changing one restarts the thread.
+
+class AudioAnalyzer : public ofThread {
+public:
+    AudioAnalyzer();
+    ~AudioAnalyzer();
+
+    void	setup(const PcmTrack& _track, int _fftSize = 512, int _hopSize = 256, RealFftWindow _window = REAL_FFT_WINDOW_HANN);
+    void	start();
+    void	stop();
+
+    // switch what is analysed, keeping the settings
+    void	setSource(const PcmTrack& _track);
+    void	setSource(LiveAudioInput& _input);
+    bool	isLive() const		{ return input != NULL; }
+    
+    ofParameterGroup	parameters;
+
+    // render thread
+    void	setPlaybackPosition(int _positionMS, bool _isPlaying);
+    // every frame: while paused the track isn't analysed at all and the
+    // frames still queued are dropped, for when the features come from a
+    // FeatureCache instead; on resuming it goes on from the playhead
+    void	setPaused(bool _paused);
+    bool	popFrame(AudioFrame& _frame);
+
+    // the configuration and band layout only change in restart(), on the
+    // render thread
+    const AudioFeatureConfig&	getConfig() const	{ return extractor.getConfig(); }
+    int		getFftSize() const				{ return getConfig().fftSize; }
+    int		getHopSize() const				{ return getConfig().hopSize; }
+    float	getHopDuration() const			{ return extractor.getHopDuration(); }
+    uint64_t	getNumDroppedFrames() const	{ return droppedFrames.load(); }
+
+    int				getNumBands() const				{ return extractor.getFilterBank().getNumBands(); }
+    const string&	getBandName(int _band) const	{ return extractor.getFilterBank().getBandName(_band); }
+    int				findBand(float _hz) const		{ return extractor.getFilterBank().findBand(_hz); }
+
+protected:
+    void	threadedFunction();
+
+    void	followTrack();
+    void	followInput();
+    int64_t	estimatePlayhead() const;
+    void	analyze(int64_t _endFrame);
+    void	publish(int64_t _endFrame);
+    void	restart();
+
+    ofParameter<int>	fftSize;
+    void				setFftSize(int& _value)		{ restart(); }
+    ofParameter<int>	hopSize;
+    void				setHopSize(int& _value)		{ restart(); }
+    ofParameter<int>	window;
+    void				setWindow(int& _value)		{ windowName.set(getWindowName(_value)); restart(); }
+    ofParameter<string>	windowName;
+    static string		getWindowName(int _window);
+    ofParameter<int>	numBands;
+    void				setNumBands(int& _value)	{ restart(); }
+    ofParameter<bool>	melScale;
+    void				setMelScale(bool& _value)	{ restart(); }
+    ofParameter<float>	inputLatency;	// ms from capture to feature, live input only
+    float				latestLatency;
+
+    const PcmTrack*		track;
+    LiveAudioInput*		input;
+
+    // written by the render thread, extrapolated by the analysis thread
+    std::atomic<int64_t>	reportedFrame;
+    std::atomic<uint64_t>	reportedMicros;
+    std::atomic<bool>		playing;
+    std::atomic<bool>		paused;
+
+    SpscRing<AudioFrame>	frames;
+    std::atomic<uint64_t>	droppedFrames;
+
+    // analysis thread only
+    int64_t				nextHop;
+    uint64_t			sequence;
+    FeatureExtractor	extractor;
+    vector<float>		samples;
+    AudioFrame			frame;
+};
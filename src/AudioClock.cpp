@@ -0,0 +1,124 @@
+#include "AudioClock.h"
+
+namespace {
+    // bandwidth of the delay locked loop, low enough to smooth the callback
+    // jitter out, high enough to settle within a couple of seconds
+    const double	loopBandwidth = 1.0;
+}
+
+//--------------------------------------------------------------
+AudioClock::AudioClock() {
+    sampleRate = 44100;
+    numBuffers = 1;
+    stampSequence = 0;
+    stampFrame = 0;
+    stampTime = 0;
+    stampPeriod = 0;
+    stampFrames = 0;
+    stampMedia = 0;
+    stampPlaying = false;
+    framesPlayed = 0;
+    loopFrames = 0;
+    loopTime = 0;
+    loopPeriod = 0;
+    loopB = 0;
+    loopC = 0;
+
+    parameters.setName("audio clock");
+    parameters.add(outputLatency.set("output latency ms", 0, 0, 500));
+    parameters.add(outputTrim.set("output trim ms", 0, -100, 200));
+    parameters.add(displayLatency.set("display latency ms", 33, 0, 200));
+    parameters.add(offset.set("offset ms", 0, -500, 500));
+}
+
+//--------------------------------------------------------------
+void AudioClock::setup(int _sampleRate, int _bufferSize, int _numBuffers) {
+    sampleRate = _sampleRate;
+    numBuffers = max(1, _numBuffers);
+    outputLatency.set(1000.0f * _bufferSize * numBuffers / sampleRate);
+}
+
+//--------------------------------------------------------------
+void AudioClock::tick(int _numFrames, double _mediaSeconds, bool _mediaPlaying) {
+    double now = ofGetElapsedTimeMicros() * 1e-6;
+
+    // lock on the first block, and again after a dropout or a new block size
+    double error = now - loopTime;
+    if (_numFrames != loopFrames || fabs(error) > 4 * loopPeriod) {
+        loopFrames = _numFrames;
+        loopPeriod = (double)_numFrames / sampleRate;
+        double omega = 2 * PI * loopBandwidth * loopPeriod;
+        loopB = sqrt(2.0) * omega;
+        loopC = omega * omega;
+        loopTime = now;
+        error = 0;
+    }
+    double time = loopTime;
+    loopTime += loopB * error + loopPeriod;
+    loopPeriod += loopC * error;
+
+    stampSequence.fetch_add(1, std::memory_order_acq_rel);
+    stampFrame.store(framesPlayed, std::memory_order_relaxed);
+    stampTime.store(time, std::memory_order_relaxed);
+    stampPeriod.store(loopTime - time, std::memory_order_relaxed);
+    stampFrames.store(_numFrames, std::memory_order_relaxed);
+    stampMedia.store(_mediaSeconds, std::memory_order_relaxed);
+    stampPlaying.store(_mediaPlaying, std::memory_order_relaxed);
+    stampSequence.fetch_add(1, std::memory_order_release);
+
+    framesPlayed += _numFrames;
+}
+
+//--------------------------------------------------------------
+AudioClock::Stamp AudioClock::readStamp() const {
+    Stamp stamp;
+    uint32_t sequence;
+    do {
+        sequence = stampSequence.load(std::memory_order_acquire);
+        stamp.frame = stampFrame.load(std::memory_order_relaxed);
+        stamp.time = stampTime.load(std::memory_order_relaxed);
+        stamp.period = stampPeriod.load(std::memory_order_relaxed);
+        stamp.numFrames = stampFrames.load(std::memory_order_relaxed);
+        stamp.mediaSeconds = stampMedia.load(std::memory_order_relaxed);
+        stamp.mediaPlaying = stampPlaying.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) || sequence != stampSequence.load(std::memory_order_acquire));
+    return stamp;
+}
+
+//--------------------------------------------------------------
+void AudioClock::update() {
+    // the device may not give the block size asked for, the queue is as
+    // many of the blocks it does ask for
+    int frames = stampFrames.load();
+    if (frames > 0)
+        outputLatency.set(1000.0f * frames * numBuffers / sampleRate);
+    offset.set(getOffset() * 1000.0f);
+}
+
+//--------------------------------------------------------------
+double AudioClock::extrapolate(const Stamp& _stamp) const {
+    // no further than a couple of blocks past the stamp, if the callbacks
+    // stop the clock stops with them
+    double now = ofGetElapsedTimeMicros() * 1e-6;
+    double elapsed = ofClamp(now - _stamp.time, 0, 2 * _stamp.period);
+    double framesPerSecond = _stamp.period > 0 ? _stamp.numFrames / _stamp.period : sampleRate;
+    return _stamp.frame + (elapsed + getOffset()) * framesPerSecond;
+}
+
+//--------------------------------------------------------------
+double AudioClock::getPresentedFrame() const {
+    if (!isRunning())
+        return ofGetElapsedTimeMicros() * 1e-6 * sampleRate;
+    return extrapolate(readStamp());
+}
+
+//--------------------------------------------------------------
+double AudioClock::getMediaSeconds() const {
+    if (!isRunning())
+        return 0;
+    Stamp stamp = readStamp();
+    if (!stamp.mediaPlaying)
+        return stamp.mediaSeconds;
+    return stamp.mediaSeconds + (extrapolate(stamp) - stamp.frame) / sampleRate;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ofMain.h"
+
+// The time of the sound card, so visuals can follow what is heard instead of
+// what update() happens to see. The output callback stamps every block with
+// the frames played so far and the track position it starts at; the stamp
+// times go through a delay locked loop so the clock runs as smoothly as the
+// device's sample clock rather than jittering with the callback scheduling.
+// The render thread extrapolates from the latest stamp to the moment the
+// frame being drawn reaches the projector: forward by the display latency,
+// back by the output latency (the blocks queued between the callback and the
+// speakers, measured from the blocks the device actually asks for, plus a
+// trim for the converters and amplifiers the driver does not report).
+
+class AudioClock {
+public:
+    AudioClock();
+
+    void	setup(int _sampleRate, int _bufferSize, int _numBuffers);
+
+    ofParameterGroup	parameters;
+
+    // audio thread, at the start of every output callback with the track
+    // position about to be rendered
+    void	tick(int _numFrames, double _mediaSeconds, bool _mediaPlaying);
+
+    // render thread
+    void	update();					// measures the output latency, publishes it
+    bool	isRunning() const			{ return stampSequence.load() > 0; }
+    // output frame heard when the current frame is presented
+    double	getPresentedFrame() const;
+    double	getPresentedSeconds() const	{ return getPresentedFrame() / sampleRate; }
+    // track position heard when the current frame is presented
+    double	getMediaSeconds() const;
+    // seconds from update() to the pixels being seen, minus the seconds from
+    // the callback to the sound being heard
+    float	getOffset() const			{ return (displayLatency - outputLatency - outputTrim) / 1000.0f; }
+
+protected:
+    struct Stamp {
+        int64_t		frame;			// frames played before this block
+        double		time;			// filtered callback time of this block
+        double		period;			// filtered seconds per block
+        int			numFrames;
+        double		mediaSeconds;
+        bool		mediaPlaying;
+    };
+
+    Stamp	readStamp() const;
+    double	extrapolate(const Stamp& _stamp) const;
+
+    ofParameter<float>	outputLatency;	// ms, measured
+    ofParameter<float>	outputTrim;		// ms, tuned
+    ofParameter<float>	displayLatency;	// ms, tuned
+    ofParameter<float>	offset;			// ms, what the visuals are shifted by
+
+    int		sampleRate;
+    int		numBuffers;
+
+    // seqlock, odd while the audio thread writes the stamp
+    std::atomic<uint32_t>	stampSequence;
+    std::atomic<int64_t>	stampFrame;
+    std::atomic<double>		stampTime;
+    std::atomic<double>		stampPeriod;
+    std::atomic<int>		stampFrames;
+    std::atomic<double>		stampMedia;
+    std::atomic<bool>		stampPlaying;
+
+    // audio thread only, the loop filter
+    int64_t		framesPlayed;
+    int			loopFrames;		// block size the filter is locked to
+    double		loopTime;		// filtered time of the next callback
+    double		loopPeriod;
+    double		loopB;
+    double		loopC;
+};
@@ -0,0 +1,61 @@
+#include "BandEnvelopes.h"
+
+#include <algorithm>
+#include <cmath>
+
+//--------------------------------------------------------------
+BandEnvelopes::BandEnvelopes() {
+    coefficientDt = 0;
+    dirty = true;
+}
+
+//--------------------------------------------------------------
+void BandEnvelopes::setup(int _numBands, float _attack, float _release) {
+    values.assign(_numBands, 0);
+    attack.assign(_numBands, _attack);
+    release.assign(_numBands, _release);
+    attackCoefficient.assign(_numBands, 1);
+    releaseCoefficient.assign(_numBands, 1);
+    dirty = true;
+}
+
+//--------------------------------------------------------------
+void BandEnvelopes::reset() {
+    std::fill(values.begin(), values.end(), 0.0f);
+}
+
+//--------------------------------------------------------------
+void BandEnvelopes::setAttack(float _seconds) {
+    std::fill(attack.begin(), attack.end(), _seconds);
+    dirty = true;
+}
+
+//--------------------------------------------------------------
+void BandEnvelopes::setRelease(float _seconds) {
+    std::fill(release.begin(), release.end(), _seconds);
+    dirty = true;
+}
+
+//--------------------------------------------------------------
+void BandEnvelopes::update(const float* _targets, float _dt) {
+    int numBands = values.size();
+
+    // one pole coefficients for this step, only recomputed when the step or
+    // the times change, which for a fixed hop is never
+    if (dirty || _dt != coefficientDt) {
+        for (int b=0; b<numBands; b++) {
+            attackCoefficient[b] = attack[b] > 0 ? 1.0f - expf(-_dt / attack[b]) : 1.0f;
+            releaseCoefficient[b] = release[b] > 0 ? 1.0f - expf(-_dt / release[b]) : 1.0f;
+        }
+        coefficientDt = _dt;
+        dirty = false;
+    }
+
+    float* v = values.data();
+    const float* a = attackCoefficient.data();
+    const float* r = releaseCoefficient.data();
+    for (int b=0; b<numBands; b++) {
+        float difference = _targets[b] - v[b];
+        v[b] += difference * (difference > 0 ? a[b] : r[b]);
+    }
+}
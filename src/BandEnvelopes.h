@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+// Attack / release envelope followers, one per band, kept as plain arrays so
+// a whole set updates in one loop. The coefficients come from the time step
+// passed to update(), so the response in seconds is the same whatever rate the
+// envelopes are driven at.
+
+class BandEnvelopes {
+public:
+    BandEnvelopes();
+
+    void	setup(int _numBands, float _attack = 0.01, float _release = 0.55);
+    void	reset();
+
+    int		getNumBands() const			{ return values.size(); }
+
+    // seconds to close ~63% of the gap to a rising / falling input
+    void	setAttack(float _seconds);
+    void	setRelease(float _seconds);
+    void	setAttack(int _band, float _seconds)	{ attack[_band] = _seconds; dirty = true; }
+    void	setRelease(int _band, float _seconds)	{ release[_band] = _seconds; dirty = true; }
+
+    void	update(const float* _targets, float _dt);
+
+    float			get(int _band) const	{ return values[_band]; }
+    const float*	getValues() const		{ return values.data(); }
+
+private:
+    std::vector<float>	values;
+    std::vector<float>	attack;
+    std::vector<float>	release;
+    std::vector<float>	attackCoefficient;
+    std::vector<float>	releaseCoefficient;
+    float				coefficientDt;
+    bool				dirty;
+};
@@ -0,0 +1,98 @@
+#include "BlobForces.h"
+
+namespace {
+    bool isLarger(const Blob* _a, const Blob* _b) {
+        return _a->area > _b->area;
+    }
+}
+
+//--------------------------------------------------------------
+BlobForces::BlobForces() {
+    depthWidth = 0;
+    depthHeight = 0;
+    lastMicros = 0;
+
+    parameters.setName("blobs");
+    parameters.add(minArea.set("min area", 1500, 100, 20000));
+    parameters.add(maxDistance.set("max distance", 80, 10, 300));
+    parameters.add(minFrames.set("min frames", 5, 1, 30));
+    parameters.add(depthStep.set("depth step mm", 400, 0, 2000));
+    parameters.add(densityStrength.set("density", 1, 0, 5));
+    parameters.add(velocityStrength.set("velocity", 1, 0, 10));
+    parameters.add(radiusScale.set("radius", 0.5, 0.1, 2));
+    parameters.add(numBlobs.set("count", 0, 0, 64));
+    parameters.add(trackMs.set("track ms", 0, 0, 10));
+}
+
+//--------------------------------------------------------------
+void BlobForces::setup(int _depthWidth, int _depthHeight, int _flowWidth, int _flowHeight) {
+    depthWidth = _depthWidth;
+    depthHeight = _depthHeight;
+    tracker.setup(depthWidth, depthHeight);
+    for (int i=0; i<maxBlobs; i++) {
+        forces[i * 2].setup(_flowWidth, _flowHeight, flowTools::FT_DENSITY, true);
+        forces[i * 2].setName("blob " + ofToString(i) + " density");
+        forces[i * 2 + 1].setup(_flowWidth, _flowHeight, flowTools::FT_VELOCITY, true);
+        forces[i * 2 + 1].setName("blob " + ofToString(i) + " velocity");
+    }
+    largest.reserve(64);
+}
+
+//--------------------------------------------------------------
+void BlobForces::reset() {
+    tracker.reset();
+    lastMicros = 0;
+    for (int i=0; i<maxBlobs * 2; i++)
+        forces[i].reset();
+}
+
+//--------------------------------------------------------------
+void BlobForces::track(const ofPixels& _mask, const DepthFrame& _frame, bool _mirrored) {
+    if ((int)_mask.getWidth() != depthWidth || (int)_mask.getHeight() != depthHeight ||
+        (int)_frame.rawDepth.getWidth() != depthWidth || (int)_frame.rawDepth.getHeight() != depthHeight)
+        return;
+
+    // the velocities are per second of the camera's time, not the app's
+    float deltaTime = lastMicros != 0 && _frame.capturedMicros > lastMicros ? (_frame.capturedMicros - lastMicros) / 1000000.0f : 0.0f;
+    lastMicros = _frame.capturedMicros;
+
+    uint64_t start = ofGetElapsedTimeMicros();
+    tracker.minArea = minArea;
+    tracker.maxDistance = maxDistance;
+    tracker.minFrames = minFrames;
+    tracker.depthStep = depthStep;
+    tracker.process(_mask.getData(), _frame.rawDepth.getData(), _mirrored, deltaTime);
+    trackMs.set((ofGetElapsedTimeMicros() - start) / 1000.0f);
+    numBlobs.set(tracker.getBlobs().size());
+}
+
+//--------------------------------------------------------------
+void BlobForces::update() {
+    const vector<Blob>& blobs = tracker.getBlobs();
+    largest.clear();
+    for (size_t b=0; b<blobs.size(); b++)
+        largest.push_back(&blobs[b]);
+    sort(largest.begin(), largest.end(), isLarger);
+
+    for (int i=0; i<maxBlobs && i<(int)largest.size(); i++) {
+        const Blob& blob = *largest[i];
+        ofVec2f position(blob.x / depthWidth, blob.y / depthHeight);
+        float size = sqrtf((float)blob.area) / depthWidth;
+
+        // the same colour for the same dancer
+        ofColor color = ofColor::fromHsb((blob.id * 47) % 256, 200, 255);
+        flowTools::ftDrawForce& density = forces[i * 2];
+        density.setStrength(densityStrength);
+        density.setRadius(size * radiusScale);
+        density.setForce(ofVec4f(color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, 1));
+        density.applyForce(position);
+
+        flowTools::ftDrawForce& velocity = forces[i * 2 + 1];
+        velocity.setStrength(velocityStrength);
+        velocity.setRadius(size * radiusScale);
+        velocity.setForce(ofVec2f(blob.vx / depthWidth, blob.vy / depthHeight));
+        velocity.applyForce(position);
+    }
+    for (int i=0; i<maxBlobs * 2; i++)
+        forces[i].update();
+}
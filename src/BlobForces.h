@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxFlowTools.h"
+#include "BlobTracker.h"
+#include "DepthSource.h"
+
+// The dancers as force emitters: the foreground mask goes through a
+// BlobTracker whenever there is a new depth frame, and each of the largest
+// maxBlobs blobs, once it has lasted min frames, gets a density force, in a
+// colour of its own that stays with its id, and a velocity force pushing
+// the way it moves, both sized to the blob. The interface is
+// ftDrawMouseForces', so ofApp feeds the fluid from both the same way.
+// Render thread only.
+
+class BlobForces {
+public:
+    static const int	maxBlobs = 8;
+
+    BlobForces();
+
+    void	setup(int _depthWidth, int _depthHeight, int _flowWidth, int _flowHeight);
+    // a new mask and the depth frame it came from
+    void	track(const ofPixels& _mask, const DepthFrame& _frame, bool _mirrored);
+    // every frame
+    void	update();
+    void	reset();
+
+    ofParameterGroup	parameters;
+
+    const vector<Blob>&	getBlobs() const		{ return tracker.getBlobs(); }
+
+    int					getNumForces() const	{ return maxBlobs * 2; }
+    bool				didChange(int _index)	{ return forces[_index].didChange(); }
+    flowTools::ftDrawForceType	getType(int _index)		{ return forces[_index].getType(); }
+    ofTexture&			getTextureReference(int _index)	{ return forces[_index].getTextureReference(); }
+    float				getStrength(int _index)	{ return forces[_index].getStrength(); }
+
+protected:
+    ofParameter<int>	minArea;
+    ofParameter<float>	maxDistance;
+    ofParameter<int>	minFrames;		// a new blob's, before it is a force
+    ofParameter<float>	depthStep;
+    ofParameter<float>	densityStrength;
+    ofParameter<float>	velocityStrength;
+    ofParameter<float>	radiusScale;	// of the blob's size
+    ofParameter<int>	numBlobs;		// readouts
+    ofParameter<float>	trackMs;
+
+    BlobTracker		tracker;
+    int				depthWidth;
+    int				depthHeight;
+    uint64_t		lastMicros;		// when the last frame tracked was captured
+    flowTools::ftDrawForce	forces[maxBlobs * 2];	// density and velocity for each blob
+    vector<const Blob*>	largest;
+};
@@ -0,0 +1,499 @@
+#include "BlobTracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+//--------------------------------------------------------------
+BlobTracker::BlobTracker() {
+    width = 0;
+    height = 0;
+    nextId = 1;
+    minArea = 1500;
+    maxDistance = 80;
+    sizeGate = 0.5f;
+    minFrames = 5;
+    maxMissing = 10;
+    maxMerged = 150;
+    smoothing = 0.6f;
+    depthStep = 400;
+}
+
+//--------------------------------------------------------------
+void BlobTracker::setup(int _width, int _height) {
+    width = _width;
+    height = _height;
+    rowStart.assign(height + 1, 0);
+    runs.reserve(width * 4);
+    reset();
+}
+
+//--------------------------------------------------------------
+void BlobTracker::reset() {
+    tracks.clear();
+    blobs.clear();
+    nextId = 1;
+}
+
+//--------------------------------------------------------------
+int BlobTracker::find(int _run) {
+    // path halving
+    while (runs[_run].parent != _run) {
+        runs[_run].parent = runs[runs[_run].parent].parent;
+        _run = runs[_run].parent;
+    }
+    return _run;
+}
+
+//--------------------------------------------------------------
+void BlobTracker::unite(int _a, int _b) {
+    int a = find(_a);
+    int b = find(_b);
+    // the earlier run stays the root
+    if (a < b)
+        runs[b].parent = a;
+    else if (b < a)
+        runs[a].parent = b;
+}
+
+//--------------------------------------------------------------
+void BlobTracker::addRuns(int _y, int _x0, int _x1, const uint16_t* _depth) {
+    Run run;
+    run.y = _y;
+    run.x0 = _x0;
+    run.sumDepth = 0;
+    run.readings = 0;
+    int previous = 0;
+    for (int x=_x0; x<_x1; x++) {
+        int d = _depth[x];
+        if (d == 0)
+            continue;
+        if (depthStep > 0 && previous != 0 && abs(d - previous) > depthStep) {
+            run.x1 = x;
+            run.parent = runs.size();
+            runs.push_back(run);
+            run.x0 = x;
+            run.sumDepth = 0;
+            run.readings = 0;
+        }
+        run.sumDepth += d;
+        run.readings++;
+        previous = d;
+    }
+    run.x1 = _x1;
+    run.parent = runs.size();
+    runs.push_back(run);
+}
+
+//--------------------------------------------------------------
+bool BlobTracker::touches(const Run& _above, const Run& _below, const uint16_t* _depthAbove, const uint16_t* _depthBelow) const {
+    if (_above.x1 < _below.x0 || _below.x1 < _above.x0)
+        return false;
+    if (depthStep <= 0 || _above.readings == 0 || _below.readings == 0)
+        return true;
+    // a reading and one beside or above it close enough; usually the first
+    int x0 = std::max(_above.x0, _below.x0 - 1);
+    int x1 = std::min(_above.x1, _below.x1 + 1);
+    for (int x=x0; x<x1; x++) {
+        int a = _depthAbove[x];
+        if (a == 0)
+            continue;
+        int from = std::max(x - 1, _below.x0), to = std::min(x + 2, _below.x1);
+        for (int b=from; b<to; b++) {
+            if (_depthBelow[b] != 0 && abs(_depthBelow[b] - a) <= depthStep)
+                return true;
+        }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+void BlobTracker::label(const uint8_t* _mask, const uint16_t* _depth) {
+    const uint64_t full = ~(uint64_t)0;
+    runs.clear();
+    for (int y=0; y<height; y++) {
+        rowStart[y] = runs.size();
+        const uint8_t* r = _mask + y * width;
+        const uint16_t* d = _depth + y * width;
+        int x = 0;
+        while (x < width) {
+            // through the background a word at a time, then to the run's start
+            uint64_t word;
+            while (x + 8 <= width) {
+                memcpy(&word, r + x, 8);
+                if (word != 0)
+                    break;
+                x += 8;
+            }
+            while (x < width && r[x] == 0)
+                x++;
+            if (x == width)
+                break;
+
+            // and through the run the same way
+            int start = x;
+            while (x + 8 <= width) {
+                memcpy(&word, r + x, 8);
+                if (word != full)
+                    break;
+                x += 8;
+            }
+            while (x < width && r[x] != 0)
+                x++;
+            addRuns(y, start, x, d);
+        }
+
+        // join with the runs above that touch, corners included
+        if (y > 0) {
+            int a = rowStart[y - 1], aEnd = rowStart[y];
+            int b = rowStart[y], bEnd = runs.size();
+            while (a < aEnd && b < bEnd) {
+                if (touches(runs[a], runs[b], d - width, d))
+                    unite(a, b);
+                if (runs[a].x1 < runs[b].x1)
+                    a++;
+                else
+                    b++;
+            }
+        }
+    }
+    rowStart[height] = runs.size();
+}
+
+//--------------------------------------------------------------
+void BlobTracker::measure() {
+    rootIndex.assign(runs.size(), -1);
+    candidates.clear();
+    for (size_t i=0; i<runs.size(); i++) {
+        const Run& run = runs[i];
+        int root = find(i);
+        if (rootIndex[root] < 0) {
+            rootIndex[root] = candidates.size();
+            Stats s;
+            s.sumX = s.sumY = s.sumDepth = 0;
+            s.area = s.readings = 0;
+            s.x0 = run.x0;
+            s.x1 = run.x1;
+            s.y0 = run.y;
+            s.y1 = run.y + 1;
+            candidates.push_back(s);
+        }
+        Stats& s = candidates[rootIndex[root]];
+        int n = run.x1 - run.x0;
+        s.area += n;
+        s.sumX += (int64_t)n * (run.x0 + run.x1 - 1) / 2;
+        s.sumY += (int64_t)n * run.y;
+        s.x0 = std::min(s.x0, run.x0);
+        s.x1 = std::max(s.x1, run.x1);
+        s.y1 = run.y + 1;
+        s.sumDepth += run.sumDepth;
+        s.readings += run.readings;
+    }
+}
+
+//--------------------------------------------------------------
+float BlobTracker::gate(const Track& _track, const Stats& _stats) const {
+    // a large blob's centroid swings further with its limbs, and a lost
+    // one may turn up further from where it was heading
+    float size = sqrtf((float)std::max(_track.blob.area, _stats.area));
+    return (maxDistance + sizeGate * size) * (1 + 0.5f * _track.missing);
+}
+
+//--------------------------------------------------------------
+void BlobTracker::mergeInto(int _track, int _host) {
+    Track& track = tracks[_track];
+    jumped[_host] = 1;
+    // a blob too new for an id is forgotten, it was likely a piece of the other
+    if (track.blob.id == 0) {
+        track.missing = maxMissing + 1;
+        return;
+    }
+    int id = tracks[_host].blob.id;
+    for (size_t t=0; t<tracks.size(); t++) {
+        if (tracks[t].host == track.blob.id)
+            tracks[t].host = id;
+    }
+    track.host = id;
+}
+
+//--------------------------------------------------------------
+bool BlobTracker::adopt(int _candidate) {
+    const Stats& s = candidates[_candidate];
+    float x = (float)s.sumX / s.area;
+    float y = (float)s.sumY / s.area;
+
+    // the blob it came out of: one with an id, matched this frame, whose
+    // box last frame, grown by the gate's share of its size, it overlaps
+    int host = -1;
+    float nearest = 0;
+    for (size_t t=0; t<tracks.size(); t++) {
+        if (assigned[t] < 0 || tracks[t].blob.id == 0)
+            continue;
+        const Blob& b = tracks[t].blob;
+        float margin = sizeGate * sqrtf((float)b.area);
+        if (s.x1 < b.x0 - margin || s.x0 > b.x1 + margin || s.y1 < b.y0 - margin || s.y0 > b.y1 + margin)
+            continue;
+        float d2 = (b.x - x) * (b.x - x) + (b.y - y) * (b.y - y);
+        if (host < 0 || d2 < nearest) {
+            host = t;
+            nearest = d2;
+        }
+    }
+
+    if (host >= 0) {
+        // a dancer stepping out of a merge: the nearest of those who went in,
+        // when the piece is a good part of one
+        int id = tracks[host].blob.id;
+        int child = -1;
+        for (size_t t=0; id != 0 && t<tracks.size(); t++) {
+            const Blob& b = tracks[t].blob;
+            if (tracks[t].host != id || s.area * 2 < b.area)
+                continue;
+            float d2 = (b.x - x) * (b.x - x) + (b.y - y) * (b.y - y);
+            if (child < 0 || d2 < nearest) {
+                child = t;
+                nearest = d2;
+            }
+        }
+        if (child >= 0) {
+            tracks[child].host = 0;
+            tracks[child].missing = 0;
+            assigned[child] = _candidate;
+            claimed[_candidate] = child;
+            sums[child] = s;
+            jumped[child] = 1;
+            jumped[host] = 1;
+            return true;
+        }
+
+        // a piece smaller than what is left, a limb cut off, goes back
+        Stats& sum = sums[host];
+        if (s.area < sum.area) {
+            sum.sumX += s.sumX;
+            sum.sumY += s.sumY;
+            sum.sumDepth += s.sumDepth;
+            sum.area += s.area;
+            sum.readings += s.readings;
+            sum.x0 = std::min(sum.x0, s.x0);
+            sum.y0 = std::min(sum.y0, s.y0);
+            sum.x1 = std::max(sum.x1, s.x1);
+            sum.y1 = std::max(sum.y1, s.y1);
+            claimed[_candidate] = host;
+            jumped[host] = 1;
+            return true;
+        }
+    }
+
+    // a dancer lost for a while, turning up further off than the gate
+    int lost = -1;
+    for (size_t t=0; t<tracks.size(); t++) {
+        const Track& track = tracks[t];
+        if (assigned[t] >= 0 || track.host != 0 || track.blob.id == 0 || track.missing == 0)
+            continue;
+        float d2 = (track.blob.x - x) * (track.blob.x - x) + (track.blob.y - y) * (track.blob.y - y);
+        float g = 2 * gate(track, s);
+        if (d2 <= g * g && (lost < 0 || d2 < nearest)) {
+            lost = t;
+            nearest = d2;
+        }
+    }
+    if (lost < 0)
+        return false;
+    assigned[lost] = _candidate;
+    claimed[_candidate] = lost;
+    sums[lost] = s;
+    jumped[lost] = 1;
+    return true;
+}
+
+//--------------------------------------------------------------
+void BlobTracker::update(Track& _track, const Stats& _stats, float _deltaTime, bool _steady) {
+    Blob& b = _track.blob;
+    float x = (float)_stats.sumX / _stats.area;
+    float y = (float)_stats.sumY / _stats.area;
+    // a blob that merged, split or grew a piece jumps, which is no movement
+    if (_deltaTime > 0 && _steady && b.age > 0) {
+        int frames = _track.missing + 1;
+        b.vx = smoothing * b.vx + (1 - smoothing) * (x - b.x) / (frames * _deltaTime);
+        b.vy = smoothing * b.vy + (1 - smoothing) * (y - b.y) / (frames * _deltaTime);
+    }
+    b.x = x;
+    b.y = y;
+    b.x0 = _stats.x0;
+    b.y0 = _stats.y0;
+    b.x1 = _stats.x1;
+    b.y1 = _stats.y1;
+    b.area = _stats.area;
+    b.depth = _stats.readings > 0 ? (float)_stats.sumDepth / _stats.readings : 0.0f;
+    b.age++;
+    _track.missing = 0;
+}
+
+//--------------------------------------------------------------
+void BlobTracker::match(float _deltaTime) {
+    int numTracks = tracks.size();
+    int numCandidates = candidates.size();
+
+    // where each track would be by now at the speed it had
+    predicted.resize(numTracks);
+    for (int t=0; t<numTracks; t++) {
+        const Blob& b = tracks[t].blob;
+        float lost = (tracks[t].missing + 1) * _deltaTime;
+        float dx = b.vx * lost, dy = b.vy * lost;
+        Box p = { b.x + dx, b.y + dy, b.x0 + dx, b.y0 + dy, b.x1 + dx, b.y1 + dy };
+        predicted[t] = p;
+    }
+
+    pairs.clear();
+    for (int t=0; t<numTracks; t++) {
+        if (tracks[t].host != 0)
+            continue;
+        const Box& p = predicted[t];
+        for (int c=0; c<numCandidates; c++) {
+            const Stats& s = candidates[c];
+            if (s.area < minArea)
+                continue;
+            float dx = (float)s.sumX / s.area - p.x;
+            float dy = (float)s.sumY / s.area - p.y;
+            float d2 = dx * dx + dy * dy;
+            float g = gate(tracks[t], s);
+            bool overlaps = p.x0 < s.x1 && s.x0 < p.x1 && p.y0 < s.y1 && s.y0 < p.y1;
+            if (d2 <= g * g || overlaps) {
+                // and a piece much smaller or larger than the track is a worse match
+                float ratio = (float)s.area / std::max(tracks[t].blob.area, 1);
+                Pair pair = { d2 * std::max(ratio, 1 / ratio), t, c };
+                pairs.push_back(pair);
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    // closest first, each track and each candidate taken once
+    claimed.assign(numCandidates, -1);
+    assigned.assign(numTracks, -1);
+    jumped.assign(numTracks, 0);
+    moved.assign(numTracks * 2, 0);
+    sums.resize(numTracks);
+    for (size_t i=0; i<pairs.size(); i++) {
+        int t = pairs[i].track, c = pairs[i].candidate;
+        if (assigned[t] >= 0 || claimed[c] >= 0)
+            continue;
+        assigned[t] = c;
+        claimed[c] = t;
+    }
+
+    // a track left over that should be inside a blob another one took ran
+    // into it; the older id keeps the blob
+    for (size_t i=0; i<pairs.size(); i++) {
+        int t = pairs[i].track, c = pairs[i].candidate;
+        if (assigned[t] >= 0 || tracks[t].host != 0 || tracks[t].missing > maxMissing || claimed[c] < 0)
+            continue;
+        const Stats& s = candidates[c];
+        const Box& p = predicted[t];
+        if (p.x < s.x0 || p.x >= s.x1 || p.y < s.y0 || p.y >= s.y1)
+            continue;
+        int host = claimed[c];
+        const Blob& a = tracks[t].blob;
+        const Blob& b = tracks[host].blob;
+        if (a.id != 0 && (b.id == 0 || a.id < b.id)) {
+            assigned[t] = c;
+            assigned[host] = -1;
+            claimed[c] = t;
+            std::swap(t, host);
+        }
+        mergeInto(t, host);
+    }
+
+    // then what is left over, or only taken by a track too new for an id:
+    // dancers leaving a merge, pieces cut off a blob, dancers lost for
+    // longer, and whatever is new
+    for (int t=0; t<numTracks; t++) {
+        if (assigned[t] >= 0)
+            sums[t] = candidates[assigned[t]];
+    }
+    for (int c=0; c<numCandidates; c++) {
+        int t = claimed[c];
+        if (candidates[c].area < minArea || (t >= 0 && tracks[t].blob.id != 0))
+            continue;
+        if (adopt(c) && t >= 0)
+            assigned[t] = -1;
+    }
+
+    matched.clear();
+    for (int t=0; t<numTracks; t++) {
+        Track& track = tracks[t];
+        if (assigned[t] >= 0) {
+            float x = track.blob.x, y = track.blob.y;
+            update(track, sums[t], _deltaTime, !jumped[t]);
+            moved[t * 2] = track.blob.x - x;
+            moved[t * 2 + 1] = track.blob.y - y;
+            if (track.blob.id == 0 && track.blob.age >= minFrames)
+                track.blob.id = nextId++;
+        }
+        else if (track.host == 0)
+            track.missing++;
+    }
+    for (int t=0; t<numTracks; t++) {
+        Track& track = tracks[t];
+        if (track.host != 0) {
+            // riding along inside its host for a while, the frames counted
+            // as missing, or on its own again once the host is gone
+            int host = -1;
+            for (int h=0; h<numTracks; h++) {
+                if (tracks[h].host == 0 && tracks[h].blob.id == track.host && tracks[h].missing <= maxMissing)
+                    host = h;
+            }
+            if (host < 0) {
+                track.host = 0;
+                track.missing = 1;
+            }
+            else {
+                track.blob.x += moved[host * 2];
+                track.blob.y += moved[host * 2 + 1];
+                if (++track.missing <= maxMerged)
+                    matched.push_back(track);
+                continue;
+            }
+        }
+        // a new blob has to be there every frame until it has an id
+        if (track.missing <= maxMissing && (track.blob.id != 0 || track.missing == 0))
+            matched.push_back(track);
+    }
+    for (int c=0; c<numCandidates; c++) {
+        const Stats& s = candidates[c];
+        if (claimed[c] >= 0 || s.area < minArea)
+            continue;
+        Track track;
+        track.blob.id = 0;
+        track.blob.x = track.blob.y = 0;
+        track.blob.vx = track.blob.vy = 0;
+        track.blob.age = 0;
+        track.missing = 0;
+        track.host = 0;
+        update(track, s, _deltaTime, false);
+        if (track.blob.age >= minFrames)
+            track.blob.id = nextId++;
+        matched.push_back(track);
+    }
+    tracks.swap(matched);
+
+    blobs.clear();
+    for (size_t t=0; t<tracks.size(); t++) {
+        if (tracks[t].missing == 0 && tracks[t].host == 0 && tracks[t].blob.id != 0)
+            blobs.push_back(tracks[t].blob);
+    }
+}
+
+//--------------------------------------------------------------
+void BlobTracker::process(const uint8_t* _mask, const uint16_t* _depth, bool _mirrored, float _deltaTime) {
+    if (_mirrored) {
+        mirroredDepth.resize(width * height);
+        for (int y=0; y<height; y++)
+            std::reverse_copy(_depth + y * width, _depth + (y + 1) * width, &mirroredDepth[y * width]);
+        _depth = mirroredDepth.data();
+    }
+    label(_mask, _depth);
+    measure();
+    match(_deltaTime);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// One dancer, or whatever else stands out of the room as one piece.
+struct Blob {
+    int		id;				// stays with the dancer from frame to frame
+    float	x, y;			// centroid, pixels
+    int		x0, y0, x1, y1;	// bounding box, x1 and y1 past the last pixel
+    int		area;			// pixels
+    float	depth;			// mean mm of its readings, 0 if it has none
+    float	vx, vy;			// centroid velocity, pixels a second, smoothed
+    int		age;			// frames it has been tracked for
+};
+
+// Finds the blobs in a foreground mask and follows them. Labeling works on
+// runs rather than pixels: each row is cut into runs of foreground (eight
+// bytes at a time through the background), and also where the depth steps
+// by more than depthStep, so two dancers overlapping in the mask but a
+// stride apart stay two. Each run is joined with the runs it touches in the
+// row above (8-connected) where the readings on either side are within
+// depthStep of each other somewhere along the overlap, in a union-find over
+// the runs, and the statistics are summed per run and then per root.
+// Blobs are matched to the ones of the frame before by nearest centroid,
+// closest pairs first, within a distance that grows with the blob's size
+// and with how long it has been missing, or anywhere its box overlaps
+// where the track was heading; one that goes missing keeps its id for a
+// few frames in case it comes back.
+// Dancers who run into each other are one blob for a while: the blob keeps
+// the oldest id among them and the others ride along inside it, and when
+// a dancer-sized piece leaves it again the nearest of them gets it back.
+// A smaller piece cut off a blob, a limb the mask lost the link to, is
+// counted back into the blob it came off. Anything else new is only given
+// an id, and reported, once it has been seen minFrames frames in a row.
+// No allocation after the first few frames, no openFrameworks.
+
+class BlobTracker {
+public:
+    BlobTracker();
+
+    void	setup(int _width, int _height);
+    void	reset();
+
+    // _mask nonzero for foreground; _depth in mm, mirrored against the mask
+    // if _mirrored (the depth as the camera sees it, the mask as drawn)
+    void	process(const uint8_t* _mask, const uint16_t* _depth, bool _mirrored, float _deltaTime);
+
+    const std::vector<Blob>&	getBlobs() const	{ return blobs; }
+
+    int		minArea;			// pixels, smaller blobs are noise
+    float	maxDistance;		// pixels a blob may move between frames and keep its id
+    float	sizeGate;			// and of its size, sqrt of its area, on top
+    int		minFrames;			// frames a new blob must last to get an id
+    int		maxMissing;			// frames a lost blob keeps its id for
+    int		maxMerged;			// and one merged into another
+    float	smoothing;			// 0 .. 1 of the velocity kept from the frame before
+    float	depthStep;			// mm between neighbours that makes them two blobs, 0 for the mask alone
+
+private:
+    struct Run {
+        int		y, x0, x1;		// x1 past the end
+        int		parent;
+        int		sumDepth, readings;
+    };
+    struct Stats {
+        int64_t	sumX, sumY;
+        int64_t	sumDepth;
+        int		area, readings;
+        int		x0, y0, x1, y1;
+    };
+    struct Track {
+        Blob	blob;
+        int		missing;
+        int		host;			// id of the blob it merged into, 0 while it is its own
+    };
+    struct Box {
+        float	x, y;			// the centroid and the box where a track should be by now
+        float	x0, y0, x1, y1;
+    };
+
+    int		find(int _run);
+    void	unite(int _a, int _b);
+    void	label(const uint8_t* _mask, const uint16_t* _depth);
+    void	addRuns(int _y, int _x0, int _x1, const uint16_t* _depth);
+    bool	touches(const Run& _above, const Run& _below, const uint16_t* _depthAbove, const uint16_t* _depthBelow) const;
+    void	measure();
+    void	match(float _deltaTime);
+    float	gate(const Track& _track, const Stats& _stats) const;
+    void	mergeInto(int _track, int _host);
+    bool	adopt(int _candidate);
+    void	update(Track& _track, const Stats& _stats, float _deltaTime, bool _steady);
+
+    int		width;
+    int		height;
+    int		nextId;
+
+    std::vector<uint16_t>	mirroredDepth;	// the depth the mask's way round
+    std::vector<Run>	runs;
+    std::vector<int>	rowStart;		// first run of each row, one past the last row too
+    std::vector<int>	rootIndex;		// root run to its candidate
+    std::vector<Stats>	candidates;		// this frame's blobs before matching
+    std::vector<Track>	tracks;
+    std::vector<Track>	matched;
+    std::vector<int>	claimed;		// candidate to the track that took it, -1
+    std::vector<int>	assigned;		// track to its candidate, -1
+    std::vector<Stats>	sums;			// each track's candidate and the pieces it got back
+    std::vector<Box>	predicted;
+    std::vector<uint8_t>	jumped;		// a track whose blob merged, split or grew a piece
+    std::vector<float>	moved;			// each track's step this frame, x y pairs
+    struct Pair {
+        float	distance2;
+        int		track, candidate;
+        bool	operator<(const Pair& _other) const	{ return distance2 < _other.distance2; }
+    };
+    std::vector<Pair>	pairs;
+    std::vector<Blob>	blobs;
+};
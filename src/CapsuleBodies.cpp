@@ -0,0 +1,187 @@
+#include "CapsuleBodies.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const int		noiseSize = 1 << 16;
+    const float		pi = 3.14159265f;
+
+    // a joint in body space, metres, x to the right, y up, z towards the camera
+    struct Joint {
+        float	x, y, z;
+    };
+
+    Joint limb(const Joint& _from, float _length, float _angle, float _forward) {
+        // _angle from straight down, positive outwards to the right
+        Joint j = { _from.x + _length * sinf(_angle), _from.y - _length * cosf(_angle), _from.z + _forward };
+        return j;
+    }
+}
+
+//--------------------------------------------------------------
+CapsuleBodies::CapsuleBodies() {
+    width = 0;
+    height = 0;
+    paddedWidth = 0;
+    focal = 1;
+    cameraHeight = 1.0f;
+    wallDistance = 4500;
+    farClip = 6000;
+    noiseAmount = 3;
+    frame = 0;
+}
+
+//--------------------------------------------------------------
+void CapsuleBodies::setup(int _width, int _height) {
+    width = _width;
+    height = _height;
+    paddedWidth = (width + simd::width - 1) / simd::width * simd::width;
+    // the Kinect's 58 degrees across
+    focal = width * 0.9f;
+
+    uint32_t state = 0x9e3779b9;
+    noise.resize(noiseSize + paddedWidth);
+    for (size_t i=0; i<noise.size(); i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        noise[i] = (state & 0xffff) / 32767.5f - 1.0f;
+    }
+    ramp.resize(paddedWidth);
+    for (int i=0; i<paddedWidth; i++)
+        ramp[i] = i;
+    capsules.reserve(maxBodies * capsulesPerBody);
+}
+
+//--------------------------------------------------------------
+void CapsuleBodies::addCapsule(float _x0, float _y0, float _z0, float _x1, float _y1, float _z1, float _radius) {
+    // metres in front of the camera to pixels and millimetres
+    float z0 = std::max(_z0, 0.3f);
+    float z1 = std::max(_z1, 0.3f);
+    Capsule c;
+    c.ax = width * 0.5f + focal * _x0 / z0;
+    c.ay = height * 0.5f - focal * (_y0 - cameraHeight) / z0;
+    c.bx = width * 0.5f + focal * _x1 / z1;
+    c.by = height * 0.5f - focal * (_y1 - cameraHeight) / z1;
+    c.za = z0 * 1000;
+    c.zb = z1 * 1000;
+    c.radius = focal * _radius * 2 / (z0 + z1);
+    c.bulge = _radius * 1000;
+    c.x0 = std::max(0, (int)floorf(std::min(c.ax, c.bx) - c.radius));
+    c.x1 = std::min(width, (int)ceilf(std::max(c.ax, c.bx) + c.radius) + 1);
+    c.y0 = std::max(0, (int)floorf(std::min(c.ay, c.by) - c.radius));
+    c.y1 = std::min(height, (int)ceilf(std::max(c.ay, c.by) + c.radius) + 1);
+    if (c.x0 < c.x1 && c.y0 < c.y1)
+        capsules.push_back(c);
+}
+
+//--------------------------------------------------------------
+void CapsuleBodies::animate(double _seconds, int _numBodies) {
+    capsules.clear();
+    frame++;
+    int n = std::min(std::max(_numBodies, 0), (int)maxBodies);
+    for (int b=0; b<n; b++) {
+        // every body has its own tempo and its own patch of floor
+        float t = _seconds * (0.8 + 0.07 * (b % 5)) + b * 1.7;
+        float lane = n > 1 ? (float)b / (n - 1) - 0.5f : 0.0f;
+        float depth = 2.0f + 2.0f * (b % 4) / 3.0f + 0.4f * sinf(t * 0.31f);
+        float across = (lane * 1.6f + 0.5f * sinf(t * 0.23f + b)) * depth / 2.0f;
+        float swing = sinf(t * 2 * pi * 0.5f);
+        float raise = 0.5f + 0.5f * sinf(t * 0.7f + b);
+
+        Joint pelvis = { across, 0.95f + 0.04f * fabsf(swing), depth };
+        Joint neck = { pelvis.x + 0.05f * swing, 1.5f, depth };
+        Joint head = { neck.x, 1.78f, depth - 0.02f };
+        addCapsule(pelvis.x, pelvis.y, pelvis.z, neck.x, neck.y, neck.z, 0.15f);
+        addCapsule(neck.x, neck.y + 0.08f, neck.z, head.x, head.y, head.z, 0.1f);
+
+        for (int side=-1; side<=1; side+=2) {
+            Joint shoulder = { neck.x + side * 0.17f, 1.45f, depth };
+            Joint elbow = limb(shoulder, 0.3f, side * (0.25f + 1.6f * raise), -0.15f * swing * side);
+            Joint hand = limb(elbow, 0.28f, side * (0.4f + 2.2f * raise) + 0.3f * swing, -0.1f * swing * side);
+            addCapsule(shoulder.x, shoulder.y, shoulder.z, elbow.x, elbow.y, elbow.z, 0.05f);
+            addCapsule(elbow.x, elbow.y, elbow.z, hand.x, hand.y, hand.z, 0.045f);
+
+            Joint hip = { pelvis.x + side * 0.1f, pelvis.y - 0.05f, depth };
+            Joint knee = limb(hip, 0.45f, side * 0.08f + 0.35f * swing * side, 0.1f * swing * side);
+            Joint foot = limb(knee, 0.45f, side * 0.05f + 0.15f * swing * side, 0);
+            addCapsule(hip.x, hip.y, hip.z, knee.x, knee.y, knee.z, 0.07f);
+            addCapsule(knee.x, knee.y, knee.z, foot.x, foot.y, foot.z, 0.055f);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+float CapsuleBodies::backgroundAt(int _y) const {
+    // the floor below the horizon until it meets the back wall
+    float below = _y + 0.5f - height * 0.5f;
+    if (below <= 0)
+        return wallDistance;
+    return std::min(wallDistance, focal * cameraHeight * 1000 / below);
+}
+
+//--------------------------------------------------------------
+void CapsuleBodies::renderRows(int _begin, int _end, uint16_t* _depth, float* _scratch) const {
+    using namespace simd;
+    const vfloat zero = set1(0.0f);
+    const vfloat one = set1(1.0f);
+    // far enough past the edge of a capsule to lose against anything
+    const vfloat outside = set1(1e6f);
+
+    for (int y=_begin; y<_end; y++) {
+        vfloat background = set1(backgroundAt(y));
+        for (int x=0; x<paddedWidth; x+=simd::width)
+            store(_scratch + x, background);
+
+        float py = y + 0.5f;
+        for (size_t i=0; i<capsules.size(); i++) {
+            const Capsule& c = capsules[i];
+            if (y < c.y0 || y >= c.y1)
+                continue;
+
+            // nearest point on the axis, t along it, for a vector of pixels
+            float abx = c.bx - c.ax;
+            float aby = c.by - c.ay;
+            float length2 = abx * abx + aby * aby;
+            float inverse = length2 > 1e-6f ? 1.0f / length2 : 0.0f;
+            float dy = py - c.ay;
+            vfloat vabx = set1(abx), vaby = set1(aby), vinverse = set1(inverse);
+            vfloat vdy = set1(dy), vdyaby = set1(dy * aby);
+            vfloat vza = set1(c.za), vdz = set1(c.zb - c.za);
+            vfloat r2 = set1(c.radius * c.radius);
+            vfloat bulgePerPixel = set1(c.radius > 0 ? c.bulge / c.radius : 0.0f);
+
+            int x0 = c.x0 / simd::width * simd::width;
+            vfloat firstX = set1(x0 + 0.5f - c.ax);
+            for (int x=x0; x<c.x1; x+=simd::width) {
+                vfloat dx = add(firstX, load(&ramp[x - x0]));
+                vfloat t = mul(madd(dx, vabx, vdyaby), vinverse);
+                t = min(max(t, zero), one);
+                vfloat ex = nmadd(t, vabx, dx);
+                vfloat ey = nmadd(t, vaby, vdy);
+                vfloat d2 = madd(ex, ex, mul(ey, ey));
+                // in front of the axis by the bulge inside, pushed away outside
+                vfloat h = sqrt(max(sub(r2, d2), zero));
+                vfloat z = nmadd(h, bulgePerPixel, madd(t, vdz, vza));
+                z = madd(max(sub(d2, r2), zero), outside, z);
+                store(_scratch + x, min(load(_scratch + x), z));
+            }
+        }
+
+        // sensor noise, larger with distance, read from the table at an
+        // offset that changes every row and every frame
+        const float* n = &noise[((uint32_t)y * 7919u + (uint32_t)frame * 104729u) & (noiseSize - 1)];
+        vfloat amount = set1(noiseAmount / (2000.0f * 2000.0f));
+        for (int x=0; x<paddedWidth; x+=simd::width) {
+            vfloat z = load(_scratch + x);
+            store(_scratch + x, madd(mul(load(n + x), amount), mul(z, z), z));
+        }
+        uint16_t* row = _depth + y * width;
+        for (int x=0; x<width; x++) {
+            float z = _scratch[x];
+            row[x] = z < farClip ? (uint16_t)z : 0;
+        }
+    }
+}
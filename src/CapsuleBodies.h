@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Procedural dancers for a synthetic depth camera: each body is a skeleton of
+// ten capsules (torso, head, arms, legs) that walks, sways and swings its
+// limbs on its own phase, seen from a camera a metre off the floor in front
+// of a back wall. animate() poses every body and projects its capsules into
+// the image once per frame; renderRows() then draws any band of rows, so the
+// rows can be split between threads. The inner loop is vectorized across
+// the row: the distance to a capsule's axis, its bulge towards the camera and
+// the nearest surface so far, with no branches. Depth comes out in
+// millimetres with noise that grows with the square of the distance, like a
+// structured light sensor, and 0 beyond the far clip. No openFrameworks.
+
+class CapsuleBodies {
+public:
+    static const int	maxBodies = 64;
+    static const int	capsulesPerBody = 10;
+
+    CapsuleBodies();
+
+    void	setup(int _width, int _height);
+    void	setNoise(float _millimetres)	{ noiseAmount = _millimetres; }
+
+    // poses _numBodies bodies at _seconds, not thread safe
+    void	animate(double _seconds, int _numBodies);
+    // rows [_begin, _end) into _depth (width x height), any thread once
+    // animate() has returned; _scratch holds getScratchSize() floats
+    void	renderRows(int _begin, int _end, uint16_t* _depth, float* _scratch) const;
+
+    int		getWidth() const		{ return width; }
+    int		getHeight() const		{ return height; }
+    int		getScratchSize() const	{ return paddedWidth; }
+
+private:
+    struct Capsule {
+        float	ax, ay;			// axis in pixels
+        float	bx, by;
+        float	za, zb;			// depth of the axis ends, mm
+        float	radius;			// pixels
+        float	bulge;			// mm the surface comes forward at the axis
+        int		x0, x1, y0, y1;	// bounding box, clipped to the image
+    };
+
+    void	addCapsule(float _x0, float _y0, float _z0, float _x1, float _y1, float _z1, float _radius);
+    float	backgroundAt(int _y) const;
+
+    int		width;
+    int		height;
+    int		paddedWidth;		// a whole number of vectors
+    float	focal;				// pixels
+    float	cameraHeight;		// metres above the floor
+    float	wallDistance;		// mm
+    float	farClip;			// mm
+    float	noiseAmount;		// mm at 2 m
+    int		frame;
+
+    std::vector<Capsule>	capsules;
+    std::vector<float>		noise;		// -1..1, read at a different offset every row
+    std::vector<float>		ramp;		// 0, 1, 2, ...
+};
@@ -0,0 +1,343 @@
+#include "ContourTracer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // a cell's corners are bits tl 1, tr 2, br 4, bl 8; its edges top 0,
+    // right 1, bottom 2, left 3. Each case's boundary pieces, foreground
+    // on the left, as the edge each leaves by for the edge it comes in by,
+    // -1 where none comes in. The saddles 5 and 10 have two pieces, which
+    // keep diagonal neighbours apart.
+    const int exits[16][4] = {
+        { -1, -1, -1, -1 },
+        { -1, -1, -1,  0 },
+        {  1, -1, -1, -1 },
+        { -1, -1, -1,  1 },
+        { -1,  2, -1, -1 },
+        { -1,  2, -1,  0 },
+        {  2, -1, -1, -1 },
+        { -1, -1, -1,  2 },
+        { -1, -1,  3, -1 },
+        { -1, -1,  0, -1 },
+        {  1, -1,  3, -1 },
+        { -1, -1,  1, -1 },
+        { -1,  3, -1, -1 },
+        { -1,  0, -1, -1 },
+        {  3, -1, -1, -1 },
+        { -1, -1, -1, -1 }
+    };
+
+    // each edge's crossing from the cell's top left pixel, in the mask's
+    // pixels, and the neighbour across it
+    const float	edgeX[4] = { -0.5f, 0, -0.5f, -1 };
+    const float	edgeY[4] = { -1, -0.5f, 0, -0.5f };
+    const int	stepX[4] = { 0, 1, 0, -1 };
+    const int	stepY[4] = { -1, 0, 1, 0 };
+
+    // what is left of a cell once the piece in by _entry is traced
+    inline int untraced(int _case, int _entry) {
+        if (_case == 5)
+            return _entry == 3 ? 4 : 1;
+        if (_case == 10)
+            return _entry == 0 ? 8 : 2;
+        return 0;
+    }
+
+    const uint64_t	allFifteens = 0x0f0f0f0f0f0f0f0full;
+
+    inline uint64_t load64(const uint8_t* _p) {
+        uint64_t v;
+        memcpy(&v, _p, 8);
+        return v;
+    }
+}
+
+//--------------------------------------------------------------
+ContourTracer::ContourTracer() {
+    width = 0;
+    height = 0;
+    paddedWidth = 0;
+    paddedHeight = 0;
+    numCrossings = 0;
+    primed = false;
+    tolerance = 1.5f;
+    minLength = 40;
+    maxStep = 16;
+}
+
+//--------------------------------------------------------------
+void ContourTracer::setup(int _width, int _height) {
+    width = _width;
+    height = _height;
+    paddedWidth = width + 2;
+    paddedHeight = height + 2;
+    padded.assign(paddedWidth * paddedHeight, 0);
+    previous.assign(paddedWidth * paddedHeight, 0);
+    // a row of cells is as wide as a padded row, the last one always 0
+    cases.assign(paddedWidth * (paddedHeight - 1), 0);
+    starts.reserve(width * 8);
+    chain.reserve(width * 16);
+    vertices.reserve(1024);
+    contours.reserve(64);
+    reset();
+}
+
+//--------------------------------------------------------------
+void ContourTracer::reset() {
+    primed = false;
+    vertices.clear();
+    contours.clear();
+    numCrossings = 0;
+}
+
+//--------------------------------------------------------------
+bool ContourTracer::wasForeground(float _x, float _y) const {
+    int x = (int)floorf(_x + 0.5f) + 1;
+    int y = (int)floorf(_y + 0.5f) + 1;
+    if (x < 0 || y < 0 || x >= paddedWidth || y >= paddedHeight)
+        return false;
+    return previous[y * paddedWidth + x] != 0;
+}
+
+//--------------------------------------------------------------
+void ContourTracer::classify() {
+    const int pw = paddedWidth;
+    const int numCells = pw - 1;
+    const int numWords = numCells / 8;
+    starts.clear();
+
+    for (int y=0; y<paddedHeight-1; y++) {
+        // every cell's case first, a loop the compiler vectorizes
+        const uint8_t* above = &padded[y * pw];
+        const uint8_t* below = above + pw;
+        uint8_t* c = &cases[y * pw];
+        for (int x=0; x<numCells; x++)
+            c[x] = above[x] | (above[x + 1] << 1) | (below[x + 1] << 2) | (below[x] << 3);
+
+        // then the cells the boundary crosses, passing over eight at a
+        // time the ones all inside or all outside
+        for (int w=0; w<=numWords; w++) {
+            int x = w * 8;
+            int end = std::min(x + 8, numCells);
+            if (w < numWords) {
+                uint64_t word = load64(c + x);
+                if (word == 0 || word == allFifteens)
+                    continue;
+            }
+            for (; x<end; x++) {
+                if (c[x] != 0 && c[x] != 15)
+                    starts.push_back(y * pw + x);
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void ContourTracer::simplify(int _count) {
+    // Douglas-Peucker on a closed chain: split it at its first crossing and
+    // the one furthest from it, then each half on its own. Index _count
+    // stands for the first crossing again
+    const float* p = chain.data();
+    int n = _count;
+    keep.assign(n, 0);
+    int far = 0;
+    float farthest = -1;
+    for (int k=1; k<n; k++) {
+        float dx = p[k * 2] - p[0], dy = p[k * 2 + 1] - p[1];
+        float d = dx * dx + dy * dy;
+        if (d > farthest) {
+            farthest = d;
+            far = k;
+        }
+    }
+    keep[0] = 1;
+    keep[far] = 1;
+    stack.clear();
+    stack.push_back(0);
+    stack.push_back(far);
+    stack.push_back(far);
+    stack.push_back(n);
+    float tolerance2 = tolerance * tolerance;
+
+    while (!stack.empty()) {
+        int j = stack.back();
+        stack.pop_back();
+        int i = stack.back();
+        stack.pop_back();
+        if (j - i < 2)
+            continue;
+        float ax = p[i * 2], ay = p[i * 2 + 1];
+        float bx = p[(j % n) * 2], by = p[(j % n) * 2 + 1];
+        float dx = bx - ax, dy = by - ay;
+        float length2 = dx * dx + dy * dy;
+        int worst = -1;
+        float worstDistance = 0;
+        for (int k=i+1; k<j; k++) {
+            float ex = p[k * 2] - ax, ey = p[k * 2 + 1] - ay;
+            // squared distance to the line times its squared length
+            float cross = dx * ey - dy * ex;
+            float d = length2 > 0 ? cross * cross : (ex * ex + ey * ey);
+            if (d > worstDistance) {
+                worstDistance = d;
+                worst = k;
+            }
+        }
+        if (worst >= 0 && worstDistance > tolerance2 * (length2 > 0 ? length2 : 1)) {
+            keep[worst] = 1;
+            stack.push_back(i);
+            stack.push_back(worst);
+            stack.push_back(worst);
+            stack.push_back(j);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void ContourTracer::addVertex(float _x, float _y) {
+    ContourVertex v;
+    v.x = _x;
+    v.y = _y;
+    v.nx = 0;
+    v.ny = 0;
+    v.speed = 0;
+    vertices.push_back(v);
+}
+
+//--------------------------------------------------------------
+void ContourTracer::finish(int _first, int _count, float _deltaTime) {
+    ContourVertex* v = &vertices[_first];
+    bool moving = primed && _deltaTime > 0;
+    for (int i=0; i<_count; i++) {
+        const ContourVertex& before = v[(i + _count - 1) % _count];
+        const ContourVertex& after = v[(i + 1) % _count];
+        // out of the foreground is to the right of the way round
+        float ax = v[i].x - before.x, ay = v[i].y - before.y;
+        float bx = after.x - v[i].x, by = after.y - v[i].y;
+        float la = sqrtf(ax * ax + ay * ay), lb = sqrtf(bx * bx + by * by);
+        float nx = (la > 0 ? -ay / la : 0) + (lb > 0 ? -by / lb : 0);
+        float ny = (la > 0 ? ax / la : 0) + (lb > 0 ? bx / lb : 0);
+        float l = sqrtf(nx * nx + ny * ny);
+        if (l > 0) {
+            nx /= l;
+            ny /= l;
+        }
+        v[i].nx = nx;
+        v[i].ny = ny;
+        if (!moving)
+            continue;
+
+        // where the boundary was last frame, along the normal: further in
+        // if the pixel just inside it was background then, further out if
+        // the one just outside was foreground
+        float x = v[i].x, y = v[i].y;
+        int moved = 0;
+        if (!wasForeground(x - nx * 0.5f, y - ny * 0.5f)) {
+            for (int k=1; k<=maxStep; k++) {
+                if (wasForeground(x - nx * (k + 0.5f), y - ny * (k + 0.5f))) {
+                    moved = k;
+                    break;
+                }
+            }
+        }
+        else if (wasForeground(x + nx * 0.5f, y + ny * 0.5f)) {
+            for (int k=1; k<=maxStep; k++) {
+                if (!wasForeground(x + nx * (k + 0.5f), y + ny * (k + 0.5f))) {
+                    moved = -k;
+                    break;
+                }
+            }
+        }
+        v[i].speed = moved / _deltaTime;
+    }
+}
+
+//--------------------------------------------------------------
+void ContourTracer::trace() {
+    const int pw = paddedWidth;
+    const int step[4] = { -pw, 1, pw, -1 };
+    uint8_t* c = cases.data();
+    vertices.clear();
+    contours.clear();
+    numCrossings = 0;
+
+    for (size_t s=0; s<starts.size(); s++) {
+        // a saddle can start two outlines
+        int start = starts[s];
+        while (c[start] != 0) {
+            int cell = start;
+            int cy = start / pw;
+            int cx = start - cy * pw;
+            int entry = 0;
+            while (exits[c[cell]][entry] < 0)
+                entry++;
+
+            // round the cells until back where it came in, clearing each
+            // piece on the way
+            chain.clear();
+            float area2 = 0;
+            float lastX = 0, lastY = 0;
+            for (;;) {
+                int k = c[cell];
+                int exit = exits[k][entry];
+                if (exit < 0)
+                    break;
+                c[cell] = untraced(k, entry);
+                float x = cx + edgeX[exit], y = cy + edgeY[exit];
+                chain.push_back(x);
+                chain.push_back(y);
+                area2 += lastX * y - x * lastY;
+                lastX = x;
+                lastY = y;
+                cx += stepX[exit];
+                cy += stepY[exit];
+                cell += step[exit];
+                entry = (exit + 2) & 3;
+            }
+            area2 += lastX * chain[1] - chain[0] * lastY;
+
+            int n = chain.size() / 2;
+            numCrossings += n;
+            if (n < minLength)
+                continue;
+            simplify(n);
+            Contour contour;
+            contour.first = vertices.size();
+            for (int k=0; k<n; k++) {
+                if (keep[k])
+                    addVertex(chain[k * 2], chain[k * 2 + 1]);
+            }
+            contour.count = vertices.size() - contour.first;
+            if (contour.count < 3) {
+                vertices.resize(contour.first);
+                continue;
+            }
+            // with y down and the foreground on the left, outsides wind negative
+            contour.area = fabsf(area2) * 0.5f;
+            contour.hole = area2 > 0;
+            contours.push_back(contour);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void ContourTracer::process(const uint8_t* _mask, float _deltaTime) {
+    if (width == 0)
+        return;
+    const int w = width;
+    for (int y=0; y<height; y++) {
+        const uint8_t* src = _mask + y * w;
+        uint8_t* dst = &padded[(y + 1) * paddedWidth + 1];
+        for (int x=0; x<w; x++)
+            dst[x] = src[x] != 0;
+    }
+
+    classify();
+    trace();
+    for (size_t c=0; c<contours.size(); c++)
+        finish(contours[c].first, contours[c].count, _deltaTime);
+
+    padded.swap(previous);
+    primed = true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// One corner of a simplified outline.
+struct ContourVertex {
+    float	x, y;			// pixels, on the boundary between the mask's pixels
+    float	nx, ny;			// unit normal, out of the foreground
+    float	speed;			// pixels a second the boundary moved along the normal, out positive
+};
+
+// One closed outline, getVertices()[first, first + count).
+struct Contour {
+    int		first;
+    int		count;
+    float	area;			// pixels, enclosed
+    bool	hole;			// a gap inside a silhouette rather than its outside
+};
+
+// The outlines of a foreground mask as closed polylines. Marching squares
+// classifies every cell between four pixel centres by which of them are
+// foreground, then walks each boundary from cell to cell, the foreground
+// always on the left, so outsides run one way round and holes the other; a
+// frame of background around the mask closes the outlines that reach the
+// edge. Only the cell image is touched on the way, which stays in cache,
+// and runs of cells all foreground or all background are passed over
+// eight at a time when looking for where to start. Each chain is then
+// simplified with Douglas-Peucker to within the tolerance, and every corner
+// left gets the normal between its two sides and how far the boundary
+// moved since the last frame, looked up in the previous mask along that
+// normal, so the speed is the one a contour can see: across itself.
+// Everything lands in one vertex buffer per frame.
+// No allocation after the first few frames, no openFrameworks.
+
+class ContourTracer {
+public:
+    ContourTracer();
+
+    void	setup(int _width, int _height);
+    void	reset();
+
+    // _mask nonzero for foreground
+    void	process(const uint8_t* _mask, float _deltaTime);
+
+    const std::vector<ContourVertex>&	getVertices() const	{ return vertices; }
+    const std::vector<Contour>&			getContours() const	{ return contours; }
+    // boundary crossings before simplification
+    int		getNumCrossings() const		{ return numCrossings; }
+
+    float	tolerance;			// pixels the simplified outline may stray
+    int		minLength;			// crossings, shorter outlines are noise
+    int		maxStep;			// pixels searched for last frame's boundary
+
+private:
+    void	classify();
+    void	trace();
+    void	simplify(int _count);
+    void	addVertex(float _x, float _y);
+    void	finish(int _first, int _count, float _deltaTime);
+    bool	wasForeground(float _x, float _y) const;
+
+    int		width;
+    int		height;
+    int		paddedWidth;		// a pixel of background either side
+    int		paddedHeight;
+    int		numCrossings;
+    bool	primed;
+
+    std::vector<uint8_t>	padded;		// this frame's mask, 0 / 1
+    std::vector<uint8_t>	previous;	// and the last one's
+    std::vector<uint8_t>	cases;		// every cell's corners as bits, 0 once traced
+    std::vector<int>		starts;		// cells the boundary crosses, in scan order
+    std::vector<float>		chain;		// one outline's crossings, x y pairs
+    std::vector<int>		keep;		// indices into it that survive the simplification
+    std::vector<int>		stack;
+    std::vector<ContourVertex>	vertices;
+    std::vector<Contour>	contours;
+};
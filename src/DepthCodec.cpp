@@ -0,0 +1,246 @@
+#include "DepthCodec.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    const int	escapeLength = 24;	// ones before a residual in plain bits
+    const int	rawBits = 17;		// a zigzagged 16 bit difference
+    const int	resetCount = 64;	// halve the statistics this often
+
+    inline int predict(int _left, int _up, int _upLeft) {
+        int lo = std::min(_left, _up);
+        int hi = std::max(_left, _up);
+        if (_upLeft >= hi)
+            return lo;
+        if (_upLeft <= lo)
+            return hi;
+        return _left + _up - _upLeft;
+    }
+
+    // how busy the neighbourhood is, 0 for flat to numContexts - 1
+    const int	numContexts = 8;
+    inline int activity(int _left, int _up, int _upLeft) {
+        int g = abs(_left - _upLeft) + abs(_up - _upLeft);
+        int c = 0;
+        while (g > 0 && c < numContexts - 1) {
+            g >>= 2;
+            c++;
+        }
+        return c;
+    }
+
+    // prediction and context of a pixel, the neighbours outside the image
+    // repeat the nearest one inside it
+    inline int predictAt(const uint16_t* _depth, int _x, int _y, int _width, int& _context) {
+        const uint16_t* p = _depth + _y * _width + _x;
+        int left, up, upLeft;
+        if (_y == 0) {
+            left = up = upLeft = _x == 0 ? 0 : p[-1];
+        }
+        else if (_x == 0) {
+            left = up = upLeft = p[-_width];
+        }
+        else {
+            left = p[-1];
+            up = p[-_width];
+            upLeft = p[-_width - 1];
+        }
+        _context = activity(left, up, upLeft);
+        return predict(left, up, upLeft);
+    }
+
+    // Rice parameter from the running sum and count of the residuals
+    struct Adaptive {
+        uint32_t	sum;
+        uint32_t	count;
+
+        Adaptive() : sum(4), count(1) { }
+
+        int k() const {
+            int k = 0;
+            while ((count << k) < sum && k < rawBits)
+                k++;
+            return k;
+        }
+        void add(uint32_t _value) {
+            sum += _value;
+            if (++count == resetCount) {
+                sum >>= 1;
+                count >>= 1;
+            }
+        }
+    };
+
+    class BitWriter {
+    public:
+        BitWriter(std::vector<uint8_t>& _dst) : dst(_dst), accumulator(0), bits(0) { }
+
+        // at most 32 bits at a time
+        void put(uint32_t _value, int _bits) {
+            accumulator = (accumulator << _bits) | _value;
+            bits += _bits;
+            while (bits >= 8) {
+                bits -= 8;
+                dst.push_back((uint8_t)(accumulator >> bits));
+            }
+        }
+        void flush() {
+            if (bits > 0)
+                dst.push_back((uint8_t)(accumulator << (8 - bits)));
+            bits = 0;
+        }
+
+    private:
+        std::vector<uint8_t>&	dst;
+        uint64_t				accumulator;
+        int						bits;
+    };
+
+    class BitReader {
+    public:
+        BitReader(const uint8_t* _src, size_t _size) : src(_src), end(_src + _size), accumulator(0), bits(0), overrun(0) { }
+
+        // the next bits sit at the top of the accumulator
+        void refill() {
+            while (bits <= 56) {
+                uint64_t byte = 0;
+                if (src < end)
+                    byte = *src++;
+                else
+                    overrun += 8;
+                accumulator |= byte << (56 - bits);
+                bits += 8;
+            }
+        }
+        int ones(int _limit) {
+            refill();
+            int n = 0;
+            while (n < _limit && (accumulator >> 63)) {
+                accumulator <<= 1;
+                n++;
+            }
+            bits -= n;
+            return n;
+        }
+        uint32_t get(int _bits) {
+            if (_bits == 0)
+                return 0;
+            refill();
+            uint32_t value = (uint32_t)(accumulator >> (64 - _bits));
+            accumulator <<= _bits;
+            bits -= _bits;
+            return value;
+        }
+        // true when more was read than there was
+        bool overran() const	{ return overrun > bits; }
+
+    private:
+        const uint8_t*	src;
+        const uint8_t*	end;
+        uint64_t		accumulator;
+        int				bits;
+        int				overrun;	// zero bits made up past the end
+    };
+}
+
+//--------------------------------------------------------------
+namespace {
+    void putRice(BitWriter& _writer, Adaptive& _adaptive, uint32_t _value) {
+        int k = _adaptive.k();
+        uint32_t quotient = _value >> k;
+        if (quotient < (uint32_t)escapeLength) {
+            // quotient ones, a zero, the k low bits
+            _writer.put((1u << (quotient + 1)) - 2, quotient + 1);
+            if (k > 0)
+                _writer.put(_value & ((1u << k) - 1), k);
+        }
+        else {
+            _writer.put((1u << escapeLength) - 1, escapeLength);
+            _writer.put(_value, rawBits);
+        }
+        _adaptive.add(_value);
+    }
+
+    uint32_t getRice(BitReader& _reader, Adaptive& _adaptive) {
+        int k = _adaptive.k();
+        int quotient = _reader.ones(escapeLength);
+        uint32_t value;
+        if (quotient < escapeLength) {
+            _reader.get(1);
+            value = ((uint32_t)quotient << k) | _reader.get(k);
+        }
+        else {
+            value = _reader.get(rawBits);
+        }
+        _adaptive.add(value);
+        return value;
+    }
+}
+
+//--------------------------------------------------------------
+size_t DepthCodec::encode(const uint16_t* _depth, int _width, int _height, std::vector<uint8_t>& _dst) {
+    size_t start = _dst.size();
+    BitWriter writer(_dst);
+    Adaptive adaptive[numContexts];
+    Adaptive runs;
+    for (int y=0; y<_height; y++) {
+        const uint16_t* row = _depth + y * _width;
+        bool afterRun = false;
+        for (int x=0; x<_width; x++) {
+            int context;
+            int prediction = predictAt(_depth, x, y, _width, context);
+
+            // flat, code how many pixels carry on at the same depth; the one
+            // that breaks the run is coded on its own
+            if (context == 0 && !afterRun) {
+                int run = 0;
+                while (x + run < _width && row[x + run] == prediction)
+                    run++;
+                putRice(writer, runs, run);
+                x += run - 1;
+                afterRun = true;
+                continue;
+            }
+            afterRun = false;
+
+            int residual = row[x] - prediction;
+            putRice(writer, adaptive[context], residual < 0 ? ((uint32_t)-residual << 1) - 1 : (uint32_t)residual << 1);
+        }
+    }
+    writer.flush();
+    return _dst.size() - start;
+}
+
+//--------------------------------------------------------------
+bool DepthCodec::decode(const uint8_t* _src, size_t _size, int _width, int _height, uint16_t* _depth) {
+    BitReader reader(_src, _size);
+    Adaptive adaptive[numContexts];
+    Adaptive runs;
+    for (int y=0; y<_height; y++) {
+        uint16_t* row = _depth + y * _width;
+        bool afterRun = false;
+        for (int x=0; x<_width; x++) {
+            int context;
+            int prediction = predictAt(_depth, x, y, _width, context);
+
+            if (context == 0 && !afterRun) {
+                int run = getRice(reader, runs);
+                if (run > _width - x)
+                    return false;
+                std::fill(row + x, row + x + run, (uint16_t)prediction);
+                x += run - 1;
+                afterRun = true;
+                continue;
+            }
+            afterRun = false;
+
+            uint32_t value = getRice(reader, adaptive[context]);
+            int residual = value & 1 ? -(int)((value + 1) >> 1) : (int)(value >> 1);
+            row[x] = (uint16_t)(prediction + residual);
+        }
+        if (reader.overran())
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lossless coding of 16 bit depth images, fast enough for every frame of a
+// live sensor. Each pixel is predicted from its left, upper and upper left
+// neighbours with the median edge detector of LOCO-I, which follows both the
+// flat surfaces and the hard edges of a depth map, and the residual is Rice
+// coded with a parameter that adapts to the recent residuals of neighbourhoods
+// as busy as this one. Where it is flat, runs of the same depth are coded as
+// their length instead, a fraction of a bit per pixel. Residuals too
+// large for the code (the jumps between a body and the "no reading" holes)
+// escape to their plain 17 bits. Every image is coded on its own, so any one
+// can be decoded without the others. No openFrameworks.
+
+class DepthCodec {
+public:
+    // appends the coded image to _dst, returns the number of bytes added
+    static size_t	encode(const uint16_t* _depth, int _width, int _height, std::vector<uint8_t>& _dst);
+    // false when _src is not a whole image of that size
+    static bool		decode(const uint8_t* _src, size_t _size, int _width, int _height, uint16_t* _depth);
+};
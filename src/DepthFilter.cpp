@@ -0,0 +1,117 @@
+#include "DepthFilter.h"
+#include "Simd.h"
+
+#include <algorithm>
+
+//--------------------------------------------------------------
+DepthFilter::DepthFilter() {
+    width = 0;
+    height = 0;
+    paddedWidth = 0;
+    gate = 30;
+    smoothing = 0.7f;
+    holdFrames = 2;
+    primed = false;
+    inputFlicker = 0;
+    outputFlicker = 0;
+}
+
+//--------------------------------------------------------------
+void DepthFilter::setup(int _width, int _height) {
+    width = _width;
+    height = _height;
+    paddedWidth = (width + simd::width - 1) / simd::width * simd::width;
+    estimate.assign(paddedWidth * height, 0.0f);
+    previous.assign(paddedWidth * height, 0.0f);
+    age.assign(paddedWidth * height, 0.0f);
+    stepIn.assign(paddedWidth * height, 0.0f);
+    stepOut.assign(paddedWidth * height, 0.0f);
+    depthRow.assign(paddedWidth, 0.0f);
+    outputRow.assign(paddedWidth, 0.0f);
+    reset();
+}
+
+//--------------------------------------------------------------
+void DepthFilter::reset() {
+    primed = false;
+    inputFlicker = 0;
+    outputFlicker = 0;
+}
+
+//--------------------------------------------------------------
+void DepthFilter::process(const uint16_t* _depth, uint16_t* _filtered) {
+    using namespace simd;
+    const vfloat zero = set1(0.0f);
+    const vfloat one = set1(1.0f);
+    const vfloat vgate = set1(gate), vminusGate = set1(-gate);
+    const vfloat atDistance = set1(gate / (2000.0f * 2000.0f));
+    const vfloat least = set1(1 - smoothing), rest = set1(smoothing);
+    const vfloat vhold = set1(holdFrames + 1.0f);
+    // locals, the stores below could alias the members otherwise and keep
+    // the compiler from vectorizing the conversions
+    const int w = width;
+    float* depthFloats = depthRow.data();
+    float* out = outputRow.data();
+    vfloat flickerIn = zero, flickerOut = zero;
+
+    for (int y=0; y<height; y++) {
+        const uint16_t* src = _depth + y * w;
+        for (int x=0; x<w; x++)
+            depthFloats[x] = src[x];
+        int offset = y * paddedWidth;
+        float* e = &estimate[offset];
+        float* p = &previous[offset];
+        float* a = &age[offset];
+        float* si = &stepIn[offset];
+        float* so = &stepOut[offset];
+        if (!primed) {
+            std::copy(depthRow.begin(), depthRow.end(), e);
+            std::copy(depthRow.begin(), depthRow.end(), p);
+            std::fill(a, a + paddedWidth, 0.0f);
+            std::fill(si, si + paddedWidth, 0.0f);
+            std::fill(so, so + paddedWidth, 0.0f);
+        }
+
+        for (int x=0; x<paddedWidth; x+=simd::width) {
+            vfloat d = load(depthFloats + x);
+            vfloat est = load(e + x);
+            // readings are whole mm, so anything but 0 is a reading
+            vfloat valid = min(d, one);
+            vfloat change = sub(d, est);
+            // the share of the change taken: 1 - smoothing for a shimmer,
+            // rising with the square of the change to all of it at the
+            // gate, and all of it where there was no estimate
+            vfloat gateHere = madd(mul(est, est), atDistance, one);
+            vfloat ratio = min(div(max(change, sub(zero, change)), gateHere), one);
+            vfloat alpha = madd(mul(ratio, ratio), rest, least);
+            alpha = max(alpha, sub(one, min(est, one)));
+            vfloat followed = madd(alpha, change, est);
+
+            // no reading: hold, until the hold runs out
+            vfloat frames = mul(add(load(a + x), one), sub(one, valid));
+            vfloat keep = min(max(sub(vhold, frames), zero), one);
+            vfloat held = mul(est, keep);
+            vfloat next = madd(valid, sub(followed, held), held);
+            store(a + x, frames);
+            store(e + x, next);
+            store(out + x, next);
+
+            // a change that undoes the last one is flicker
+            vfloat in = min(max(sub(d, load(p + x)), vminusGate), vgate);
+            vfloat outStep = min(max(sub(next, est), vminusGate), vgate);
+            flickerIn = add(flickerIn, max(sub(zero, mul(in, load(si + x))), zero));
+            flickerOut = add(flickerOut, max(sub(zero, mul(outStep, load(so + x))), zero));
+            store(si + x, in);
+            store(so + x, outStep);
+            store(p + x, d);
+        }
+        uint16_t* dst = _filtered + y * w;
+        for (int x=0; x<w; x++)
+            dst[x] = (uint16_t)(out[x] + 0.5f);
+    }
+    primed = true;
+
+    float pixels = (float)std::max(w * height, 1);
+    inputFlicker = sum(flickerIn) / pixels;
+    outputFlicker = sum(flickerOut) / pixels;
+}
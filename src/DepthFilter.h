@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Steadies a depth image over time before the optical flow sees it. Kinect
+// depth shimmers everywhere, more the further away (its error grows with
+// the square of the distance), and flickers at the edges of things, where
+// pixels come and go between a reading and none; optical flow reads every
+// one of those changes as motion. Each pixel keeps an estimate that follows
+// its readings exponentially, slowly for changes well under the gate and
+// faster as they near it, and takes any change past the gate at once, so a
+// dancer who moves is never smeared. The gate is set for 2 m and grows with
+// the square of the distance like the noise. A pixel that loses its reading
+// holds its estimate for a few frames before it goes blank too. Vectorized
+// across the row with Simd.h, without branches.
+//
+// As it goes it measures the flicker in and out: the energy of the frame to
+// frame changes that turn straight back the next frame, each clamped to the
+// gate. A dancer's movement carries on in the same direction and doesn't
+// count, shimmer and edges that come and go do. No openFrameworks.
+
+class DepthFilter {
+public:
+    DepthFilter();
+
+    void	setup(int _width, int _height);
+
+    // changes past _mm at 2 m are movement and pass untouched
+    void	setGate(float _mm)					{ gate = _mm; }
+    // 0 follows every reading, towards 1 smooths the small changes more
+    void	setSmoothing(float _amount)			{ smoothing = _amount < 0 ? 0 : _amount > 0.99f ? 0.99f : _amount; }
+    // frames a pixel keeps its estimate without a reading
+    void	setHoldFrames(int _frames)			{ holdFrames = _frames < 0 ? 0 : _frames; }
+    void	reset();
+
+    // _depth in, _filtered out, both in mm with 0 for no reading
+    void	process(const uint16_t* _depth, uint16_t* _filtered);
+
+    int		getWidth() const		{ return width; }
+    int		getHeight() const		{ return height; }
+    // the last frame's flicker, mean squared mm a pixel
+    float	getInputFlicker() const		{ return inputFlicker; }
+    float	getOutputFlicker() const	{ return outputFlicker; }
+
+private:
+    int		width;
+    int		height;
+    int		paddedWidth;		// a whole number of vectors
+    float	gate;
+    float	smoothing;
+    int		holdFrames;
+    bool	primed;
+    float	inputFlicker;
+    float	outputFlicker;
+
+    std::vector<float>	estimate;
+    std::vector<float>	previous;	// last frame's readings
+    std::vector<float>	stepIn;		// and the change to them
+    std::vector<float>	stepOut;	// and to the estimate
+    std::vector<float>	age;		// frames since the last reading
+    std::vector<float>	depthRow;
+    std::vector<float>	outputRow;
+};
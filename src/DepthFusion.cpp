@@ -0,0 +1,177 @@
+#include "DepthFusion.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const uint16_t	empty = 0xffff;
+    const float		degrees = 3.14159265f / 180;
+
+    // _a * _b, 3 x 3 row major
+    void multiply(const float* _a, const float* _b, float* _dst) {
+        for (int r=0; r<3; r++) {
+            for (int c=0; c<3; c++)
+                _dst[r * 3 + c] = _a[r * 3] * _b[c] + _a[r * 3 + 1] * _b[3 + c] + _a[r * 3 + 2] * _b[6 + c];
+        }
+    }
+}
+
+//--------------------------------------------------------------
+DepthFusion::DepthFusion() {
+    view = VIEW_FRONT;
+    width = 0;
+    height = 0;
+    Box b = { -4, 4, 0.05f, 2.5f, 0, 8 };
+    box = b;
+}
+
+//--------------------------------------------------------------
+void DepthFusion::setup(View _view, int _width, int _height, const Box& _box) {
+    view = _view;
+    width = _width;
+    height = _height;
+    box = _box;
+    fused.assign(width * height, empty);
+}
+
+//--------------------------------------------------------------
+void DepthFusion::clearSensors() {
+    sensors.clear();
+}
+
+//--------------------------------------------------------------
+int DepthFusion::addSensor(int _width, int _height, const Pose& _pose, float _focal) {
+    Sensor s;
+    s.width = _width;
+    s.height = _height;
+
+    // the camera's right, up and forward in stage coordinates are the
+    // columns of yaw * pitch * roll
+    float cy = cosf(_pose.yaw * degrees), sy = sinf(_pose.yaw * degrees);
+    float cp = cosf(_pose.pitch * degrees), sp = sinf(_pose.pitch * degrees);
+    float cr = cosf(_pose.roll * degrees), sr = sinf(_pose.roll * degrees);
+    float yaw[9] = { cy, 0, -sy,  0, 1, 0,  sy, 0, cy };
+    float pitch[9] = { 1, 0, 0,  0, cp, sp,  0, -sp, cp };
+    float roll[9] = { cr, sr, 0,  -sr, cr, 0,  0, 0, 1 };
+    float yawPitch[9];
+    multiply(yaw, pitch, yawPitch);
+    multiply(yawPitch, roll, s.rotation);
+    s.position[0] = _pose.x;
+    s.position[1] = _pose.y;
+    s.position[2] = _pose.z;
+
+    // the Kinect's depth camera is 580 pixels at 640 across
+    float focal = _focal > 0 ? _focal : 580.0f * _width / 640;
+    float centreX = (_width - 1) * 0.5f, centreY = (_height - 1) * 0.5f;
+    int padded = (_width + simd::width - 1) / simd::width * simd::width;
+    s.rayX.assign(padded, 0.0f);
+    for (int u=0; u<_width; u++)
+        s.rayX[u] = (u - centreX) / focal;
+    s.rayY.resize(_height);
+    for (int v=0; v<_height; v++)
+        s.rayY[v] = (centreY - v) / focal;
+
+    sensors.push_back(s);
+    if ((int)depthRow.size() < padded) {
+        depthRow.assign(padded, 0.0f);
+        column.resize(padded);
+        row.resize(padded);
+        value.resize(padded);
+    }
+    return sensors.size() - 1;
+}
+
+//--------------------------------------------------------------
+void DepthFusion::begin() {
+    std::fill(fused.begin(), fused.end(), empty);
+}
+
+//--------------------------------------------------------------
+void DepthFusion::add(int _sensor, const uint16_t* _depth) {
+    using namespace simd;
+    if (_sensor < 0 || _sensor >= (int)sensors.size())
+        return;
+    const Sensor& s = sensors[_sensor];
+    const float* R = s.rotation;
+
+    // stage metres to the fused image: which stage axis runs across, which
+    // down, and which one the depth is measured along, from where
+    float across = width / (box.maxX - box.minX);
+    float down, depthScale, depthOrigin;
+    int downAxis, depthAxis;
+    if (view == VIEW_FRONT) {
+        downAxis = 1;
+        down = height / (box.maxY - box.minY);
+        depthAxis = 2;
+        depthScale = 1000;
+        depthOrigin = box.minZ;
+    }
+    else {
+        downAxis = 2;
+        down = height / (box.maxZ - box.minZ);
+        depthAxis = 1;
+        depthScale = -1000;
+        depthOrigin = box.maxY;
+    }
+    float downOrigin = downAxis == 1 ? box.maxY : box.maxZ;
+    float depthRange = (view == VIEW_FRONT ? box.maxZ - box.minZ : box.maxY - box.minY) * 1000;
+
+    const vfloat vacross = set1(across), vacrossOrigin = set1(box.minX);
+    const vfloat vdown = set1(down), vdownOrigin = set1(downOrigin);
+    const vfloat vdepthScale = set1(depthScale), vdepthOrigin = set1(depthOrigin);
+    const vfloat r0 = set1(R[0]), r3 = set1(R[3]), r6 = set1(R[6]);
+    const vfloat p0 = set1(s.position[0]), p1 = set1(s.position[1]), p2 = set1(s.position[2]);
+    const vfloat toMetres = set1(0.001f);
+    float* depthFloats = depthRow.data();
+    float* columns = column.data();
+    float* rows = row.data();
+    float* values = value.data();
+    uint16_t* dst = fused.data();
+    const int w = s.width;
+    const int fusedWidth = width, fusedHeight = height;
+
+    for (int v=0; v<s.height; v++) {
+        const uint16_t* src = _depth + v * w;
+        for (int u=0; u<w; u++)
+            depthFloats[u] = src[u];
+
+        // a point is rayX d along right, rayY d along up and d forward,
+        // the last two the same for the whole row
+        float ry = s.rayY[v];
+        vfloat a0 = set1(R[1] * ry + R[2]);
+        vfloat a1 = set1(R[4] * ry + R[5]);
+        vfloat a2 = set1(R[7] * ry + R[8]);
+        for (int u=0; u<w; u+=simd::width) {
+            vfloat d = mul(load(depthFloats + u), toMetres);
+            vfloat x = mul(load(&s.rayX[u]), d);
+            vfloat sx = madd(x, r0, madd(d, a0, p0));
+            vfloat sy = madd(x, r3, madd(d, a1, p1));
+            vfloat sz = madd(x, r6, madd(d, a2, p2));
+            vfloat onDown = downAxis == 1 ? sy : sz;
+            vfloat onDepth = depthAxis == 2 ? sz : sy;
+            store(columns + u, mul(sub(sx, vacrossOrigin), vacross));
+            store(rows + u, mul(sub(vdownOrigin, onDown), vdown));
+            store(values + u, mul(sub(onDepth, vdepthOrigin), vdepthScale));
+        }
+
+        // nearest to the viewer wins
+        for (int u=0; u<w; u++) {
+            float c = columns[u], r = rows[u], z = values[u];
+            if (src[u] == 0 || c < 0 || r < 0 || z < 0 || z > depthRange)
+                continue;
+            int fx = (int)c, fy = (int)r;
+            if (fx >= fusedWidth || fy >= fusedHeight)
+                continue;
+            uint16_t mm = (uint16_t)std::max(1.0f, z);
+            uint16_t& out = dst[fy * fusedWidth + fx];
+            out = std::min(out, mm);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void DepthFusion::end(uint16_t* _dst) {
+    for (int i=0; i<width * height; i++)
+        _dst[i] = fused[i] == empty ? 0 : fused[i];
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Stitches the depth of several sensors into one depth image of the stage.
+// Everything is placed in stage coordinates, metres: x across the stage to
+// the right as the audience sees it, y up from the floor, z away from the
+// audience. Each sensor has a pose there (where it stands, and its yaw,
+// pitch and roll, degrees) and pinhole intrinsics. The fused image is an
+// orthographic view of a box of the stage, either from the front (x across,
+// y up, the depth the distance from the front of the box) or from above
+// (x across, z up the image, the depth the distance down from the top of
+// the box), in millimetres like a sensor's, so everything downstream takes
+// it as it would a Kinect's. Points outside the box are dropped, which with
+// the bottom of the box a little off the floor drops the floor too.
+//
+// Each sensor's pixels are turned into stage points a row at a time with
+// Simd.h: the camera ray of a pixel separates into a column and a row part,
+// so a point is the ray scaled by the depth and moved by the pose, nine
+// multiply-adds. The points are then splatted into the fused image keeping
+// the one nearest the viewer. The cost is one pass over each sensor's
+// pixels. No openFrameworks.
+
+class DepthFusion {
+public:
+    enum View {
+        VIEW_FRONT = 0,
+        VIEW_TOP
+    };
+
+    struct Box {
+        float	minX, maxX;
+        float	minY, maxY;
+        float	minZ, maxZ;
+    };
+
+    struct Pose {
+        float	x, y, z;				// metres
+        float	yaw, pitch, roll;		// degrees; yaw left, pitch up, roll clockwise
+    };
+
+    DepthFusion();
+
+    void	setup(View _view, int _width, int _height, const Box& _box);
+    // returns the sensor's index; _focal in pixels, 0 for the Kinect's
+    int		addSensor(int _width, int _height, const Pose& _pose, float _focal = 0);
+    void	clearSensors();
+
+    // begin(), add() each sensor's latest frame, then end() into _dst
+    void	begin();
+    void	add(int _sensor, const uint16_t* _depth);
+    void	end(uint16_t* _dst);
+
+    int		getWidth() const			{ return width; }
+    int		getHeight() const			{ return height; }
+    int		getNumSensors() const		{ return sensors.size(); }
+    View	getView() const				{ return view; }
+
+private:
+    struct Sensor {
+        int		width, height;
+        float	rotation[9];			// camera to stage, row major
+        float	position[3];
+        std::vector<float>	rayX;		// x / z of each column
+        std::vector<float>	rayY;		// y / z of each row, up
+    };
+
+    View	view;
+    int		width;
+    int		height;
+    Box		box;
+
+    std::vector<Sensor>		sensors;
+    std::vector<uint16_t>	fused;
+    std::vector<float>		depthRow;
+    std::vector<float>		column;		// a row's pixels in the fused image
+    std::vector<float>		row;
+    std::vector<float>		value;		// mm from the viewer
+};
@@ -0,0 +1,203 @@
+#include "DepthPlayer.h"
+
+#include <sys/stat.h>
+#ifndef TARGET_WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//--------------------------------------------------------------
+DepthPlayer::DepthPlayer() {
+    data = NULL;
+    dataSize = 0;
+    index = NULL;
+    memset(&header, 0, sizeof(header));
+    seekMicros = -1;
+    playedMicros = 0;
+    threadRealtime = true;
+    threadLoop = true;
+
+    parameters.setName("depth player");
+    parameters.add(realtime.set("realtime", true));
+    parameters.add(loop.set("loop", true));
+    parameters.add(position.set("position", 0, 0, 3600));
+    realtime.addListener(this, &DepthPlayer::setRealtime);
+    loop.addListener(this, &DepthPlayer::setLoop);
+}
+
+//--------------------------------------------------------------
+DepthPlayer::~DepthPlayer() {
+    close();
+}
+
+//--------------------------------------------------------------
+string DepthPlayer::findNewest() {
+    // the recorder stamps its names down to the second, so the last one in
+    // name order is the newest, and its unfinished .tmp files are left out
+    ofDirectory dir(ofToDataPath("", true));
+    dir.allowExt("grvd");
+    dir.listDir();
+    string newest;
+    for (size_t f=0; f<dir.size(); f++) {
+        string name = dir.getName(f);
+        if (name.compare(0, 6, "depth-") == 0 && name > newest)
+            newest = name;
+    }
+    return newest;
+}
+
+//--------------------------------------------------------------
+bool DepthPlayer::load(const string& _path) {
+    close();
+    string path = ofToDataPath(_path, true);
+    if (!ofFile::doesFileExist(path, false))
+        return false;
+
+#ifndef TARGET_WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(DepthFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    data = (const char*)mapped;
+    dataSize = info.st_size;
+#else
+    fallbackBuffer = ofBufferFromFile(path, true);
+    data = fallbackBuffer.getData();
+    dataSize = fallbackBuffer.size();
+#endif
+
+    // the index has to be there and point inside the file
+    bool valid = dataSize >= sizeof(header);
+    if (valid)
+        memcpy(&header, data, sizeof(header));
+    valid = valid && memcmp(header.magic, "GRVD", 4) == 0 &&
+        header.version == 1 &&
+        header.width > 0 && header.height > 0 &&
+        header.numFrames > 0 &&
+        header.indexOffset >= sizeof(header) &&
+        header.indexOffset + (uint64_t)header.numFrames * sizeof(DepthFileIndex) == dataSize;
+    if (valid) {
+        index = (const DepthFileIndex*)(data + header.indexOffset);
+        for (int f=0; f<header.numFrames && valid; f++)
+            valid = index[f].offset + sizeof(DepthFileFrame) <= header.indexOffset;
+    }
+    if (!valid) {
+        ofLogError("DepthPlayer") << path << " is not a depth recording";
+        close();
+        return false;
+    }
+
+    ofLogNotice("DepthPlayer") << "mapped " << path << ": " << header.numFrames << " frames, " << getDuration() << " s";
+    startThread();
+    return true;
+}
+
+//--------------------------------------------------------------
+void DepthPlayer::close() {
+    if (isThreadRunning())
+        waitForThread(true);
+#ifndef TARGET_WIN32
+    if (data != NULL)
+        munmap((void*)data, dataSize);
+#endif
+    fallbackBuffer = ofBuffer();
+    data = NULL;
+    dataSize = 0;
+    index = NULL;
+    memset(&header, 0, sizeof(header));
+}
+
+//--------------------------------------------------------------
+double DepthPlayer::getDuration() const {
+    return index != NULL ? index[header.numFrames - 1].micros / 1000000.0 : 0.0;
+}
+
+//--------------------------------------------------------------
+bool DepthPlayer::update() {
+    position.set(playedMicros.load() / 1000000.0f);
+    return DepthSource::update();
+}
+
+//--------------------------------------------------------------
+int DepthPlayer::findFrame(uint64_t _micros) const {
+    int lo = 0, hi = header.numFrames;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (index[mid].micros < _micros)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return min(lo, header.numFrames - 1);
+}
+
+//--------------------------------------------------------------
+bool DepthPlayer::decode(int _frame, DepthFrame& _dst) const {
+    DepthFileFrame frame;
+    memcpy(&frame, data + index[_frame].offset, sizeof(frame));
+    const uint8_t* coded = (const uint8_t*)data + index[_frame].offset + sizeof(frame);
+    if (index[_frame].offset + sizeof(frame) + frame.bytes > header.indexOffset)
+        return false;
+    _dst.rawDepth.allocate(header.width, header.height, 1);
+    return DepthCodec::decode(coded, frame.bytes, header.width, header.height, _dst.rawDepth.getData());
+}
+
+//--------------------------------------------------------------
+void DepthPlayer::threadedFunction() {
+    // wall clock time at which the recording's time zero plays
+    int frame = 0;
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+
+    while (isThreadRunning()) {
+        int64_t seek = seekMicros.exchange(-1);
+        if (seek >= 0) {
+            frame = findFrame(seek);
+            startMicros = ofGetElapsedTimeMicros() - index[frame].micros;
+        }
+        if (frame >= header.numFrames) {
+            if (!threadLoop.load()) {
+                sleep(10);
+                continue;
+            }
+            frame = 0;
+            startMicros = ofGetElapsedTimeMicros();
+        }
+
+        uint64_t now = ofGetElapsedTimeMicros();
+        if (threadRealtime.load()) {
+            uint64_t due = startMicros + index[frame].micros;
+            if (now < due) {
+                sleep(min<uint64_t>((due - now) / 1000, 10));
+                continue;
+            }
+        }
+        else {
+            // flat out, but every frame gets to the render thread
+            if (isPublishedFrameWaiting()) {
+                sleep(0);
+                continue;
+            }
+            startMicros = now - index[frame].micros;
+        }
+
+        DepthFrame& back = getBackFrame();
+        if (decode(frame, back)) {
+            back.capturedMicros = ofGetElapsedTimeMicros();
+            playedMicros.store(index[frame].micros);
+            publish();
+        }
+        else {
+            ofLogWarning("DepthPlayer") << "frame " << frame << " does not decode";
+        }
+        frame++;
+    }
+}
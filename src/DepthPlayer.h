@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ofMain.h"
+#include "DepthSource.h"
+#include "DepthRecorder.h"
+
+// Plays a DepthRecorder file back as a DepthSource, in place of the Kinect,
+// so the installation can be rehearsed and benchmarked on any machine. The
+// file is memory mapped and each frame decoded on the player's thread when
+// it is due: at the recorded pace, or, with realtime off, as fast as the
+// render thread takes them (none are dropped then, which is what a benchmark
+// wants). Loops at the end when asked to; seek() jumps through the index.
+
+class DepthPlayer : public DepthSource {
+public:
+    DepthPlayer();
+    ~DepthPlayer();
+
+    bool	load(const string& _path);
+    // the last recording DepthRecorder left in the data folder, empty if none
+    static string	findNewest();
+    void	close();
+    bool	isLoaded() const		{ return data != NULL; }
+
+    int		getWidth() const		{ return header.width; }
+    int		getHeight() const		{ return header.height; }
+    int		getNumFrames() const	{ return header.numFrames; }
+    double	getDuration() const;	// seconds
+
+    // render thread, also publishes the position to the gui
+    bool	update();
+    // any thread
+    void	seek(double _seconds)	{ seekMicros.store(max(0.0, _seconds) * 1000000); }
+
+protected:
+    void	threadedFunction();
+    int		findFrame(uint64_t _micros) const;
+    bool	decode(int _frame, DepthFrame& _dst) const;
+
+    ofParameter<bool>	realtime;
+    ofParameter<bool>	loop;
+    ofParameter<float>	position;	// seconds, readout
+
+    const char*				data;
+    size_t					dataSize;
+    ofBuffer				fallbackBuffer;
+    DepthFileHeader			header;
+    const DepthFileIndex*	index;
+
+    std::atomic<int64_t>	seekMicros;		// -1 when there is nothing to seek to
+    std::atomic<uint64_t>	playedMicros;	// recording time of the last frame published
+    std::atomic<bool>		threadRealtime;
+    std::atomic<bool>		threadLoop;
+    void					setRealtime(bool& _value)	{ threadRealtime.store(_value); }
+    void					setLoop(bool& _value)		{ threadLoop.store(_value); }
+};
@@ -0,0 +1,73 @@
+#include "DepthProjector.h"
+#include "Simd.h"
+
+//--------------------------------------------------------------
+DepthProjector::DepthProjector() {
+    width = 0;
+    height = 0;
+    nearClip = 500;
+    farClip = 4000;
+}
+
+//--------------------------------------------------------------
+void DepthProjector::setup(int _width, int _height, float _focal) {
+    width = _width;
+    height = _height;
+    int padded = (width + simd::width - 1) / simd::width * simd::width;
+    rayX.assign(padded, 0.0f);
+    rayY.resize(height);
+    depthRow.assign(padded, 0.0f);
+
+    // the Kinect's depth camera is 580 pixels at 640 across
+    float focal = _focal > 0 ? _focal : 580.0f * width / 640;
+    float centreX = (width - 1) * 0.5f, centreY = (height - 1) * 0.5f;
+    for (int x=0; x<width; x++)
+        rayX[x] = (x - centreX) / focal;
+    for (int y=0; y<height; y++)
+        rayY[y] = (centreY - y) / focal;
+}
+
+//--------------------------------------------------------------
+void DepthProjector::project(const uint16_t* _depth, float* _xs, float* _ys, float* _zs) {
+    using namespace simd;
+    const vfloat zero = set1(0.0f);
+    const vfloat one = set1(1.0f);
+    const vfloat half = set1(0.5f);
+    // turns a difference in mm into a step, 0 below and 1 above
+    const vfloat steep = set1(1e6f);
+    const vfloat vnear = set1(nearClip), vfar = set1(farClip);
+    const vfloat toMetres = set1(-0.001f);
+    const int w = width;
+    const int whole = w / simd::width * simd::width;
+    float* depthFloats = depthRow.data();
+    const float* rays = rayX.data();
+
+    for (int y=0; y<height; y++) {
+        const uint16_t* src = _depth + y * w;
+        for (int x=0; x<w; x++)
+            depthFloats[x] = src[x];
+        float* xs = _xs + y * w;
+        float* ys = _ys + y * w;
+        float* zs = _zs + y * w;
+        const vfloat ry = set1(rayY[y]);
+
+        // the planes are packed row after row, so the last part vector of
+        // a row is done on its own rather than written over the next
+        for (int x=0; x<whole; x+=simd::width) {
+            vfloat d = load(depthFloats + x);
+            vfloat pastNear = min(max(mul(add(sub(d, vnear), half), steep), zero), one);
+            vfloat beforeFar = min(max(mul(add(sub(vfar, d), half), steep), zero), one);
+            vfloat z = mul(mul(d, toMetres), mul(pastNear, beforeFar));
+            store(xs + x, mul(sub(zero, load(rays + x)), z));
+            store(ys + x, mul(sub(zero, ry), z));
+            store(zs + x, z);
+        }
+        for (int x=whole; x<w; x++) {
+            float d = depthFloats[x];
+            float z = d >= nearClip && d <= farClip ? d * -0.001f : 0.0f;
+            xs[x] = -rays[x] * z;
+            ys[x] = -rayY[y] * z;
+            zs[x] = z;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Turns a depth image back into the points it saw, in the camera's frame in
+// metres: x to the right, y up and z towards the camera, so the scene lies
+// down the negative z axis the way OpenGL looks. The pinhole ray of a pixel
+// separates into a column and a row part, so each point is two multiplies
+// of the depth; a row at a time with Simd.h, without branches. The points
+// are written as three planes, every x, then every y, then every z, which
+// is how the vectors come out and how a vertex buffer can take them as
+// three attributes. Readings outside the near / far range and holes come
+// out with z 0. No openFrameworks.
+
+class DepthProjector {
+public:
+    DepthProjector();
+
+    // _focal in pixels, 0 for the Kinect's depth camera
+    void	setup(int _width, int _height, float _focal = 0);
+    void	setRange(float _nearMM, float _farMM)	{ nearClip = _nearMM; farClip = _farMM; }
+
+    // _xs, _ys and _zs each hold getNumPoints() floats
+    void	project(const uint16_t* _depth, float* _xs, float* _ys, float* _zs);
+
+    int		getWidth() const		{ return width; }
+    int		getHeight() const		{ return height; }
+    int		getNumPoints() const	{ return width * height; }
+
+private:
+    int		width;
+    int		height;
+    float	nearClip;
+    float	farClip;
+    std::vector<float>	rayX;		// x / z of each column, padded to a whole vector
+    std::vector<float>	rayY;		// y / z of each row
+    std::vector<float>	depthRow;
+};
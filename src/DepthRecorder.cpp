@@ -0,0 +1,173 @@
+#include "DepthRecorder.h"
+
+#include <climits>
+
+namespace {
+    const char		magic[4] = { 'G', 'R', 'V', 'D' };
+    const uint32_t	version = 1;
+}
+
+//--------------------------------------------------------------
+DepthRecorder::DepthRecorder() {
+    output = NULL;
+    recording = false;
+    numRecorded = 0;
+    numDropped = 0;
+    bytesWritten = 0;
+    bytesRaw = 0;
+    firstMicros = 0;
+    failed = false;
+
+    // half a second of frames for the disk to catch up in
+    pending.setup(16);
+
+    parameters.setName("depth recorder");
+    parameters.add(record.set("record", false));
+    parameters.add(file.set("file", ""));
+    parameters.add(recorded.set("frames", 0, 0, INT_MAX));
+    parameters.add(dropped.set("dropped", 0, 0, INT_MAX));
+    parameters.add(megabytes.set("MB", 0, 0, 100000));
+    parameters.add(ratio.set("ratio", 0, 0, 50));
+    record.addListener(this, &DepthRecorder::setRecord);
+}
+
+//--------------------------------------------------------------
+DepthRecorder::~DepthRecorder() {
+    stop();
+}
+
+//--------------------------------------------------------------
+void DepthRecorder::setRecord(bool& _value) {
+    if (_value == isRecording())
+        return;
+    if (_value) {
+        if (!start(ofToDataPath("depth-" + ofGetTimestampString("%Y%m%d-%H%M%S") + ".grvd", true)))
+            record.setWithoutEventNotifications(false);
+    }
+    else
+        stop();
+}
+
+//--------------------------------------------------------------
+bool DepthRecorder::start(const string& _path) {
+    stop();
+    path = _path;
+    output = fopen((path + ".tmp").c_str(), "wb");
+    if (output == NULL) {
+        ofLogError("DepthRecorder") << "could not write " << path << ".tmp";
+        return false;
+    }
+    memset(&header, 0, sizeof(header));
+    index.clear();
+    index.reserve(30 * 60 * 60);
+    firstMicros = 0;
+    failed = false;
+    numRecorded = 0;
+    numDropped = 0;
+    bytesWritten = 0;
+    bytesRaw = 0;
+    pending.clear();
+    file.set(ofFilePath::getFileName(path));
+
+    startThread();
+    recording = true;
+    return true;
+}
+
+//--------------------------------------------------------------
+void DepthRecorder::stop() {
+    if (!isRecording())
+        return;
+    recording = false;
+    waitForThread(true);
+
+    // the index, then the header with the frame count and where it is
+    bool written = !failed;
+    if (written && header.numFrames > 0) {
+        header.indexOffset = ftell(output);
+        written = fwrite(index.data(), index.size() * sizeof(DepthFileIndex), 1, output) == 1 &&
+            fseek(output, 0, SEEK_SET) == 0 &&
+            fwrite(&header, sizeof(header), 1, output) == 1;
+    }
+    written = fclose(output) == 0 && written;
+    output = NULL;
+    if (header.numFrames == 0) {
+        ofLogNotice("DepthRecorder") << "no frames came in, nothing recorded";
+        ofFile::removeFile(path + ".tmp", false);
+    }
+    else if (!written || !ofFile::moveFromTo(path + ".tmp", path, false, true)) {
+        ofLogError("DepthRecorder") << "could not write " << path;
+        ofFile::removeFile(path + ".tmp", false);
+    }
+    else {
+        ofLogNotice("DepthRecorder") << "recorded " << header.numFrames << " frames to " << path;
+    }
+    record.setWithoutEventNotifications(false);
+}
+
+//--------------------------------------------------------------
+void DepthRecorder::update() {
+    recorded.set(numRecorded.load());
+    dropped.set(numDropped.load());
+    megabytes.set(bytesWritten.load() / (1024.0f * 1024.0f));
+    ratio.set(bytesWritten.load() > 0 ? (float)bytesRaw.load() / bytesWritten.load() : 0.0f);
+}
+
+//--------------------------------------------------------------
+void DepthRecorder::add(const DepthFrame& _frame) {
+    if (!recording.load(std::memory_order_relaxed))
+        return;
+    if (!pending.push(_frame))
+        numDropped++;
+}
+
+//--------------------------------------------------------------
+void DepthRecorder::threadedFunction() {
+    // drains what is queued before stopping
+    while (isThreadRunning() || !pending.empty()) {
+        if (!pending.pop(frame)) {
+            sleep(1);
+            continue;
+        }
+        if (!failed && !write(frame)) {
+            ofLogError("DepthRecorder") << "could not write " << path;
+            failed = true;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+bool DepthRecorder::write(const DepthFrame& _frame) {
+    int width = _frame.rawDepth.getWidth();
+    int height = _frame.rawDepth.getHeight();
+    if (header.numFrames == 0) {
+        memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.width = width;
+        header.height = height;
+        firstMicros = _frame.capturedMicros;
+        if (fwrite(&header, sizeof(header), 1, output) != 1)
+            return false;
+    }
+    if (width != header.width || height != header.height)
+        return true;
+
+    coded.clear();
+    DepthFileFrame frameHeader;
+    frameHeader.micros = _frame.capturedMicros - firstMicros;
+    frameHeader.bytes = DepthCodec::encode(_frame.rawDepth.getData(), width, height, coded);
+    frameHeader.flags = 0;
+
+    DepthFileIndex entry;
+    entry.offset = ftell(output);
+    entry.micros = frameHeader.micros;
+    if (fwrite(&frameHeader, sizeof(frameHeader), 1, output) != 1 || fwrite(coded.data(), coded.size(), 1, output) != 1)
+        return false;
+    index.push_back(entry);
+    header.numFrames++;
+
+    numRecorded++;
+    bytesWritten += sizeof(frameHeader) + coded.size();
+    bytesRaw += width * height * sizeof(uint16_t);
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ofMain.h"
+#include "DepthSource.h"
+#include "DepthCodec.h"
+#include "SpscRing.h"
+
+// Depth recording file (.grvd): a header, then one record per frame (a
+// DepthFileFrame and its DepthCodec image), then an index of every frame's
+// offset and time for seeking. numFrames and indexOffset are filled in when
+// the recording is closed.
+struct DepthFileHeader {
+    char		magic[4];		// GRVD
+    uint32_t	version;
+    int32_t		width;
+    int32_t		height;
+    uint32_t	flags;			// reserved, 0
+    int32_t		numFrames;
+    uint64_t	indexOffset;
+};
+
+struct DepthFileFrame {
+    uint64_t	micros;			// since the first frame
+    uint32_t	bytes;			// of the coded image that follows
+    uint32_t	flags;			// reserved, 0
+};
+
+struct DepthFileIndex {
+    uint64_t	offset;			// of the DepthFileFrame
+    uint64_t	micros;
+};
+
+// Records what a DepthSource captures, so a performance can be replayed and
+// benchmarked without the sensor. The source's thread hands every frame over
+// through a lock free ring; the recorder's own thread compresses and writes
+// them, so a slow disk drops recorded frames (counted) rather than stalling
+// the capture. The file is written next to its final name and renamed when
+// the recording stops. The depth only, the sensor's infrared is not streamed.
+
+class DepthRecorder : public ofThread {
+public:
+    DepthRecorder();
+    ~DepthRecorder();
+
+    bool	start(const string& _path);
+    void	stop();
+    bool	isRecording() const		{ return recording.load(); }
+
+    ofParameterGroup	parameters;
+
+    // render thread, publishes the counts to the gui
+    void	update();
+
+    // source thread
+    void	add(const DepthFrame& _frame);
+
+protected:
+    void	threadedFunction();
+    bool	write(const DepthFrame& _frame);
+
+    ofParameter<bool>	record;
+    void				setRecord(bool& _value);
+    ofParameter<string>	file;
+    ofParameter<int>	recorded;
+    ofParameter<int>	dropped;
+    ofParameter<float>	megabytes;
+    ofParameter<float>	ratio;		// raw size over recorded size
+
+    string					path;
+    FILE*					output;
+    SpscRing<DepthFrame>	pending;
+    std::atomic<bool>		recording;
+    std::atomic<int>		numRecorded;
+    std::atomic<int>		numDropped;
+    std::atomic<uint64_t>	bytesWritten;
+    std::atomic<uint64_t>	bytesRaw;
+
+    // writer thread only
+    DepthFileHeader			header;
+    vector<DepthFileIndex>	index;
+    vector<uint8_t>			coded;
+    DepthFrame				frame;
+    uint64_t				firstMicros;
+    bool					failed;
+};
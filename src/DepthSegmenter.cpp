@@ -0,0 +1,163 @@
+#include "DepthSegmenter.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // what the closing grows the mask with, and what it shrinks it with
+    struct Grow {
+        static uint8_t	apply(uint8_t _a, uint8_t _b)	{ return _a > _b ? _a : _b; }
+    };
+    struct Shrink {
+        static uint8_t	apply(uint8_t _a, uint8_t _b)	{ return _a < _b ? _a : _b; }
+    };
+
+    // 2 _radius + 1 pixels across, the guards either side of a row hold its
+    // edge; each inner loop is one the compiler vectorizes
+    template <class Op>
+    void filterRows(const uint8_t* _src, uint8_t* _dst, int _width, int _height, int _stride, int _radius) {
+        for (int y=0; y<_height; y++) {
+            const uint8_t* s = _src + y * _stride;
+            uint8_t* d = _dst + y * _stride;
+            std::copy(s, s + _width, d);
+            for (int k=1; k<=_radius; k++) {
+                const uint8_t* left = s - k;
+                const uint8_t* right = s + k;
+                for (int x=0; x<_width; x++)
+                    d[x] = Op::apply(d[x], Op::apply(left[x], right[x]));
+            }
+        }
+    }
+
+    // 2 _radius + 1 rows down, the first and last standing in for the ones
+    // past the edge
+    template <class Op>
+    void filterColumns(const uint8_t* _src, uint8_t* _dst, int _width, int _height, int _stride, int _radius) {
+        for (int y=0; y<_height; y++) {
+            const uint8_t* s = _src + y * _stride;
+            uint8_t* d = _dst + y * _stride;
+            std::copy(s, s + _width, d);
+            for (int k=1; k<=_radius; k++) {
+                const uint8_t* up = _src + std::max(y - k, 0) * _stride;
+                const uint8_t* down = _src + std::min(y + k, _height - 1) * _stride;
+                for (int x=0; x<_width; x++)
+                    d[x] = Op::apply(d[x], Op::apply(up[x], down[x]));
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+DepthSegmenter::DepthSegmenter() {
+    width = 0;
+    height = 0;
+    paddedWidth = 0;
+    guard = maxFillRadius;
+    stride = 0;
+    nearClip = 500;
+    farClip = 4000;
+    threshold = 150;
+    rise = 50;
+    fall = 0.1f;
+    fillRadius = 2;
+    learned = false;
+    coverage = 0;
+}
+
+//--------------------------------------------------------------
+void DepthSegmenter::setup(int _width, int _height) {
+    width = _width;
+    height = _height;
+    paddedWidth = (width + simd::width - 1) / simd::width * simd::width;
+    stride = width + 2 * guard;
+    background.assign(paddedWidth * height, 0.0f);
+    depthRow.assign(paddedWidth, 0.0f);
+    foregroundRow.assign(paddedWidth, 0.0f);
+    planeA.assign(stride * height, 0);
+    planeB.assign(stride * height, 0);
+    learned = false;
+    coverage = 0;
+}
+
+//--------------------------------------------------------------
+void DepthSegmenter::padRows(uint8_t* _plane) {
+    for (int y=0; y<height; y++) {
+        uint8_t* r = _plane + y * stride + guard;
+        memset(r - guard, r[0], guard);
+        memset(r + width, r[width - 1], guard);
+    }
+}
+
+//--------------------------------------------------------------
+void DepthSegmenter::closeMask() {
+    // the result back in plane A
+    if (fillRadius == 0)
+        return;
+    padRows(planeA.data());
+    filterRows<Grow>(row(planeA, 0), row(planeB, 0), width, height, stride, fillRadius);
+    filterColumns<Grow>(row(planeB, 0), row(planeA, 0), width, height, stride, fillRadius);
+    padRows(planeA.data());
+    filterRows<Shrink>(row(planeA, 0), row(planeB, 0), width, height, stride, fillRadius);
+    filterColumns<Shrink>(row(planeB, 0), row(planeA, 0), width, height, stride, fillRadius);
+}
+
+//--------------------------------------------------------------
+void DepthSegmenter::process(const uint16_t* _depth, uint8_t* _mask, bool _mirror) {
+    using namespace simd;
+    const vfloat zero = set1(0.0f);
+    const vfloat one = set1(1.0f);
+    const vfloat half = set1(0.5f);
+    // turns a difference in mm into a step, 0 below and 1 above
+    const vfloat steep = set1(1e6f);
+    const vfloat vnear = set1(nearClip), vfar = set1(farClip);
+    const vfloat vthreshold = set1(threshold);
+    const vfloat vrise = set1(rise), vfall = set1(-fall);
+    // locals, the byte stores below could alias the members otherwise and
+    // keep the compiler from vectorizing the conversions
+    const int w = width;
+    float* depthFloats = depthRow.data();
+    float* foreground = foregroundRow.data();
+
+    for (int y=0; y<height; y++) {
+        const uint16_t* src = _depth + y * w;
+        for (int x=0; x<w; x++)
+            depthFloats[x] = src[x];
+        float* bg = &background[y * paddedWidth];
+        if (!learned)
+            std::copy(depthRow.begin(), depthRow.end(), bg);
+
+        for (int x=0; x<paddedWidth; x+=simd::width) {
+            vfloat d = load(depthFloats + x);
+            vfloat b = load(bg + x);
+            // readings are whole mm, so anything but 0 is a reading
+            vfloat valid = min(d, one);
+            vfloat nearer = min(max(mul(sub(sub(b, d), vthreshold), steep), zero), one);
+            vfloat pastNear = min(max(mul(add(sub(d, vnear), half), steep), zero), one);
+            vfloat beforeFar = min(max(mul(add(sub(vfar, d), half), steep), zero), one);
+            store(foreground + x, mul(mul(nearer, valid), mul(pastNear, beforeFar)));
+            // no reading, no learning
+            vfloat step = mul(min(max(sub(d, b), vfall), vrise), valid);
+            store(bg + x, add(b, step));
+        }
+        uint8_t* fg = row(planeA, y);
+        for (int x=0; x<w; x++)
+            fg[x] = foreground[x] > 0.5f ? 255 : 0;
+    }
+    learned = true;
+
+    closeMask();
+
+    int count = 0;
+    for (int y=0; y<height; y++) {
+        const uint8_t* fg = row(planeA, y);
+        uint8_t* dst = _mask + y * w;
+        if (_mirror)
+            std::reverse_copy(fg, fg + w, dst);
+        else
+            std::copy(fg, fg + w, dst);
+        for (int x=0; x<w; x++)
+            count += fg[x] >> 7;
+    }
+    coverage = w * height > 0 ? (float)count / (w * height) : 0.0f;
+}
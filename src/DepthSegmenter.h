@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Splits a depth image into the people in front of the room and the room.
+// Every pixel keeps a running estimate of the background depth that climbs
+// quickly towards anything further away and sinks slowly towards anything
+// nearer, a median biased to the far side of the sensor noise: a dancer
+// who walks past never gets into it, one who stands still for long enough
+// eventually does, and furniture moved to a new place is learned in a few
+// seconds. A pixel is foreground when it is nearer than its background by
+// more than the threshold and inside the near / far range; the model and
+// the test are vectorized across the row with Simd.h, without branches.
+// Holes (the sensor's shadows, missing readings) are filled by a closing,
+// the mask dilated and then eroded by a square of the fill radius, one
+// pass across and one down each, on bytes so the compiler can take 16 or
+// 32 pixels at a time. No openFrameworks.
+
+class DepthSegmenter {
+public:
+    static const int	maxFillRadius = 8;
+
+    DepthSegmenter();
+
+    void	setup(int _width, int _height);
+
+    void	setRange(float _nearMM, float _farMM)	{ nearClip = _nearMM; farClip = _farMM; }
+    void	setThreshold(float _mm)					{ threshold = _mm; }
+    // how far the background may move each frame, away from the camera and
+    // towards it
+    void	setLearning(float _riseMM, float _fallMM)	{ rise = _riseMM; fall = _fallMM; }
+    void	setFillRadius(int _pixels)				{ fillRadius = _pixels < 0 ? 0 : _pixels > maxFillRadius ? maxFillRadius : _pixels; }
+    // the next frame is taken as the background as it is
+    void	relearn()								{ learned = false; }
+
+    // _depth in mm, 0 for no reading; _mask 255 for foreground, mirrored
+    // left to right if asked (the background stays the camera's way round)
+    void	process(const uint16_t* _depth, uint8_t* _mask, bool _mirror);
+
+    int		getWidth() const		{ return width; }
+    int		getHeight() const		{ return height; }
+    // share of the image that was foreground, 0 .. 1
+    float	getCoverage() const		{ return coverage; }
+    // mm, row by row with getStride() floats apart
+    const float*	getBackground() const	{ return background.data(); }
+    int		getStride() const		{ return paddedWidth; }
+
+private:
+    void	closeMask();
+    void	padRows(uint8_t* _plane);
+    uint8_t*	row(std::vector<uint8_t>& _plane, int _y)	{ return &_plane[_y * stride + guard]; }
+
+    int		width;
+    int		height;
+    int		paddedWidth;		// a whole number of vectors
+    int		guard;				// bytes either side of a mask row
+    int		stride;				// bytes per mask row
+    float	nearClip;
+    float	farClip;
+    float	threshold;
+    float	rise;
+    float	fall;
+    int		fillRadius;
+    bool	learned;
+    float	coverage;
+
+    std::vector<float>	background;
+    std::vector<float>	depthRow;
+    std::vector<float>	foregroundRow;	// 0 / 1
+    std::vector<uint8_t>	planeA;		// the mask as 0 / 255, ping
+    std::vector<uint8_t>	planeB;		// and pong
+};
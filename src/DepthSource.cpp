@@ -0,0 +1,58 @@
+#include "DepthSource.h"
+#include "DepthRecorder.h"
+
+#include <climits>
+
+//--------------------------------------------------------------
+DepthSource::DepthSource() {
+    recorder = NULL;
+    numPublished = 0;
+    numDropped = 0;
+    numDelivered = 0;
+    numReused = 0;
+    for (int i=0; i<3; i++) {
+        frames.getSlot(i).sequence = 0;
+        frames.getSlot(i).capturedMicros = 0;
+    }
+
+    parameters.add(delivered.set("delivered", 0, 0, INT_MAX));
+    parameters.add(dropped.set("dropped", 0, 0, INT_MAX));
+    parameters.add(reused.set("reused", 0, 0, INT_MAX));
+}
+
+//--------------------------------------------------------------
+void DepthSource::publish() {
+    DepthFrame& frame = frames.getBack();
+    frame.sequence = numPublished.load() + 1;
+    numPublished.store(frame.sequence);
+
+    DepthRecorder* r = recorder.load();
+    if (r != NULL)
+        r->add(frame);
+    if (!frames.publish())
+        numDropped++;
+}
+
+//--------------------------------------------------------------
+bool DepthSource::acquire() {
+    bool fresh = frames.acquire();
+    if (fresh)
+        numDelivered++;
+    else if (frames.getFront().sequence > 0)
+        numReused++;
+    return fresh;
+}
+
+//--------------------------------------------------------------
+void DepthSource::updateReadouts() {
+    delivered.set(numDelivered.load());
+    dropped.set(numDropped.load());
+    reused.set(numReused.load());
+}
+
+//--------------------------------------------------------------
+bool DepthSource::update() {
+    bool fresh = acquire();
+    updateReadouts();
+    return fresh;
+}
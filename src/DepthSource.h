@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ofMain.h"
+#include "TripleBuffer.h"
+
+class DepthRecorder;
+
+// One depth image.
+struct DepthFrame {
+    ofShortPixels	rawDepth;		// millimetres, 0 where there is no reading
+    uint64_t		sequence;		// counts the source's frames from 1
+    uint64_t		capturedMicros;	// ofGetElapsedTimeMicros() when it was captured
+};
+
+// Where the depth images come from: the Kinect, or a recording of it. The
+// source produces frames on its own thread and publishes each into the back
+// slot of a triple buffer; update() takes the newest complete frame in
+// constant time without waiting. Frames the render thread was too slow for
+// are dropped, frames it draws twice are counted as reused. Every frame the
+// source publishes also goes to the recorder, when one is attached.
+
+class DepthSource : public ofThread {
+public:
+    DepthSource();
+    virtual ~DepthSource() { }
+
+    virtual void	close() = 0;
+    virtual int		getWidth() const = 0;
+    virtual int		getHeight() const = 0;
+    // any thread, false if the source has no motor to tilt
+    virtual bool	setTiltAngle(float _degrees)	{ return false; }
+    // any thread, lets the dancers see they are being recorded where the
+    // sensor has a light for it
+    virtual void	setRecording(bool _recording)	{ }
+
+    ofParameterGroup	parameters;
+
+    // render thread, true when getFrame() moved on to a newer frame
+    virtual bool	update();
+    const DepthFrame&	getFrame() const	{ return frames.getFront(); }
+    // the same for a source read by another thread (see FusedDepth): that
+    // thread takes the frames, the render thread publishes the counts
+    bool	acquire();
+    void	updateReadouts();
+
+    void	setRecorder(DepthRecorder* _recorder)	{ recorder.store(_recorder); }
+
+protected:
+    // source thread: fill the back frame, then publish it
+    DepthFrame&	getBackFrame()				{ return frames.getBack(); }
+    void		publish();
+    // true while the render thread has not taken the last one published
+    bool		isPublishedFrameWaiting() const	{ return frames.isWaiting(); }
+
+    ofParameter<int>	delivered;
+    ofParameter<int>	dropped;
+    ofParameter<int>	reused;
+
+    TripleBuffer<DepthFrame>	frames;
+    std::atomic<DepthRecorder*>	recorder;
+
+    std::atomic<uint64_t>	numPublished;
+    std::atomic<uint64_t>	numDropped;
+    std::atomic<uint64_t>	numDelivered;
+    std::atomic<uint64_t>	numReused;
+};
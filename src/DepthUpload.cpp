@@ -0,0 +1,127 @@
+#include "DepthUpload.h"
+
+//--------------------------------------------------------------
+DepthUpload::DepthUpload() {
+    width = 0;
+    height = 0;
+    persistent = false;
+    writeBuffer = 0;
+    for (int b=0; b<numBuffers; b++) {
+        buffers[b] = 0;
+        mapped[b] = NULL;
+        fences[b] = NULL;
+    }
+
+    parameters.setName("depth");
+    parameters.add(nearClip.set("near mm", 500, 0, 4000));
+    parameters.add(farClip.set("far mm", 4000, 500, 8000));
+    parameters.add(waits.set("waits", 0, 0, 1000000));
+}
+
+//--------------------------------------------------------------
+DepthUpload::~DepthUpload() {
+    release();
+}
+
+//--------------------------------------------------------------
+void DepthUpload::release() {
+    for (int b=0; b<numBuffers; b++) {
+        if (fences[b] != NULL)
+            glDeleteSync(fences[b]);
+        fences[b] = NULL;
+        if (mapped[b] != NULL) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[b]);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            mapped[b] = NULL;
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (buffers[0] != 0)
+        glDeleteBuffers(numBuffers, buffers);
+    for (int b=0; b<numBuffers; b++)
+        buffers[b] = 0;
+}
+
+//--------------------------------------------------------------
+void DepthUpload::setup(int _width, int _height) {
+    release();
+    width = _width;
+    height = _height;
+    texture.allocate(width, height, GL_R16);
+    texture.setRGToRGBASwizzles(true);
+
+    GLsizeiptr size = width * height * sizeof(uint16_t);
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    persistent = ofGLCheckExtension("GL_ARB_buffer_storage");
+    glGenBuffers(numBuffers, buffers);
+    for (int b=0; b<numBuffers; b++) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[b]);
+        if (persistent) {
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL, flags);
+            mapped[b] = (uint16_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+        }
+        else {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    writeBuffer = 0;
+    ofLogNotice("DepthUpload") << width << " x " << height << (persistent ? ", persistently mapped" : ", mapped per frame");
+}
+
+//--------------------------------------------------------------
+void DepthUpload::convert(const ofShortPixels& _rawDepth, bool _mirror, uint16_t* _dst) const {
+    // 16.16 fixed point, no reading and too far are black
+    int nearest = nearClip;
+    int farthest = max(farClip.get(), nearest + 1);
+    uint32_t scale = (uint32_t)(65535.0 * 65536.0 / (farthest - nearest));
+    const uint16_t* src = _rawDepth.getData();
+    for (int y=0; y<height; y++) {
+        const uint16_t* row = src + y * width;
+        uint16_t* dst = _dst + y * width;
+        for (int x=0; x<width; x++) {
+            int d = row[_mirror ? width - 1 - x : x];
+            int v = farthest - max(d, nearest);
+            dst[x] = d == 0 || v < 0 ? 0 : (uint16_t)(((uint64_t)v * scale) >> 16);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void DepthUpload::upload(const ofShortPixels& _rawDepth, bool _mirror) {
+    if (buffers[0] == 0 || (int)_rawDepth.getWidth() != width || (int)_rawDepth.getHeight() != height)
+        return;
+
+    // the transfer from this buffer numBuffers frames ago is long finished
+    int b = writeBuffer;
+    writeBuffer = (writeBuffer + 1) % numBuffers;
+    if (fences[b] != NULL) {
+        if (glClientWaitSync(fences[b], 0, 0) == GL_TIMEOUT_EXPIRED) {
+            waits.set(waits + 1);
+            glClientWaitSync(fences[b], GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+        }
+        glDeleteSync(fences[b]);
+        fences[b] = NULL;
+    }
+
+    GLsizeiptr size = width * height * sizeof(uint16_t);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[b]);
+    uint16_t* dst = mapped[b];
+    if (!persistent)
+        dst = (uint16_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst != NULL) {
+        convert(_rawDepth, _mirror, dst);
+        if (!persistent)
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // from the bound buffer, the driver copies it when it gets to it
+        const ofTextureData& data = texture.getTextureData();
+        glBindTexture(data.textureTarget, data.textureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+        glTexSubImage2D(data.textureTarget, 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_SHORT, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(data.textureTarget, 0);
+        fences[b] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Streams the Kinect's raw depth into a single channel 16 bit texture, the
+// one image the optical flow and the velocity mask both read. Each frame is
+// written straight into one of a ring of pixel buffers, converted on the way
+// from millimetres to near is bright and mirrored if asked, and the texture
+// is filled from that buffer by the driver without the CPU waiting for it.
+// Where the driver has persistent mapping (GL_ARB_buffer_storage) the buffers
+// stay mapped for good; elsewhere (macOS tops out at GL 4.1) each is mapped
+// unsynchronized for the copy. A fence per buffer says when the driver is
+// done with it, and the ring is deep enough that it always is.
+// Render thread only.
+
+class DepthUpload {
+public:
+    static const int	numBuffers = 3;
+
+    DepthUpload();
+    ~DepthUpload();
+
+    void	setup(int _width, int _height);
+    void	upload(const ofShortPixels& _rawDepth, bool _mirror);
+
+    ofParameterGroup	parameters;
+
+    ofTexture&	getTexture()			{ return texture; }
+    bool		isPersistent() const	{ return persistent; }
+
+protected:
+    void	release();
+    void	convert(const ofShortPixels& _rawDepth, bool _mirror, uint16_t* _dst) const;
+
+    ofParameter<int>	nearClip;	// mm, white
+    ofParameter<int>	farClip;	// mm, black, and anything beyond it
+    ofParameter<int>	waits;		// uploads that found their buffer still busy
+
+    ofTexture		texture;		// GL_R16, red swizzled to grey
+    int				width;
+    int				height;
+    bool			persistent;
+    GLuint			buffers[numBuffers];
+    uint16_t*		mapped[numBuffers];	// persistent mappings
+    GLsync			fences[numBuffers];
+    int				writeBuffer;
+};
@@ -0,0 +1,354 @@
+#include "FeatureCache.h"
+
+#include <sys/stat.h>
+#ifndef TARGET_WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char		magic[4] = { 'G', 'R', 'V', 'F' };
+    const uint32_t	version = 1;
+
+    // file layout: header, numHops records of recordSize bytes (the fixed
+    // fields then numBands floats), numBeats floats, numOnsets floats
+    struct FeatureCacheHeader {
+        char		magic[4];
+        uint32_t	version;
+        int32_t		sampleRate;
+        int32_t		fftSize;
+        int32_t		hopSize;
+        int32_t		window;
+        int32_t		numBands;
+        int32_t		scale;
+        uint64_t	trackBytes;
+        int64_t		trackModified;
+        int64_t		trackFrames;
+        int32_t		numHops;
+        int32_t		recordSize;
+        int32_t		numBeats;
+        int32_t		numOnsets;
+    };
+
+    struct FeatureCacheRecord {
+        float		rms;
+        float		novelty;
+        float		onsetStrength;
+        float		beatPhase;
+        float		bpm;
+        float		tempoConfidence;
+        uint32_t	flags;
+    };
+
+    const uint32_t	onsetFlag = 1;
+    const uint32_t	beatFlag = 2;
+}
+
+//--------------------------------------------------------------
+FeatureCache::FeatureCache() {
+    track = NULL;
+    requested = false;
+    buildFinished = false;
+    data = NULL;
+    dataSize = 0;
+    numHops = 0;
+    numBands = 0;
+    hopDuration = 0;
+    recordSize = 0;
+    records = NULL;
+    beats = NULL;
+    numBeats = 0;
+    onsets = NULL;
+    numOnsets = 0;
+
+    parameters.setName("feature cache");
+    parameters.add(enabled.set("enabled", true));
+    parameters.add(status.set("status", "off"));
+    enabled.addListener(this, &FeatureCache::setEnabled);
+}
+
+//--------------------------------------------------------------
+FeatureCache::~FeatureCache() {
+    close();
+}
+
+//--------------------------------------------------------------
+void FeatureCache::setup(const PcmTrack& _track) {
+    close();
+    track = &_track;
+}
+
+//--------------------------------------------------------------
+void FeatureCache::update(const AudioFeatureConfig& _config) {
+    if (track == NULL || !track->isDecoded() || !enabled)
+        return;
+    if (isThreadRunning())
+        return;
+
+    if (buildFinished.exchange(false))
+        open();
+
+    // mapped, or already tried and failed, for this configuration
+    if (requested && requestedConfig == _config)
+        return;
+
+    close();
+    requestedConfig = _config;
+    requested = true;
+    if (!open()) {
+        status.set("building");
+        startThread();
+    }
+}
+
+//--------------------------------------------------------------
+void FeatureCache::close() {
+    // a build still reads the track, which is closed after this
+    if (isThreadRunning())
+        waitForThread(true);
+#ifndef TARGET_WIN32
+    if (data != NULL)
+        munmap((void*)data, dataSize);
+#endif
+    fallbackBuffer = ofBuffer();
+    data = NULL;
+    dataSize = 0;
+    records = NULL;
+    beats = NULL;
+    onsets = NULL;
+    numHops = 0;
+    numBeats = 0;
+    numOnsets = 0;
+    requested = false;
+    status.set("off");
+}
+
+//--------------------------------------------------------------
+bool FeatureCache::readTrackStamp(uint64_t& _bytes, int64_t& _modified) const {
+    struct stat info;
+    if (stat(track->getPath().c_str(), &info) != 0)
+        return false;
+    _bytes = info.st_size;
+    _modified = info.st_mtime;
+    return true;
+}
+
+//--------------------------------------------------------------
+bool FeatureCache::open() {
+    string path = getCachePath();
+    if (!ofFile::doesFileExist(path, false)) {
+        status.set("missing");
+        return false;
+    }
+
+#ifndef TARGET_WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(FeatureCacheHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    data = (const char*)mapped;
+    dataSize = info.st_size;
+#else
+    fallbackBuffer = ofBufferFromFile(path, true);
+    data = fallbackBuffer.getData();
+    dataSize = fallbackBuffer.size();
+#endif
+
+    // anything that does not match exactly is stale
+    FeatureCacheHeader header;
+    bool valid = dataSize >= sizeof(header);
+    if (valid)
+        memcpy(&header, data, sizeof(header));
+    uint64_t trackBytes = 0;
+    int64_t trackModified = 0;
+    valid = valid && readTrackStamp(trackBytes, trackModified) &&
+        memcmp(header.magic, magic, sizeof(magic)) == 0 &&
+        header.version == version &&
+        header.sampleRate == requestedConfig.sampleRate &&
+        header.fftSize == requestedConfig.fftSize &&
+        header.hopSize == requestedConfig.hopSize &&
+        header.window == requestedConfig.window &&
+        header.numBands == requestedConfig.numBands &&
+        header.scale == requestedConfig.scale &&
+        header.trackBytes == trackBytes &&
+        header.trackModified == trackModified &&
+        header.trackFrames == track->getNumFrames() &&
+        header.recordSize == (int32_t)(sizeof(FeatureCacheRecord) + header.numBands * sizeof(float)) &&
+        dataSize == sizeof(header) + (size_t)header.numHops * header.recordSize + (size_t)(header.numBeats + header.numOnsets) * sizeof(float);
+    if (!valid) {
+        close();
+        requested = true;
+        status.set("stale");
+        return false;
+    }
+
+    numHops = header.numHops;
+    numBands = header.numBands;
+    hopDuration = (float)header.hopSize / header.sampleRate;
+    recordSize = header.recordSize;
+    records = data + sizeof(header);
+    beats = (const float*)(records + numHops * recordSize);
+    numBeats = header.numBeats;
+    onsets = beats + numBeats;
+    numOnsets = header.numOnsets;
+    status.set("ready, " + ofToString(numHops) + " hops");
+    ofLogNotice("FeatureCache") << "mapped " << path << ": " << numHops << " hops, " << numBeats << " beats, " << numOnsets << " onsets";
+    return true;
+}
+
+//--------------------------------------------------------------
+void FeatureCache::threadedFunction() {
+    build(getCachePath());
+    buildFinished = true;
+}
+
+//--------------------------------------------------------------
+bool FeatureCache::build(const string& _path) {
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+
+    FeatureExtractor extractor;
+    extractor.setup(requestedConfig);
+    const AudioFeatureConfig& config = extractor.getConfig();
+    int size = config.fftSize;
+    int hop = config.hopSize;
+    float duration = extractor.getHopDuration();
+
+    // hop h is the window ending at h * hop, up to the first one past the end
+    int hops = (int)((track->getNumFrames() + hop - 1) / hop) + 1;
+    size_t bytesPerRecord = sizeof(FeatureCacheRecord) + config.numBands * sizeof(float);
+    vector<char> recordData(hops * bytesPerRecord);
+    vector<float> beatTimes;
+    vector<float> onsetTimes;
+    vector<float> input(size);
+    AudioFrame frame;
+
+    for (int h=0; h<hops; h++) {
+        if (!isThreadRunning())
+            return false;
+        track->readMono((int64_t)h * hop - size, size, input.data());
+        extractor.process(input.data(), frame);
+
+        FeatureCacheRecord record;
+        record.rms = frame.rms;
+        record.novelty = frame.novelty;
+        record.onsetStrength = frame.onsetStrength;
+        record.beatPhase = frame.beatPhase;
+        record.bpm = frame.bpm;
+        record.tempoConfidence = frame.tempoConfidence;
+        record.flags = (frame.onset ? onsetFlag : 0) | (frame.beat ? beatFlag : 0);
+        char* dst = recordData.data() + h * bytesPerRecord;
+        memcpy(dst, &record, sizeof(record));
+        memcpy(dst + sizeof(record), frame.bands, config.numBands * sizeof(float));
+
+        // onsets are picked one hop late; the beat fell when the phase wrapped
+        if (frame.onset)
+            onsetTimes.push_back((h - 1) * duration);
+        if (frame.beat)
+            beatTimes.push_back(h * duration - frame.beatPhase * 60.0f / frame.bpm);
+    }
+
+    FeatureCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.sampleRate = config.sampleRate;
+    header.fftSize = config.fftSize;
+    header.hopSize = config.hopSize;
+    header.window = config.window;
+    header.numBands = config.numBands;
+    header.scale = config.scale;
+    readTrackStamp(header.trackBytes, header.trackModified);
+    header.trackFrames = track->getNumFrames();
+    header.numHops = hops;
+    header.recordSize = bytesPerRecord;
+    header.numBeats = beatTimes.size();
+    header.numOnsets = onsetTimes.size();
+
+    // write next to it and rename, a reader never sees half a file
+    string temporaryPath = _path + ".tmp";
+    FILE* file = fopen(temporaryPath.c_str(), "wb");
+    if (file == NULL) {
+        ofLogError("FeatureCache") << "could not write " << temporaryPath;
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(recordData.data(), recordData.size(), 1, file) == 1 &&
+        (beatTimes.empty() || fwrite(beatTimes.data(), beatTimes.size() * sizeof(float), 1, file) == 1) &&
+        (onsetTimes.empty() || fwrite(onsetTimes.data(), onsetTimes.size() * sizeof(float), 1, file) == 1);
+    written = fclose(file) == 0 && written;
+    if (!written || !ofFile::moveFromTo(temporaryPath, _path, false, true)) {
+        ofLogError("FeatureCache") << "could not write " << _path;
+        ofFile::removeFile(temporaryPath, false);
+        return false;
+    }
+    ofLogNotice("FeatureCache") << "built " << _path << " in " << (ofGetElapsedTimeMicros() - startMicros) / 1000 << " ms";
+    return true;
+}
+
+//--------------------------------------------------------------
+int FeatureCache::getHop(double _seconds) const {
+    if (numHops == 0)
+        return -1;
+    return ofClamp(floor(_seconds / hopDuration), 0, numHops - 1);
+}
+
+//--------------------------------------------------------------
+bool FeatureCache::getFrame(int _hop, AudioFrame& _frame) const {
+    if (_hop < 0 || _hop >= numHops)
+        return false;
+    const char* src = records + _hop * recordSize;
+    FeatureCacheRecord record;
+    memcpy(&record, src, sizeof(record));
+
+    _frame.sequence = _hop;
+    _frame.time = _hop * hopDuration;
+    _frame.analyzedMicros = ofGetElapsedTimeMicros();
+    _frame.capturedMicros = 0;
+    _frame.rms = record.rms;
+    _frame.numBands = numBands;
+    memcpy(_frame.bands, src + sizeof(record), numBands * sizeof(float));
+    _frame.novelty = record.novelty;
+    _frame.onset = (record.flags & onsetFlag) != 0;
+    _frame.onsetStrength = record.onsetStrength;
+    _frame.beat = (record.flags & beatFlag) != 0;
+    _frame.beatPhase = record.beatPhase;
+    _frame.bpm = record.bpm;
+    _frame.tempoConfidence = record.tempoConfidence;
+    return true;
+}
+
+//--------------------------------------------------------------
+double FeatureCache::getPreviousBeat(double _seconds) const {
+    const float* beat = std::upper_bound(beats, beats + numBeats, (float)_seconds);
+    return beat == beats ? -1 : *(beat - 1);
+}
+
+//--------------------------------------------------------------
+double FeatureCache::getNextBeat(double _seconds) const {
+    const float* beat = std::upper_bound(beats, beats + numBeats, (float)_seconds);
+    return beat == beats + numBeats ? -1 : *beat;
+}
+
+//--------------------------------------------------------------
+float FeatureCache::getBeatPhase(double _seconds) const {
+    double previous = getPreviousBeat(_seconds);
+    double next = getNextBeat(_seconds);
+    if (previous < 0 || next <= previous)
+        return -1;
+    return (_seconds - previous) / (next - previous);
+}
+
+//--------------------------------------------------------------
+double FeatureCache::getNextOnset(double _seconds) const {
+    const float* onset = std::upper_bound(onsets, onsets + numOnsets, (float)_seconds);
+    return onset == onsets + numOnsets ? -1 : *onset;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ofMain.h"
+#include "PcmTrack.h"
+#include "FeatureExtractor.h"
+
+// Offline analysis of a whole track into a feature file next to it
+// (<track>.features): per hop band energies, rms, novelty, onsets and tempo,
+// plus the beat and onset times, in one flat file that is memory mapped and
+// read in place. Lookups by playback position cost no FFT, give the same
+// result every night, and can look ahead of the playhead.
+// The file is keyed on the track's size and modification time and on the
+// analysis configuration; when it is missing or stale it is rebuilt on a
+// background thread and isReady() stays false until then, so the caller
+// keeps using live analysis in the meantime.
+
+class FeatureCache : public ofThread {
+public:
+    FeatureCache();
+    ~FeatureCache();
+
+    void	setup(const PcmTrack& _track);
+    // render thread, every frame: maps the cache for _config, or starts
+    // building it
+    void	update(const AudioFeatureConfig& _config);
+    // stops a build in progress first, call it before closing the track
+    void	close();
+
+    ofParameterGroup	parameters;
+
+    bool	isReady() const			{ return data != NULL; }
+    int		getNumHops() const		{ return numHops; }
+    float	getHopDuration() const	{ return hopDuration; }
+
+    // the last hop whose window ends at or before _seconds
+    int		getHop(double _seconds) const;
+    bool	getFrame(int _hop, AudioFrame& _frame) const;
+
+    // beat grid; -1 when there is no such beat
+    double	getPreviousBeat(double _seconds) const;
+    double	getNextBeat(double _seconds) const;
+    // 0..1 between the beats around _seconds, -1 outside the grid
+    float	getBeatPhase(double _seconds) const;
+    double	getNextOnset(double _seconds) const;
+
+protected:
+    void	threadedFunction();
+
+    bool	open();
+    bool	build(const string& _path);
+    bool	readTrackStamp(uint64_t& _bytes, int64_t& _modified) const;
+    string	getCachePath() const	{ return track->getPath() + ".features"; }
+
+    ofParameter<bool>	enabled;
+    void				setEnabled(bool& _value)	{ if (!_value) close(); }
+    ofParameter<string>	status;
+
+    const PcmTrack*		track;
+
+    AudioFeatureConfig	requestedConfig;
+    bool				requested;
+    std::atomic<bool>	buildFinished;
+
+    // mapped file
+    const char*			data;
+    size_t				dataSize;
+    ofBuffer			fallbackBuffer;		// where there is no mmap
+    int					numHops;
+    int					numBands;
+    float				hopDuration;
+    size_t				recordSize;
+    const char*			records;
+    const float*		beats;
+    int					numBeats;
+    const float*		onsets;
+    int					numOnsets;
+};
@@ -0,0 +1,55 @@
+#include "FeatureExtractor.h"
+
+#include <algorithm>
+#include <cmath>
+
+//--------------------------------------------------------------
+FeatureExtractor::FeatureExtractor() {
+    config.sampleRate = 0;
+    config.fftSize = 0;
+    config.hopSize = 0;
+    config.window = REAL_FFT_WINDOW_HANN;
+    config.numBands = 0;
+    config.scale = FILTER_BANK_MEL;
+}
+
+//--------------------------------------------------------------
+void FeatureExtractor::setup(const AudioFeatureConfig& _config) {
+    fft.setup(_config.fftSize, _config.window);
+    config = _config;
+    config.fftSize = fft.getSize();
+    config.hopSize = std::max(1, std::min(config.hopSize, config.fftSize));
+
+    amplitudes.assign(fft.getNumBins(), 0);
+    filterBank.setup(config.numBands, config.fftSize, config.sampleRate, config.scale);
+    config.numBands = filterBank.getNumBands();
+    onsetDetector.setup(fft.getNumBins(), getHopDuration());
+    tempoTracker.setup(getHopDuration());
+}
+
+//--------------------------------------------------------------
+void FeatureExtractor::reset() {
+    onsetDetector.reset();
+    tempoTracker.reset();
+}
+
+//--------------------------------------------------------------
+void FeatureExtractor::process(const float* _window, AudioFrame& _frame) {
+    int size = config.fftSize;
+    float sumSquares = 0;
+    for (int i=0; i<size; i++)
+        sumSquares += _window[i] * _window[i];
+    _frame.rms = sqrtf(sumSquares / size);
+
+    fft.amplitudes(_window, amplitudes.data());
+    filterBank.process(amplitudes.data(), _frame.bands);
+    _frame.numBands = filterBank.getNumBands();
+
+    _frame.onset = onsetDetector.process(amplitudes.data());
+    _frame.novelty = onsetDetector.getNovelty();
+    _frame.onsetStrength = onsetDetector.getOnsetStrength();
+    _frame.beat = tempoTracker.process(_frame.novelty);
+    _frame.beatPhase = tempoTracker.getBeatPhase();
+    _frame.bpm = tempoTracker.getBpm();
+    _frame.tempoConfidence = tempoTracker.getConfidence();
+}
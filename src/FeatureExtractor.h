@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "RealFft.h"
+#include "FilterBank.h"
+#include "OnsetDetector.h"
+#include "TempoTracker.h"
+
+// One analysed hop of audio, as handed from the analysis thread to update().
+struct AudioFrame {
+    static const int maxBands = FilterBank::maxBands;
+
+    uint64_t	sequence;
+    double		time;			// track position at the end of the analysis window, in seconds
+    uint64_t	analyzedMicros;	// ofGetElapsedTimeMicros() when the frame was published
+    uint64_t	capturedMicros;	// when the newest sample was captured, live input only (0 otherwise)
+    float		rms;
+    int			numBands;
+    float		bands[maxBands];	// rms amplitude per filter bank band
+
+    // rhythm
+    float		novelty;		// spectral flux
+    bool		onset;
+    float		onsetStrength;	// 0..1, only set on onsets
+    bool		beat;
+    float		beatPhase;		// 0 on the beat, rising to 1 just before the next
+    float		bpm;
+    float		tempoConfidence;
+};
+
+// Everything that decides what the features of a hop come out as.
+struct AudioFeatureConfig {
+    int				sampleRate;
+    int				fftSize;
+    int				hopSize;
+    RealFftWindow	window;
+    int				numBands;
+    FilterBankScale	scale;
+
+    bool operator==(const AudioFeatureConfig& _other) const {
+        return sampleRate == _other.sampleRate && fftSize == _other.fftSize && hopSize == _other.hopSize &&
+               window == _other.window && numBands == _other.numBands && scale == _other.scale;
+    }
+    bool operator!=(const AudioFeatureConfig& _other) const { return !(*this == _other); }
+};
+
+// The per hop analysis chain: window and FFT, filter bank, onsets and tempo.
+// The live analyzer and the offline feature cache both run their hops through
+// one of these, so a cached track reads exactly like a live one.
+// Stateful (onsets and tempo follow the hops fed in order), no openFrameworks.
+
+class FeatureExtractor {
+public:
+    FeatureExtractor();
+
+    void	setup(const AudioFeatureConfig& _config);
+    void	reset();
+
+    const AudioFeatureConfig&	getConfig() const	{ return config; }
+    float	getHopDuration() const					{ return config.sampleRate > 0 ? (float)config.hopSize / config.sampleRate : 0.0f; }
+    const FilterBank&	getFilterBank() const		{ return filterBank; }
+
+    // _window holds fftSize mono samples ending at the hop; fills everything
+    // but sequence, time and analyzedMicros
+    void	process(const float* _window, AudioFrame& _frame);
+
+private:
+    AudioFeatureConfig	config;
+    RealFft				fft;
+    FilterBank			filterBank;
+    OnsetDetector		onsetDetector;
+    TempoTracker		tempoTracker;
+    std::vector<float>	amplitudes;
+};
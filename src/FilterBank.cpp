@@ -0,0 +1,136 @@
+#include "FilterBank.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    float hzToMel(float _hz)	{ return 2595.0f * log10f(1.0f + _hz / 700.0f); }
+    float melToHz(float _mel)	{ return 700.0f * (powf(10.0f, _mel / 2595.0f) - 1.0f); }
+
+    // bands are named after the range their center falls in
+    const int numRanges = 7;
+    const float rangeUpperHz[numRanges] = { 60, 250, 500, 2000, 4000, 6000, 1e9f };
+    const char* rangeNames[numRanges] = { "sub", "bass", "low mid", "mid", "high mid", "presence", "brilliance" };
+
+    int getRange(float _hz) {
+        int r = 0;
+        while (_hz >= rangeUpperHz[r])
+            r++;
+        return r;
+    }
+}
+
+//--------------------------------------------------------------
+FilterBank::FilterBank() {
+    numBands = 0;
+    numBins = 0;
+}
+
+//--------------------------------------------------------------
+void FilterBank::setup(int _numBands, int _fftSize, int _sampleRate, FilterBankScale _scale, float _minHz, float _maxHz) {
+    numBands = std::max(minBands, std::min(maxBands, _numBands));
+    numBins = _fftSize / 2 + 1;
+    float binHz = (float)_sampleRate / _fftSize;
+    _maxHz = std::min(_maxHz, _sampleRate * 0.5f);
+
+    // numBands + 2 edges, evenly spaced on the chosen scale
+    std::vector<float> edges(numBands + 2);
+    for (int i=0; i<numBands+2; i++) {
+        float t = (float)i / (numBands + 1);
+        if (_scale == FILTER_BANK_MEL)
+            edges[i] = melToHz(hzToMel(_minHz) + t * (hzToMel(_maxHz) - hzToMel(_minHz)));
+        else
+            edges[i] = _minHz * powf(_maxHz / _minHz, t);
+    }
+
+    start.resize(numBands);
+    count.resize(numBands);
+    offset.resize(numBands);
+    normalization.resize(numBands);
+    centers.resize(numBands);
+    names.resize(numBands);
+    weights.clear();
+
+    std::vector<int> rangeCount(numRanges, 0);
+    for (int b=0; b<numBands; b++) {
+        float lower = edges[b];
+        float center = edges[b + 1];
+        float upper = edges[b + 2];
+        centers[b] = center;
+
+        int first = std::max(0, (int)ceilf(lower / binHz));
+        int last = std::min(numBins - 1, (int)floorf(upper / binHz));
+        offset[b] = weights.size();
+        start[b] = first;
+        float sum = 0;
+        for (int k=first; k<=last; k++) {
+            float hz = k * binHz;
+            float w = hz <= center ? (hz - lower) / (center - lower) : (upper - hz) / (upper - center);
+            w = std::max(0.0f, w);
+            weights.push_back(w);
+            sum += w;
+        }
+        // low bands of a small transform can fall between two bins, they get
+        // the nearest bin instead of nothing
+        if (sum <= 0) {
+            weights.resize(offset[b]);
+            start[b] = std::min(numBins - 1, (int)(center / binHz + 0.5f));
+            weights.push_back(1);
+            sum = 1;
+        }
+        count[b] = weights.size() - offset[b];
+        normalization[b] = 1.0f / sum;
+
+        // "bass 1", "bass 2", ...
+        int range = getRange(center);
+        char name[32];
+        snprintf(name, sizeof(name), "%s %d", rangeNames[range], ++rangeCount[range]);
+        names[b] = name;
+    }
+
+    power.assign(numBins + simd::width, 0);
+}
+
+//--------------------------------------------------------------
+void FilterBank::process(const float* _amplitudes, float* _bands) {
+    int k = 0;
+    for (; k + simd::width <= numBins; k += simd::width) {
+        simd::vfloat a = simd::load(_amplitudes + k);
+        simd::store(&power[k], simd::mul(a, a));
+    }
+    for (; k<numBins; k++)
+        power[k] = _amplitudes[k] * _amplitudes[k];
+
+    for (int b=0; b<numBands; b++) {
+        const float* w = &weights[offset[b]];
+        const float* p = &power[start[b]];
+        int n = count[b];
+        int i = 0;
+        simd::vfloat acc = simd::set1(0);
+        for (; i + simd::width <= n; i += simd::width)
+            acc = simd::madd(simd::load(w + i), simd::load(p + i), acc);
+        float sum = simd::sum(acc);
+        for (; i<n; i++)
+            sum += w[i] * p[i];
+        _bands[b] = sqrtf(sum * normalization[b]);
+    }
+}
+
+//--------------------------------------------------------------
+int FilterBank::findBand(float _hz) const {
+    int best = 0;
+    for (int b=1; b<numBands; b++)
+        if (fabsf(centers[b] - _hz) < fabsf(centers[best] - _hz))
+            best = b;
+    return best;
+}
+
+//--------------------------------------------------------------
+int FilterBank::findBand(const std::string& _name) const {
+    for (int b=0; b<numBands; b++)
+        if (names[b] == _name)
+            return b;
+    return -1;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Triangular filters over an amplitude spectrum, spaced on the mel or a log
+// frequency scale, that reduce the full FFT to a handful of named bands.
+// The filters are stored sparse: each band only keeps the weights of the bins
+// under its triangle, back to back in one array, so process() is a single
+// vectorized pass over the spectrum with no allocation.
+
+enum FilterBankScale {
+    FILTER_BANK_MEL = 0,
+    FILTER_BANK_LOG,
+};
+
+class FilterBank {
+public:
+    static const int	minBands = 8;
+    static const int	maxBands = 64;
+
+    FilterBank();
+
+    void	setup(int _numBands, int _fftSize, int _sampleRate, FilterBankScale _scale = FILTER_BANK_MEL, float _minHz = 30, float _maxHz = 16000);
+
+    // _amplitudes holds fftSize / 2 + 1 bins; each band is the rms amplitude
+    // under its triangle, so it reads on the same scale as the spectrum
+    void	process(const float* _amplitudes, float* _bands);
+
+    int		getNumBands() const						{ return numBands; }
+    float	getCenterFrequency(int _band) const		{ return centers[_band]; }
+    const std::string&	getBandName(int _band) const	{ return names[_band]; }
+    // the band whose center is closest to _hz
+    int		findBand(float _hz) const;
+    // the first band with that name, -1 if there is none
+    int		findBand(const std::string& _name) const;
+
+private:
+    int						numBands;
+    int						numBins;
+
+    std::vector<int>		start;		// first bin under each band
+    std::vector<int>		count;		// bins under each band
+    std::vector<int>		offset;		// where the band's weights start in weights
+    std::vector<float>		weights;
+    std::vector<float>		normalization;
+    std::vector<float>		centers;
+    std::vector<std::string>	names;
+
+    std::vector<float>		power;
+};
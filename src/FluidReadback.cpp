@@ -0,0 +1,67 @@
+#include "FluidReadback.h"
+
+//--------------------------------------------------------------
+FluidReadback::FluidReadback() {
+    width = 0;
+    height = 0;
+    writeBuffer = 0;
+    numQueued = 0;
+}
+
+//--------------------------------------------------------------
+void FluidReadback::setup(int _sourceWidth, int _sourceHeight, int _width, int _height) {
+    width = max(_width, 1);
+    height = max(_height, 1);
+
+    // halving with bilinear filtering averages exactly 2 x 2 texels, the
+    // last stage takes whatever ratio is left
+    stages.clear();
+    int w = _sourceWidth;
+    int h = _sourceHeight;
+    while (w / 2 >= width && h / 2 >= height && (w / 2 > width || h / 2 > height)) {
+        w /= 2;
+        h /= 2;
+        stages.push_back(ofFbo());
+        stages.back().allocate(w, h, GL_RG32F);
+    }
+    stages.push_back(ofFbo());
+    stages.back().allocate(width, height, GL_RG32F);
+
+    for (int b=0; b<numBuffers; b++)
+        buffers[b].allocate(width * height * 2 * sizeof(float), GL_STREAM_READ);
+    writeBuffer = 0;
+    numQueued = 0;
+    velocity.assign(width * height * 2, 0);
+}
+
+//--------------------------------------------------------------
+void FluidReadback::update(const ofTexture& _velocity) {
+    if (stages.empty())
+        return;
+
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    const ofTexture* source = &_velocity;
+    for (size_t s=0; s<stages.size(); s++) {
+        stages[s].begin();
+        ofClear(0, 0);
+        source->draw(0, 0, stages[s].getWidth(), stages[s].getHeight());
+        stages[s].end();
+        source = &stages[s].getTexture();
+    }
+    ofPopStyle();
+
+    // queue this frame's copy, collect the oldest one
+    source->copyTo(buffers[writeBuffer]);
+    writeBuffer = (writeBuffer + 1) % numBuffers;
+    numQueued = min(numQueued + 1, numBuffers);
+    if (numQueued < numBuffers)
+        return;
+
+    ofBufferObject& ready = buffers[writeBuffer];
+    const float* mapped = (const float*)ready.map(GL_READ_ONLY);
+    if (mapped != NULL) {
+        memcpy(velocity.data(), mapped, velocity.size() * sizeof(float));
+        ready.unmap();
+    }
+}
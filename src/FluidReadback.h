@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Brings a small copy of a velocity texture back to the CPU without
+// stalling the GL pipeline. The texture is box filtered down by halving it
+// through a chain of float FBOs, then copied into one of a ring of pixel
+// buffers; the copy that is mapped is the one queued numBuffers - 1 frames
+// ago, which the driver has long finished by then. Render thread only.
+
+class FluidReadback {
+public:
+    static const int	numBuffers = 3;
+
+    FluidReadback();
+
+    void	setup(int _sourceWidth, int _sourceHeight, int _width, int _height);
+    void	update(const ofTexture& _velocity);
+
+    bool	isReady() const			{ return numQueued >= numBuffers; }
+    int		getWidth() const		{ return width; }
+    int		getHeight() const		{ return height; }
+    // x, y per cell, rows from the bottom of the texture
+    const float*	getVelocity() const		{ return velocity.data(); }
+
+protected:
+    int					width;
+    int					height;
+    vector<ofFbo>		stages;			// each half the size of the one before, the last is width x height
+    ofBufferObject		buffers[numBuffers];
+    int					writeBuffer;
+    int					numQueued;
+    vector<float>		velocity;
+};
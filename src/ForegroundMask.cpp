@@ -0,0 +1,53 @@
+#include "ForegroundMask.h"
+
+//--------------------------------------------------------------
+ForegroundMask::ForegroundMask() {
+    parameters.setName("foreground");
+    parameters.add(nearClip.set("near mm", 500, 0, 4000));
+    parameters.add(farClip.set("far mm", 4000, 500, 8000));
+    parameters.add(threshold.set("threshold mm", 150, 20, 1000));
+    parameters.add(rise.set("rise mm", 50, 0, 500));
+    parameters.add(fall.set("fall mm", 0.1, 0, 10));
+    parameters.add(fillRadius.set("fill radius", 2, 0, DepthSegmenter::maxFillRadius));
+    parameters.add(relearn.set("relearn", false));
+    parameters.add(coverage.set("coverage", 0, 0, 1));
+    parameters.add(processMs.set("process ms", 0, 0, 10));
+    relearn.addListener(this, &ForegroundMask::setRelearn);
+}
+
+//--------------------------------------------------------------
+void ForegroundMask::setup(int _width, int _height) {
+    segmenter.setup(_width, _height);
+    pixels.allocate(_width, _height, 1);
+    pixels.set(0);
+    texture.allocate(_width, _height, GL_R8);
+    texture.setRGToRGBASwizzles(true);
+    texture.loadData(pixels);
+}
+
+//--------------------------------------------------------------
+void ForegroundMask::setRelearn(bool& _value) {
+    if (_value) {
+        segmenter.relearn();
+        relearn.set(false);
+    }
+}
+
+//--------------------------------------------------------------
+void ForegroundMask::update(const ofShortPixels& _rawDepth, bool _mirror) {
+    int width = segmenter.getWidth();
+    int height = segmenter.getHeight();
+    if ((int)_rawDepth.getWidth() != width || (int)_rawDepth.getHeight() != height)
+        return;
+
+    uint64_t start = ofGetElapsedTimeMicros();
+    segmenter.setRange(nearClip, farClip);
+    segmenter.setThreshold(threshold);
+    segmenter.setLearning(rise, fall);
+    segmenter.setFillRadius(fillRadius);
+    segmenter.process(_rawDepth.getData(), pixels.getData(), _mirror);
+    processMs.set((ofGetElapsedTimeMicros() - start) / 1000.0f);
+    coverage.set(segmenter.getCoverage());
+
+    texture.loadData(pixels);
+}
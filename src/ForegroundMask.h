@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ofMain.h"
+#include "DepthSegmenter.h"
+
+// The dancers and nothing else, as a texture: each new depth frame goes
+// through a DepthSegmenter on the CPU and the mask it leaves is uploaded
+// once, single channel, for the velocity mask to take as its density, so
+// the floor and the furniture no longer feed the fluid. "relearn" takes the
+// next frame as the empty room, for after the room has changed.
+// Render thread only.
+
+class ForegroundMask {
+public:
+    ForegroundMask();
+
+    void	setup(int _width, int _height);
+    // mirrored the same way as the depth texture
+    void	update(const ofShortPixels& _rawDepth, bool _mirror);
+
+    ofParameterGroup	parameters;
+
+    ofTexture&			getTexture()		{ return texture; }
+    const ofPixels&		getPixels() const	{ return pixels; }
+
+protected:
+    ofParameter<int>	nearClip;
+    ofParameter<int>	farClip;
+    ofParameter<int>	threshold;	// mm nearer than the background
+    ofParameter<float>	rise;		// mm a frame the background follows away from the camera
+    ofParameter<float>	fall;		// and towards it
+    ofParameter<int>	fillRadius;
+    ofParameter<bool>	relearn;
+    ofParameter<float>	coverage;	// readouts
+    ofParameter<float>	processMs;
+    void	setRelearn(bool& _value);
+
+    DepthSegmenter	segmenter;
+    ofPixels		pixels;
+    ofTexture		texture;		// GL_R8, red swizzled to grey
+};
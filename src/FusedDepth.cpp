@@ -0,0 +1,154 @@
+#include "FusedDepth.h"
+
+//--------------------------------------------------------------
+FusedDepth::FusedDepth() {
+    threadFuseMs = 0;
+
+    parameters.setName("fused depth");
+    parameters.add(layout.set("layout", ""));
+    parameters.add(numSensors.set("sensors", 0, 0, 8));
+    parameters.add(fuseMs.set("fuse ms", 0, 0, 20));
+}
+
+//--------------------------------------------------------------
+FusedDepth::~FusedDepth() {
+    close();
+}
+
+//--------------------------------------------------------------
+bool FusedDepth::setup(const string& _path) {
+    close();
+    ofXml xml;
+    if (!ofFile::doesFileExist(_path) || !xml.load(_path) || !xml.setTo("sensors"))
+        return false;
+
+    DepthFusion::View view = xml.getAttribute("view") == "top" ? DepthFusion::VIEW_TOP : DepthFusion::VIEW_FRONT;
+    int width = max(16, ofToInt(xml.getAttribute("width")));
+    int height = max(16, ofToInt(xml.getAttribute("height")));
+    DepthFusion::Box box = { -4, 4, 0.05f, 3, 0, 8 };
+    vector<DepthFusion::Pose> poses;
+    vector<float> focals;
+    vector<string> devices, serials;
+
+    for (int i=0; i<xml.getNumChildren(); i++) {
+        xml.setToChild(i);
+        if (xml.getName() == "box") {
+            box.minX = ofToFloat(xml.getAttribute("minX"));
+            box.maxX = ofToFloat(xml.getAttribute("maxX"));
+            box.minY = ofToFloat(xml.getAttribute("minY"));
+            box.maxY = ofToFloat(xml.getAttribute("maxY"));
+            box.minZ = ofToFloat(xml.getAttribute("minZ"));
+            box.maxZ = ofToFloat(xml.getAttribute("maxZ"));
+        }
+        else if (xml.getName() == "sensor") {
+            DepthFusion::Pose pose;
+            pose.x = ofToFloat(xml.getAttribute("x"));
+            pose.y = ofToFloat(xml.getAttribute("y"));
+            pose.z = ofToFloat(xml.getAttribute("z"));
+            pose.yaw = ofToFloat(xml.getAttribute("yaw"));
+            pose.pitch = ofToFloat(xml.getAttribute("pitch"));
+            pose.roll = ofToFloat(xml.getAttribute("roll"));
+            poses.push_back(pose);
+            focals.push_back(ofToFloat(xml.getAttribute("focal")));
+            devices.push_back(xml.getAttribute("device"));
+            serials.push_back(xml.getAttribute("serial"));
+        }
+        xml.setToParent();
+    }
+    if (box.maxX <= box.minX || box.maxY <= box.minY || box.maxZ <= box.minZ) {
+        ofLogError("FusedDepth") << "the box in " << _path << " is empty";
+        return false;
+    }
+
+    fusion.setup(view, width, height, box);
+    for (size_t s=0; s<poses.size(); s++) {
+        KinectGrabber* sensor = new KinectGrabber();
+        bool opened = serials[s].empty() ? sensor->setup(devices[s].empty() ? -1 : ofToInt(devices[s])) : sensor->setup(serials[s]);
+        if (!opened) {
+            delete sensor;
+            continue;
+        }
+        sensor->parameters.setName("kinect " + ofToString(sensors.size()));
+        sensorIndices.push_back(fusion.addSensor(sensor->getWidth(), sensor->getHeight(), poses[s], focals[s]));
+        sensors.push_back(sensor);
+    }
+    if (sensors.empty()) {
+        ofLogError("FusedDepth") << "none of the " << poses.size() << " sensors in " << _path << " opened";
+        return false;
+    }
+
+    layout.set(ofFilePath::getFileName(_path));
+    numSensors.set(sensors.size());
+    for (size_t s=0; s<sensors.size(); s++)
+        parameters.add(sensors[s]->parameters);
+    ofLogNotice("FusedDepth") << sensors.size() << " of " << poses.size() << " sensors into " << width << " x " << height << (view == DepthFusion::VIEW_TOP ? " from above" : " from the front");
+    startThread();
+    return true;
+}
+
+//--------------------------------------------------------------
+void FusedDepth::close() {
+    if (isThreadRunning())
+        waitForThread(true);
+    for (size_t s=0; s<sensors.size(); s++) {
+        sensors[s]->close();
+        delete sensors[s];
+    }
+    sensors.clear();
+    sensorIndices.clear();
+    fusion.clearSensors();
+}
+
+//--------------------------------------------------------------
+bool FusedDepth::setTiltAngle(float _degrees) {
+    for (size_t s=0; s<sensors.size(); s++)
+        sensors[s]->setTiltAngle(_degrees);
+    return !sensors.empty();
+}
+
+//--------------------------------------------------------------
+void FusedDepth::setRecording(bool _recording) {
+    for (size_t s=0; s<sensors.size(); s++)
+        sensors[s]->setRecording(_recording);
+}
+
+//--------------------------------------------------------------
+bool FusedDepth::update() {
+    for (size_t s=0; s<sensors.size(); s++)
+        sensors[s]->updateReadouts();
+    fuseMs.set(threadFuseMs.load());
+    return DepthSource::update();
+}
+
+//--------------------------------------------------------------
+void FusedDepth::threadedFunction() {
+    while (isThreadRunning()) {
+        // every sensor's newest, and nothing to do until one of them moves
+        bool fresh = false;
+        for (size_t s=0; s<sensors.size(); s++)
+            fresh = sensors[s]->acquire() || fresh;
+        if (!fresh) {
+            sleep(1);
+            continue;
+        }
+
+        uint64_t start = ofGetElapsedTimeMicros();
+        // stamped with the oldest image in it, so the latency stages show
+        // how stale the stitched stage can be rather than its freshest part
+        uint64_t captured = 0;
+        fusion.begin();
+        for (size_t s=0; s<sensors.size(); s++) {
+            const DepthFrame& frame = sensors[s]->getFrame();
+            if (frame.sequence == 0 || (int)frame.rawDepth.getWidth() != sensors[s]->getWidth())
+                continue;
+            fusion.add(sensorIndices[s], frame.rawDepth.getData());
+            captured = captured == 0 ? frame.capturedMicros : min(captured, frame.capturedMicros);
+        }
+        DepthFrame& back = getBackFrame();
+        back.rawDepth.allocate(fusion.getWidth(), fusion.getHeight(), 1);
+        fusion.end(back.rawDepth.getData());
+        back.capturedMicros = captured;
+        threadFuseMs.store((ofGetElapsedTimeMicros() - start) / 1000.0f);
+        publish();
+    }
+}
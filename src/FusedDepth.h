@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ofMain.h"
+#include "DepthSource.h"
+#include "DepthFusion.h"
+#include "KinectGrabber.h"
+
+// Several Kinects as one DepthSource, for a stage wider than one of them
+// sees. Every sensor runs on its own grabber thread as before; the fusion
+// thread takes whatever is newest from each of them whenever any has a new
+// frame, stitches them with a DepthFusion and publishes the result, so the
+// render thread gets one depth image of the stage however many sensors
+// there are and never waits on any. The layout and the calibration come
+// from an xml file, stage coordinates in metres (see DepthFusion):
+//     <sensors view="front" width="640" height="240">
+//         <box minX="-4" maxX="4" minY="0.05" maxY="3" minZ="0" maxZ="8"/>
+//         <sensor device="0" x="-1.5" y="1" z="0" yaw="-20" pitch="-5" roll="0"/>
+//         <sensor serial="A00365A01234567A" x="1.5" y="1" z="0" yaw="20"/>
+//     </sensors>
+// with view "front" or "top", and "focal" on a sensor for other than the
+// Kinect's optics.
+
+class FusedDepth : public DepthSource {
+public:
+    FusedDepth();
+    ~FusedDepth();
+
+    // false when the file isn't there or no sensor in it opens
+    bool	setup(const string& _path);
+    void	close();
+
+    int		getWidth() const		{ return fusion.getWidth(); }
+    int		getHeight() const		{ return fusion.getHeight(); }
+    int		getNumSensors() const	{ return sensors.size(); }
+    // every sensor to the same angle, each from its own thread
+    bool	setTiltAngle(float _degrees);
+    void	setRecording(bool _recording);
+
+    // render thread, also publishes every sensor's counts
+    bool	update();
+
+protected:
+    void	threadedFunction();
+
+    ofParameter<string>	layout;
+    ofParameter<int>	numSensors;
+    ofParameter<float>	fuseMs;		// readout
+
+    DepthFusion					fusion;
+    vector<KinectGrabber*>		sensors;
+    vector<int>					sensorIndices;	// each one's index in the fusion
+    std::atomic<float>			threadFuseMs;
+};
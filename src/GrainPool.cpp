@@ -0,0 +1,208 @@
+#include "GrainPool.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+//--------------------------------------------------------------
+GrainPool::GrainPool() {
+    sample = NULL;
+    sampleFrames = 0;
+    sampleChannels = 1;
+    rateRatio = 1;
+    numActive = 0;
+    dropped = 0;
+    numEmitters = 0;
+    outputSampleRate = 44100;
+    grainLength = 1;
+    jitter = 0;
+    seed = 0x9e3779b9;
+    for (int g=0; g<maxGrains; g++)
+        grains[g].active = false;
+    for (int e=0; e<maxEmitters; e++)
+        owed[e] = 0;
+}
+
+//--------------------------------------------------------------
+void GrainPool::setup(int _outputSampleRate, int _maxBlockSize) {
+    outputSampleRate = _outputSampleRate;
+    setGrainLength(60);
+
+    // padded to a whole number of vectors
+    int size = (_maxBlockSize + simd::width - 1) / simd::width * simd::width;
+    scratch.assign(size, 0);
+    ramp.resize(size);
+    for (int i=0; i<size; i++)
+        ramp[i] = i;
+}
+
+//--------------------------------------------------------------
+void GrainPool::setSample(const float* _data, int64_t _numFrames, int _numChannels, float _rateRatio) {
+    for (int g=0; g<maxGrains; g++)
+        grains[g].active = false;
+    numActive = 0;
+    sample = _data;
+    sampleFrames = _numFrames;
+    sampleChannels = _numChannels;
+    rateRatio = _rateRatio;
+}
+
+//--------------------------------------------------------------
+void GrainPool::setEmitters(const GrainEmitter* _emitters, int _numEmitters) {
+    numEmitters = std::min(_numEmitters, (int)maxEmitters);
+    std::copy(_emitters, _emitters + numEmitters, emitters);
+}
+
+//--------------------------------------------------------------
+void GrainPool::setGrainLength(float _ms) {
+    // grains already playing keep their own length
+    grainLength = std::max(16, (int)(_ms * outputSampleRate / 1000));
+}
+
+//--------------------------------------------------------------
+float GrainPool::random() {
+    // xorshift, good enough to scatter grains
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+//--------------------------------------------------------------
+void GrainPool::spawn(int _emitter, int _delay) {
+    int slot = -1;
+    for (int g=0; g<maxGrains; g++) {
+        if (!grains[g].active) {
+            slot = g;
+            break;
+        }
+    }
+    if (slot < 0) {
+        dropped++;
+        return;
+    }
+
+    const GrainEmitter& emitter = emitters[_emitter];
+    float position = emitter.position + jitter * (2 * random() - 1);
+    position = std::max(0.0f, std::min(1.0f, position));
+    const float quarterPi = 0.785398163f;
+    float angle = (std::max(-1.0f, std::min(1.0f, emitter.pan)) + 1) * quarterPi;
+
+    Grain& grain = grains[slot];
+    grain.active = true;
+    grain.age = -_delay;
+    grain.length = grainLength;
+    grain.position = position * (sampleFrames - 1);
+    grain.step = emitter.pitch * rateRatio;
+    grain.emitter = _emitter;
+    grain.gain = emitter.gain;
+    grain.gainLeft = cosf(angle) * emitter.gain;
+    grain.gainRight = sinf(angle) * emitter.gain;
+    numActive++;
+}
+
+//--------------------------------------------------------------
+void GrainPool::read(Grain& _grain, int _numFrames) {
+    // mono, linear interpolation, silence past either end
+    double position = _grain.position;
+    for (int i=0; i<_numFrames; i++) {
+        int64_t p = (int64_t)position;
+        float t = position - p;
+        float a = 0, b = 0;
+        if (p >= 0 && p + 1 < sampleFrames) {
+            const float* s = sample + p * sampleChannels;
+            a = s[0];
+            b = s[sampleChannels];
+            if (sampleChannels > 1) {
+                a = 0.5f * (a + s[1]);
+                b = 0.5f * (b + s[sampleChannels + 1]);
+            }
+        }
+        scratch[i] = a + (b - a) * t;
+        position += _grain.step;
+    }
+    _grain.position = position;
+}
+
+//--------------------------------------------------------------
+void GrainPool::render(float* _left, float* _right, int _numFrames) {
+    mix(_left, _right, NULL, 0, _numFrames);
+}
+
+//--------------------------------------------------------------
+void GrainPool::renderSources(float* const* _sources, int _numSources, int _numFrames) {
+    if (_numSources > 0)
+        mix(NULL, NULL, _sources, _numSources, _numFrames);
+}
+
+//--------------------------------------------------------------
+void GrainPool::addScaled(const float* _src, float* _dst, float _gain, int _numFrames) const {
+    simd::vfloat gain = simd::set1(_gain);
+    int i = 0;
+    for (; i+simd::width<=_numFrames; i+=simd::width)
+        simd::store(_dst + i, simd::madd(simd::load(_src + i), gain, simd::load(_dst + i)));
+    for (; i<_numFrames; i++)
+        _dst[i] += _src[i] * _gain;
+}
+
+//--------------------------------------------------------------
+void GrainPool::mix(float* _left, float* _right, float* const* _sources, int _numSources, int _numFrames) {
+    if (sample == NULL || sampleFrames < 2)
+        return;
+    int n = std::min(_numFrames, (int)scratch.size());
+
+    // new grains for this block, each at a random frame inside it
+    float seconds = (float)n / outputSampleRate;
+    for (int e=0; e<numEmitters; e++) {
+        // a burst of rate never piles up more than a few grains at once
+        owed[e] = std::min(owed[e] + emitters[e].rate * seconds, 4.0f);
+        for (; owed[e] >= 1; owed[e] -= 1)
+            spawn(e, std::min((int)(random() * n), n - 1));
+    }
+
+    for (int g=0; g<maxGrains; g++) {
+        Grain& grain = grains[g];
+        if (!grain.active)
+            continue;
+
+        int start = std::max(0, -grain.age);
+        int age = std::max(0, grain.age);
+        int frames = std::min(n - start, grain.length - age);
+        if (frames > 0) {
+            read(grain, frames);
+
+            // the window is (4 t (1 - t))^2, close to a hann window without the cosine
+            float invLength = 1.0f / grain.length;
+            simd::vfloat t0 = simd::set1(age * invLength);
+            simd::vfloat dt = simd::set1(invLength);
+            simd::vfloat one = simd::set1(1.0f);
+            simd::vfloat four = simd::set1(4.0f);
+            int i = 0;
+            for (; i+simd::width<=frames; i+=simd::width) {
+                simd::vfloat t = simd::madd(simd::load(&ramp[i]), dt, t0);
+                simd::vfloat w = simd::mul(four, simd::mul(t, simd::sub(one, t)));
+                simd::store(&scratch[i], simd::mul(simd::load(&scratch[i]), simd::mul(w, w)));
+            }
+            for (; i<frames; i++) {
+                float t = (age + i) * invLength;
+                float w = 4 * t * (1 - t);
+                scratch[i] *= w * w;
+            }
+
+            if (_sources != NULL) {
+                // mono, the emitter's source does the panning
+                addScaled(scratch.data(), _sources[std::min(grain.emitter, _numSources - 1)] + start, grain.gain, frames);
+            }
+            else {
+                addScaled(scratch.data(), _left + start, grain.gainLeft, frames);
+                addScaled(scratch.data(), _right + start, grain.gainRight, frames);
+            }
+        }
+
+        grain.age += n;
+        if (grain.age >= grain.length) {
+            grain.active = false;
+            numActive--;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Granular synthesis over a sample held in RAM, rendered into planar
+// stereo. Each emitter spawns grains at its own rate (scattered over the
+// block at random frames) reading around its own position in the sample at
+// its own pitch and pan; a grain is a short read of the sample under a
+// smooth bell shaped window. The window and the mix are vectorized, the
+// read is a linear interpolation. Grains that find the pool full are
+// dropped and counted. renderSources() mixes each emitter's grains mono
+// into its own buffer instead, for a Spatializer to place.
+// Audio thread only, no allocation after setup(), no openFrameworks.
+
+struct GrainEmitter {
+    float	rate;		// grains per second
+    float	position;	// 0 .. 1 through the sample
+    float	pitch;		// playback speed
+    float	pan;		// -1 left .. 1 right
+    float	gain;
+};
+
+class GrainPool {
+public:
+    static const int	maxGrains = 512;
+    static const int	maxEmitters = 64;
+
+    GrainPool();
+
+    void	setup(int _outputSampleRate, int _maxBlockSize);
+    void	setSample(const float* _data, int64_t _numFrames, int _numChannels, float _rateRatio);
+    void	setEmitters(const GrainEmitter* _emitters, int _numEmitters);
+    void	setGrainLength(float _ms);
+    void	setJitter(float _jitter)	{ jitter = _jitter; }	// random offset from the position, fraction of the sample
+
+    int			getNumActive() const	{ return numActive; }
+    uint64_t	getNumDropped() const	{ return dropped; }
+
+    // adds _numFrames (at most the setup() block size) into _left and _right
+    void	render(float* _left, float* _right, int _numFrames);
+    // or into _sources[emitter], the last one taking any emitters beyond it
+    void	renderSources(float* const* _sources, int _numSources, int _numFrames);
+
+private:
+    struct Grain {
+        bool		active;
+        int			age;			// frames played, negative until it starts
+        int			length;
+        double		position;		// in sample frames
+        float		step;
+        int			emitter;
+        float		gain;
+        float		gainLeft;
+        float		gainRight;
+    };
+
+    float	random();				// 0 .. 1
+    void	spawn(int _emitter, int _delay);
+    void	read(Grain& _grain, int _numFrames);
+    void	mix(float* _left, float* _right, float* const* _sources, int _numSources, int _numFrames);
+    void	addScaled(const float* _src, float* _dst, float _gain, int _numFrames) const;
+
+    const float*		sample;
+    int64_t				sampleFrames;
+    int					sampleChannels;
+    float				rateRatio;
+
+    Grain				grains[maxGrains];
+    int					numActive;
+    uint64_t			dropped;
+    GrainEmitter		emitters[maxEmitters];
+    float				owed[maxEmitters];		// fractional grains carried to the next block
+    int					numEmitters;
+
+    int					outputSampleRate;
+    int					grainLength;			// frames
+    float				jitter;
+    uint32_t			seed;
+
+    std::vector<float>	scratch;		// one grain, read and windowed
+    std::vector<float>	ramp;			// 0, 1, 2, ... for the vector window
+};
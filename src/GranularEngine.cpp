@@ -0,0 +1,162 @@
+#include "GranularEngine.h"
+
+//--------------------------------------------------------------
+GranularEngine::GranularEngine() {
+    sample = NULL;
+    active = 0;
+    droppedFields = 0;
+    maxBlockSize = 0;
+    outputSampleRate = 44100;
+    sampleReady = false;
+    field.numEmitters = 0;
+    current.numEmitters = 0;
+
+    // a few frames worth, the callback only keeps the latest
+    fields.setup(4);
+
+    parameters.setName("granular");
+    parameters.add(enabled.set("enabled", true));
+    parameters.add(volume.set("volume", 0.8, 0.0, 4.0));
+    parameters.add(density.set("density", 1500, 0, 8000));
+    parameters.add(grainLength.set("grain ms", 80, 5, 500));
+    parameters.add(fullSpeed.set("full speed", 1.0, 0.01, 10.0));
+    parameters.add(fullCurl.set("full curl", 0.5, 0.01, 5.0));
+    parameters.add(pitchRange.set("pitch range", 1.0, 0.0, 3.0));
+    parameters.add(jitter.set("jitter", 0.02, 0.0, 0.5));
+    parameters.add(activeGrains.set("grains", 0, 0, GrainPool::maxGrains));
+}
+
+//--------------------------------------------------------------
+void GranularEngine::setup(const PcmTrack& _sample, int _outputSampleRate, int _maxBlockSize) {
+    sample = &_sample;
+    maxBlockSize = _maxBlockSize;
+    mixLeft.assign(maxBlockSize, 0);
+    mixRight.assign(maxBlockSize, 0);
+    pool.setup(_outputSampleRate, maxBlockSize);
+    outputSampleRate = _outputSampleRate;
+    sampleReady = false;
+}
+
+//--------------------------------------------------------------
+void GranularEngine::setField(const float* _velocity, int _width, int _height) {
+    int columns = min(regionsX, _width);
+    int rows = min(regionsY, _height);
+    int count = columns * rows;
+    float speed[numRegions] = { 0 };
+    float curl[numRegions] = { 0 };
+    int cells[numRegions] = { 0 };
+
+    // mean speed and curl (central differences, one sided at the edges) per region
+    for (int y=0; y<_height; y++) {
+        int up = min(y + 1, _height - 1);
+        int down = max(y - 1, 0);
+        for (int x=0; x<_width; x++) {
+            int right = min(x + 1, _width - 1);
+            int left = max(x - 1, 0);
+            const float* v = _velocity + (y * _width + x) * 2;
+            float dvydx = (_velocity[(y * _width + right) * 2 + 1] - _velocity[(y * _width + left) * 2 + 1]) / max(right - left, 1);
+            float dvxdy = (_velocity[(up * _width + x) * 2] - _velocity[(down * _width + x) * 2]) / max(up - down, 1);
+
+            int region = (y * rows / _height) * columns + x * columns / _width;
+            speed[region] += sqrtf(v[0] * v[0] + v[1] * v[1]);
+            curl[region] += dvydx - dvxdy;
+            cells[region]++;
+        }
+    }
+
+    float grainSeconds = grainLength * 0.001f;
+    float totalRate = 0;
+    field.numEmitters = enabled ? count : 0;
+    for (int r=0; r<field.numEmitters; r++) {
+        float energy = ofClamp(speed[r] / max(cells[r], 1) / fullSpeed, 0, 1);
+        float bend = ofClamp(curl[r] / max(cells[r], 1) / fullCurl, -1, 1);
+        GrainEmitter& emitter = field.emitters[r];
+        emitter.rate = density * energy / count;
+        emitter.position = ((r / columns) + 0.5f) / rows;
+        emitter.pitch = powf(2.0f, bend * pitchRange);
+        emitter.pan = ((r % columns) + 0.5f) / columns * 2 - 1;
+        emitter.gain = 0.5f + 0.5f * energy;
+        totalRate += emitter.rate;
+    }
+
+    // keep the level steady however many grains overlap
+    float level = volume / sqrtf(max(1.0f, totalRate * grainSeconds));
+    for (int r=0; r<field.numEmitters; r++)
+        field.emitters[r].gain *= level;
+    field.grainLength = grainLength;
+    field.jitter = jitter;
+
+    if (!fields.push(field))
+        droppedFields++;
+}
+
+//--------------------------------------------------------------
+void GranularEngine::update() {
+    activeGrains.set(active.load());
+}
+
+//--------------------------------------------------------------
+ofVec2f GranularEngine::getRegionCenter(int _region) {
+    return ofVec2f(((_region % regionsX) + 0.5f) / regionsX * 2 - 1, ((_region / regionsX) + 0.5f) / regionsY * 2 - 1);
+}
+
+//--------------------------------------------------------------
+bool GranularEngine::prepare() {
+    bool changed = false;
+    while (fields.pop(current))
+        changed = true;
+    if (!sampleReady && sample != NULL && sample->isDecoded()) {
+        pool.setSample(sample->getSamples(), sample->getNumFrames(), sample->getNumChannels(), (float)sample->getSampleRate() / outputSampleRate);
+        sampleReady = true;
+    }
+    if (!sampleReady)
+        return false;
+    if (changed) {
+        pool.setEmitters(current.emitters, current.numEmitters);
+        pool.setGrainLength(current.grainLength);
+        pool.setJitter(current.jitter);
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+void GranularEngine::render(float* _output, int _numFrames, int _numChannels) {
+    if (!prepare())
+        return;
+
+    // planar mix for the vectorized window, interleaved at the end
+    for (int start=0; start<_numFrames; start+=maxBlockSize) {
+        int n = min(maxBlockSize, _numFrames - start);
+        std::fill(mixLeft.begin(), mixLeft.begin() + n, 0.0f);
+        std::fill(mixRight.begin(), mixRight.begin() + n, 0.0f);
+        pool.render(mixLeft.data(), mixRight.data(), n);
+
+        float* frame = _output + start * _numChannels;
+        if (_numChannels == 1) {
+            for (int i=0; i<n; i++)
+                frame[i] += 0.5f * (mixLeft[i] + mixRight[i]);
+        }
+        else {
+            for (int i=0; i<n; i++, frame+=_numChannels) {
+                frame[0] += mixLeft[i];
+                frame[1] += mixRight[i];
+            }
+        }
+    }
+    active.store(pool.getNumActive());
+}
+
+//--------------------------------------------------------------
+void GranularEngine::renderSources(float* const* _sources, int _numSources, int _numFrames) {
+    if (!prepare())
+        return;
+
+    float* sources[GrainPool::maxEmitters];
+    int numSources = min(_numSources, (int)GrainPool::maxEmitters);
+    for (int start=0; start<_numFrames; start+=maxBlockSize) {
+        for (int s=0; s<numSources; s++)
+            sources[s] = _sources[s] + start;
+        pool.renderSources(sources, numSources, min(maxBlockSize, _numFrames - start));
+    }
+    active.store(pool.getNumActive());
+}
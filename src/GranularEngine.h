@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ofMain.h"
+#include "PcmTrack.h"
+#include "SpscRing.h"
+#include "GrainPool.h"
+
+// Sonifies a velocity field with a cloud of grains over a sample. The field
+// (the fluid's velocity read back at low resolution) is split into regions,
+// one grain emitter each: the faster a region moves the more grains it
+// emits and the louder, its curl bends the pitch up or down (by direction
+// of spin), its column sets the pan and its row where in the sample the
+// grains are read. The render thread sends the emitters to the audio
+// callback through a lock free ring once per frame; render() only swaps in
+// the latest set and mixes, it never locks or allocates.
+
+class GranularEngine {
+public:
+    static const int	regionsX = 8;
+    static const int	regionsY = 6;
+    static const int	numRegions = regionsX * regionsY;
+
+    GranularEngine();
+
+    void	setup(const PcmTrack& _sample, int _outputSampleRate, int _maxBlockSize = 4096);
+
+    ofParameterGroup	parameters;
+
+    // render thread, _velocity is _width x _height cells of x, y
+    void	setField(const float* _velocity, int _width, int _height);
+    void	update();		// publishes the grain count to the gui
+
+    // where region _region sits on the floor, -1 .. 1 both ways
+    static ofVec2f	getRegionCenter(int _region);
+
+    // audio thread, adds into _output
+    void	render(float* _output, int _numFrames, int _numChannels);
+    // or mono, region r into _sources[r], to be placed by a Spatializer
+    void	renderSources(float* const* _sources, int _numSources, int _numFrames);
+
+protected:
+    bool	prepare();		// takes the latest field, false until the sample is in
+
+    struct GrainField {
+        int				numEmitters;
+        float			grainLength;	// ms
+        float			jitter;
+        GrainEmitter	emitters[GrainPool::maxEmitters];
+    };
+
+    ofParameter<bool>	enabled;
+    ofParameter<float>	volume;
+    ofParameter<float>	density;		// grains per second with the whole field at full speed
+    ofParameter<float>	grainLength;	// ms
+    ofParameter<float>	fullSpeed;		// velocity that counts as full speed
+    ofParameter<float>	fullCurl;		// curl that bends the pitch the whole range
+    ofParameter<float>	pitchRange;		// octaves
+    ofParameter<float>	jitter;
+    ofParameter<int>	activeGrains;
+
+    const PcmTrack*		sample;
+
+    GrainField					field;			// render thread, being filled
+    SpscRing<GrainField>		fields;
+    std::atomic<int>			active;
+    std::atomic<uint64_t>		droppedFields;
+
+    // audio thread only
+    GrainField			current;
+    GrainPool			pool;
+    int					maxBlockSize;
+    int					outputSampleRate;
+    bool				sampleReady;	// handed to the pool once decoded
+    vector<float>		mixLeft;
+    vector<float>		mixRight;
+};
@@ -0,0 +1,127 @@
+#include "KinectGrabber.h"
+
+namespace {
+    // mm, past anything the kinect reads
+    const int	maxClip = 10000;
+}
+
+//--------------------------------------------------------------
+KinectGrabber::KinectGrabber() {
+    tiltDegrees = 0;
+    ledMode = LED_DEFAULT;
+    nearClipping = 0;
+    farClipping = maxClip;
+    pending = 0;
+    clipNear = 0;
+    clipFar = maxClip;
+
+    parameters.setName("kinect");
+    parameters.add(nearClip.set("near clip mm", 0, 0, maxClip));
+    parameters.add(farClip.set("far clip mm", maxClip, 0, maxClip));
+    nearClip.addListener(this, &KinectGrabber::setClip);
+    farClip.addListener(this, &KinectGrabber::setClip);
+}
+
+//--------------------------------------------------------------
+KinectGrabber::~KinectGrabber() {
+    close();
+}
+
+//--------------------------------------------------------------
+bool KinectGrabber::setup(int _deviceId) {
+    close();
+    kinect.init(false, false, false);
+    return start(kinect.open(_deviceId), _deviceId < 0 ? string("the kinect") : "kinect " + ofToString(_deviceId));
+}
+
+//--------------------------------------------------------------
+bool KinectGrabber::setup(const string& _serial) {
+    close();
+    kinect.init(false, false, false);
+    return start(kinect.open(_serial), "kinect " + _serial);
+}
+
+//--------------------------------------------------------------
+bool KinectGrabber::start(bool _opened, const string& _which) {
+    if (!_opened) {
+        ofLogError("KinectGrabber") << "could not open " << _which;
+        return false;
+    }
+    startThread();
+    return true;
+}
+
+//--------------------------------------------------------------
+void KinectGrabber::close() {
+    if (isThreadRunning())
+        waitForThread(true);
+    kinect.close();
+}
+
+//--------------------------------------------------------------
+bool KinectGrabber::setTiltAngle(float _degrees) {
+    tiltDegrees.store(_degrees);
+    pending.fetch_or(COMMAND_TILT);
+    return true;
+}
+
+//--------------------------------------------------------------
+void KinectGrabber::setRecording(bool _recording) {
+    setLed(_recording ? LED_BLINK_YELLOW_RED : LED_DEFAULT);
+}
+
+//--------------------------------------------------------------
+void KinectGrabber::setLed(ofxKinectLedMode _mode) {
+    ledMode.store(_mode);
+    pending.fetch_or(COMMAND_LED);
+}
+
+//--------------------------------------------------------------
+void KinectGrabber::setDepthClipping(float _nearMm, float _farMm) {
+    nearClipping.store(_nearMm);
+    farClipping.store(_farMm);
+    pending.fetch_or(COMMAND_CLIPPING);
+}
+
+//--------------------------------------------------------------
+void KinectGrabber::sendCommands() {
+    // a value set again while this runs flags its command again, so the
+    // device always ends up with the last one
+    uint32_t commands = pending.exchange(0);
+    if (commands & COMMAND_TILT)
+        kinect.setCameraTiltAngle(tiltDegrees.load());
+    if (commands & COMMAND_LED)
+        kinect.setLed((ofxKinectLedMode)ledMode.load());
+    if (commands & COMMAND_CLIPPING) {
+        float nearMm = nearClipping.load();
+        float farMm = farClipping.load();
+        kinect.setDepthClipping(nearMm, farMm);
+        clipNear = ofClamp(nearMm, 0, maxClip);
+        clipFar = ofClamp(farMm, 0, maxClip);
+    }
+}
+
+//--------------------------------------------------------------
+void KinectGrabber::threadedFunction() {
+    while (isThreadRunning()) {
+        if (pending.load() != 0)
+            sendCommands();
+        kinect.update();
+        if (!kinect.isFrameNew()) {
+            sleep(1);
+            continue;
+        }
+
+        // the slot's pixels keep their allocation, this is one copy
+        DepthFrame& frame = getBackFrame();
+        frame.rawDepth = kinect.getRawDepthPixels();
+        frame.capturedMicros = ofGetElapsedTimeMicros();
+        if (clipNear > 0 || clipFar < maxClip) {
+            uint16_t* depth = frame.rawDepth.getData();
+            size_t count = frame.rawDepth.size();
+            for (size_t i=0; i<count; i++)
+                depth[i] = depth[i] < clipNear || depth[i] > clipFar ? 0 : depth[i];
+        }
+        publish();
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxKinect.h"
+#include "DepthSource.h"
+
+// Runs the Kinect on its own thread, so USB stalls and the frame copies never
+// hold up the render thread. The thread is the only one that touches the
+// device's pixels: it copies each new depth frame into the back slot and
+// publishes it. Only depth is streamed, and textures are left to the caller.
+// Device commands are the thread's too, since a USB control transfer can
+// stall for tens of milliseconds: the setters only leave the value in the
+// command's slot and flag it, and the thread sends whatever is flagged
+// between frames, so a burst of key presses costs one transfer with the
+// last value in it. The LED blinks while the depth is being recorded. The
+// clipping range goes to ofxKinect as well, but since it only clips the 8
+// bit image this grabber never asks for, the thread also drops the raw
+// readings outside it, so the back wall can be cut from every stage at
+// once.
+
+class KinectGrabber : public DepthSource {
+public:
+    KinectGrabber();
+    ~KinectGrabber();
+
+    // the first free kinect, or the one at _deviceId, or with _serial
+    bool	setup(int _deviceId = -1);
+    bool	setup(const string& _serial);
+    void	close();
+    bool	isConnected()				{ return kinect.isConnected(); }
+
+    int		getWidth() const			{ return kinect.width; }
+    int		getHeight() const			{ return kinect.height; }
+    // any thread, never wait on the device
+    bool	setTiltAngle(float _degrees);
+    void	setRecording(bool _recording);
+    void	setLed(ofxKinectLedMode _mode);
+    void	setDepthClipping(float _nearMm, float _farMm);
+
+protected:
+    bool	start(bool _opened, const string& _which);
+    void	threadedFunction();
+    void	sendCommands();
+
+    enum Command {
+        COMMAND_TILT = 1,
+        COMMAND_LED = 2,
+        COMMAND_CLIPPING = 4
+    };
+
+    ofxKinect	kinect;
+
+    ofParameter<int>	nearClip;	// mm, readings nearer are dropped
+    ofParameter<int>	farClip;	// mm, and further
+    void				setClip(int& _value)	{ setDepthClipping(nearClip, farClip); }
+
+    // the latest value of each command, and which of them are waiting
+    std::atomic<float>		tiltDegrees;
+    std::atomic<int>		ledMode;
+    std::atomic<float>		nearClipping;
+    std::atomic<float>		farClipping;
+    std::atomic<uint32_t>	pending;
+
+    // grabber thread only, the range last sent
+    uint16_t	clipNear;
+    uint16_t	clipFar;
+};
@@ -0,0 +1,86 @@
+#include "LatencyTracer.h"
+
+#include <algorithm>
+
+namespace {
+    float percentile(const std::vector<float>& _sorted, int _count, float _fraction) {
+        int i = (int)(_fraction * _count);
+        return _sorted[std::min(i, _count - 1)];
+    }
+}
+
+//--------------------------------------------------------------
+LatencyTracer::LatencyTracer() {
+    numStages = 0;
+    window = 0;
+    reset();
+}
+
+//--------------------------------------------------------------
+void LatencyTracer::setup(int _numStages, int _window) {
+    numStages = std::max(1, std::min(_numStages, (int)maxStages));
+    window = std::max(1, _window);
+    ages.assign(numStages * window, 0);
+    counts.assign(numStages, 0);
+    sorted.reserve(window);
+    reset();
+}
+
+//--------------------------------------------------------------
+void LatencyTracer::reset() {
+    for (int r=0; r<maxInFlight; r++) {
+        rows[r].sequence = 0;
+        rows[r].capturedMicros = 0;
+        for (int s=0; s<maxStages; s++)
+            rows[r].ages[s] = -1;
+    }
+    for (int s=0; s<maxStages; s++) {
+        spreads[s].p50 = 0;
+        spreads[s].p95 = 0;
+        spreads[s].p99 = 0;
+        spreads[s].count = 0;
+    }
+    counts.assign(counts.size(), 0);
+}
+
+//--------------------------------------------------------------
+bool LatencyTracer::mark(int _stage, uint64_t _sequence, uint64_t _capturedMicros, uint64_t _micros) {
+    if (_sequence == 0 || _stage < 0 || _stage >= numStages)
+        return false;
+
+    // the slot is the frame's when it is the newest there, a frame older
+    // than its slot's is long gone
+    Row& row = rows[_sequence % maxInFlight];
+    if (row.sequence > _sequence)
+        return false;
+    if (row.sequence != _sequence) {
+        row.sequence = _sequence;
+        row.capturedMicros = _capturedMicros;
+        for (int s=0; s<maxStages; s++)
+            row.ages[s] = -1;
+    }
+    if (row.ages[_stage] >= 0)
+        return false;
+
+    float age = _micros > _capturedMicros ? (_micros - _capturedMicros) / 1000.0f : 0.0f;
+    row.ages[_stage] = age;
+    ages[_stage * window + counts[_stage] % window] = age;
+    counts[_stage]++;
+    return _stage == numStages - 1;
+}
+
+//--------------------------------------------------------------
+void LatencyTracer::updateSpreads() {
+    for (int s=0; s<numStages; s++) {
+        int n = std::min(counts[s], window);
+        Spread& spread = spreads[s];
+        spread.count = n;
+        if (n == 0)
+            continue;
+        sorted.assign(ages.begin() + s * window, ages.begin() + s * window + n);
+        std::sort(sorted.begin(), sorted.end());
+        spread.p50 = percentile(sorted, n, 0.50f);
+        spread.p95 = percentile(sorted, n, 0.95f);
+        spread.p99 = percentile(sorted, n, 0.99f);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// How old each depth frame is as it goes down a pipeline of stages. Every
+// stage marks the frame it is working from, by the sequence and capture
+// time the source gave it, whenever it runs; the first time a frame
+// reaches a stage counts, since stages that run every app frame see the
+// same depth frame several times and only its first showing carries the
+// new movement. The last few hundred ages of each stage are kept for
+// their p50, p95 and p99, and each frame's row of ages, for a log, once
+// it reaches the last stage. Frames that never get there, dropped on the
+// way, simply fall out of the rows. No allocation after setup(), no
+// openFrameworks.
+
+class LatencyTracer {
+public:
+    static const int	maxStages = 8;
+    static const int	maxInFlight = 16;	// frames between the first stage and the last
+
+    // one frame's way down the stages, ms since it was captured, -1 where
+    // it hasn't got to yet
+    struct Row {
+        uint64_t	sequence;
+        uint64_t	capturedMicros;
+        float		ages[maxStages];
+    };
+
+    struct Spread {
+        float	p50, p95, p99;		// ms
+        int		count;				// ages they are taken over
+    };
+
+    LatencyTracer();
+
+    void	setup(int _numStages, int _window);
+    void	reset();
+
+    // frame _sequence, captured at _capturedMicros, reached _stage at
+    // _micros. True when that completes its row
+    bool	mark(int _stage, uint64_t _sequence, uint64_t _capturedMicros, uint64_t _micros);
+    const Row&	getRow(uint64_t _sequence) const	{ return rows[_sequence % maxInFlight]; }
+
+    // the percentiles of every stage over the window, a sort each
+    void	updateSpreads();
+    const Spread&	getSpread(int _stage) const		{ return spreads[_stage]; }
+    int		getNumStages() const	{ return numStages; }
+
+private:
+    int		numStages;
+    int		window;
+    Row		rows[maxInFlight];
+    Spread	spreads[maxStages];
+    std::vector<float>	ages;		// a ring of the window per stage
+    std::vector<int>	counts;		// ages written to each stage's ring
+    std::vector<float>	sorted;
+};
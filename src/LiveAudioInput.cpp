@@ -0,0 +1,121 @@
+#include "LiveAudioInput.h"
+
+//--------------------------------------------------------------
+LiveAudioInput::LiveAudioInput() {
+    opened = false;
+    sampleRate = 44100;
+    bufferSize = 128;
+    callbackGain = 1.0f;
+    peak = 0.0f;
+    overruns = 0;
+    stampSequence = 0;
+    stampSamples = 0;
+    stampMicros = 0;
+    written = 0;
+    consumed = 0;
+
+    // half a second, the analysis thread only ever lets a few hops queue.
+    // It stays allocated for good so the reader never sees it move.
+    ring.setup(ofNextPow2(sampleRate / 2));
+
+    parameters.setName("audio input");
+    parameters.add(enabled.set("live input", false));
+    parameters.add(deviceId.set("device", -1, -1, 16));
+    parameters.add(blockSize.set("block size", 128, 32, 1024));
+    parameters.add(gain.set("gain", 1.0, 0.0, 8.0));
+    parameters.add(level.set("level", 0.0, 0.0, 1.0));
+    enabled.addListener(this, &LiveAudioInput::setEnabled);
+    deviceId.addListener(this, &LiveAudioInput::setDeviceId);
+    blockSize.addListener(this, &LiveAudioInput::setBlockSize);
+    gain.addListener(this, &LiveAudioInput::setGain);
+}
+
+//--------------------------------------------------------------
+LiveAudioInput::~LiveAudioInput() {
+    close();
+}
+
+//--------------------------------------------------------------
+bool LiveAudioInput::open() {
+    close();
+
+    bufferSize = ofNextPow2(blockSize.get());
+    // the callback mixes down in chunks of this, whatever block it gets
+    mono.assign(max(bufferSize, 1024), 0);
+    overruns = 0;
+
+    if (deviceId.get() >= 0)
+        stream.setDeviceID(deviceId.get());
+    stream.setInput(this);
+    opened = stream.setup(0, 1, sampleRate, bufferSize, 2);
+    if (!opened) {
+        ofLogError("LiveAudioInput") << "could not open input device " << deviceId.get();
+        return false;
+    }
+    ofLogNotice("LiveAudioInput") << "input open, " << sampleRate << " Hz, " << bufferSize << " sample blocks";
+    return true;
+}
+
+//--------------------------------------------------------------
+void LiveAudioInput::close() {
+    if (!opened)
+        return;
+    stream.stop();
+    stream.close();
+    opened = false;
+}
+
+//--------------------------------------------------------------
+void LiveAudioInput::update() {
+    float p = peak.exchange(0.0f);
+    level.set(max(p, level.get() * 0.9f));
+}
+
+//--------------------------------------------------------------
+uint64_t LiveAudioInput::getCaptureMicros() const {
+    uint32_t sequence;
+    uint64_t samples, micros;
+    do {
+        sequence = stampSequence.load(std::memory_order_acquire);
+        samples = stampSamples.load(std::memory_order_relaxed);
+        micros = stampMicros.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) || sequence != stampSequence.load(std::memory_order_acquire));
+
+    // the last sample of the stamped block arrived at the stamp
+    int64_t behind = (int64_t)samples - (int64_t)consumed;
+    return micros - behind * 1000000 / sampleRate;
+}
+
+//--------------------------------------------------------------
+void LiveAudioInput::audioIn(ofSoundBuffer& _buffer) {
+    uint64_t now = ofGetElapsedTimeMicros();
+    int channels = _buffer.getNumChannels();
+    int frames = _buffer.getNumFrames();
+    const float* src = _buffer.getBuffer();
+    float g = callbackGain.load() / channels;
+    float blockPeak = 0;
+
+    for (int start=0; start<frames; start+=mono.size()) {
+        int count = min((int)mono.size(), frames - start);
+        for (int i=0; i<count; i++) {
+            float sum = 0;
+            for (int c=0; c<channels; c++)
+                sum += src[(start + i) * channels + c];
+            mono[i] = sum * g;
+            blockPeak = max(blockPeak, fabsf(mono[i]));
+        }
+        size_t n = ring.write(mono.data(), count);
+        written += n;
+        if ((int)n < count)
+            overruns += count - n;
+    }
+
+    stampSequence.fetch_add(1, std::memory_order_acq_rel);
+    stampSamples.store(written, std::memory_order_relaxed);
+    stampMicros.store(now, std::memory_order_relaxed);
+    stampSequence.fetch_add(1, std::memory_order_release);
+
+    if (blockPeak > peak.load())
+        peak.store(blockPeak);
+}
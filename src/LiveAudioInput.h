@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ofMain.h"
+#include "SpscRing.h"
+
+// Live input from the sound card for analysis. The audio callback mixes each
+// block down to mono, applies the gain and copies it into a lock free ring;
+// it never locks or allocates. The analysis thread reads the ring from the
+// other end (the consumer methods below) and can tell when the samples it
+// reads were captured, to measure input to feature latency.
+
+class LiveAudioInput : public ofBaseSoundInput {
+public:
+    LiveAudioInput();
+    ~LiveAudioInput();
+
+    bool	open();
+    void	close();
+    bool	isOpen() const			{ return opened; }
+
+    // render thread, publishes the level meter
+    void	update();
+
+    ofParameterGroup	parameters;
+
+    int		getSampleRate() const	{ return sampleRate; }
+    int		getBufferSize() const	{ return bufferSize; }
+    uint64_t	getNumOverruns() const	{ return overruns.load(); }
+
+    // consumer side, one thread only
+    size_t	getNumAvailable() const			{ return ring.size(); }
+    size_t	read(float* _dst, size_t _count)	{ size_t n = ring.read(_dst, _count); consumed += n; return n; }
+    size_t	discard(size_t _count)				{ size_t n = ring.discard(_count); consumed += n; return n; }
+    void	clear()								{ discard(ring.size()); }
+    // ofGetElapsedTimeMicros() at which the last sample read was captured
+    uint64_t	getCaptureMicros() const;
+
+    // audio thread
+    void	audioIn(ofSoundBuffer& _buffer);
+
+protected:
+    ofSoundStream		stream;
+    bool				opened;
+    int					sampleRate;
+    int					bufferSize;
+
+    ofParameter<bool>	enabled;
+    void				setEnabled(bool& _value)	{ if (_value) open(); else close(); }
+    ofParameter<int>	deviceId;
+    void				setDeviceId(int& _value)	{ if (opened) open(); }
+    ofParameter<int>	blockSize;
+    void				setBlockSize(int& _value)	{ if (opened) open(); }
+    ofParameter<float>	gain;
+    void				setGain(float& _value)		{ callbackGain.store(_value); }
+    ofParameter<float>	level;
+
+    SpscRing<float>			ring;
+    vector<float>			mono;			// callback scratch, allocated in open()
+    std::atomic<float>		callbackGain;
+    std::atomic<float>		peak;
+    std::atomic<uint64_t>	overruns;
+
+    // capture clock, a seqlock so the callback never waits: the sequence is
+    // odd while the stamp is being written
+    std::atomic<uint32_t>	stampSequence;
+    std::atomic<uint64_t>	stampSamples;	// samples written when the last block arrived
+    std::atomic<uint64_t>	stampMicros;
+    uint64_t				written;		// audio thread
+    uint64_t				consumed;		// consumer thread
+};
@@ -0,0 +1,186 @@
+#include "ModulationMatrix.h"
+
+//--------------------------------------------------------------
+ModulationMatrix::ModulationMatrix() {
+    numRoutes = 0;
+    for (int r=0; r<maxRoutes; r++)
+        routeNamedTarget[r] = -1;
+}
+
+//--------------------------------------------------------------
+void ModulationMatrix::setup(int _numRoutes) {
+    numRoutes = ofClamp(_numRoutes, 1, maxRoutes);
+
+    parameters.setName("modulation");
+    for (int r=0; r<numRoutes; r++) {
+        routeParameters[r].setName("route " + ofToString(r + 1));
+        routeParameters[r].add(routeSource[r].set("source", 0, 0, max(0, getNumSources() - 1)));
+        routeParameters[r].add(routeSourceName[r].set("source name", ""));
+        routeParameters[r].add(routeTarget[r].set("target", -1, -1, max(-1, getNumTargets() - 1)));
+        routeParameters[r].add(routeTargetName[r].set("target name", "off"));
+        routeTarget[r].setSerializable(false);
+        routeNamedTarget[r] = -1;
+        routeParameters[r].add(routeDepth[r].set("depth", 0.25, -1.0, 1.0));
+        routeParameters[r].add(routeCurve[r].set("curve", 1.0, 0.25, 4.0));
+        routeParameters[r].add(routeSmoothing[r].set("smoothing", 0.1, 0.0, 2.0));
+        parameters.add(routeParameters[r]);
+    }
+
+    source.assign(numRoutes, 0);
+    target.assign(numRoutes, -1);
+    depth.assign(numRoutes, 0);
+    curve.assign(numRoutes, 1);
+    coefficient.assign(numRoutes, 1);
+    state.assign(numRoutes, 0);
+    refreshNames();
+}
+
+//--------------------------------------------------------------
+int ModulationMatrix::addSource(const string& _name, bool _normalize) {
+    sourceNames.push_back(_name);
+    sourceValues.push_back(0);
+    sourceLevels.push_back(0);
+    sourcePeaks.push_back(0);
+    sourceNormalized.push_back(_normalize);
+    for (int r=0; r<numRoutes; r++)
+        routeSource[r].setMax(getNumSources() - 1);
+    return getNumSources() - 1;
+}
+
+//--------------------------------------------------------------
+void ModulationMatrix::addTarget(ofParameter<float>& _parameter, const string& _prefix) {
+    Target t;
+    t.isInt = false;
+    t.floatParameter = _parameter;
+    t.name = _prefix.empty() ? _parameter.getName() : _prefix + " " + _parameter.getName();
+    t.base = t.written = _parameter.get();
+    targets.push_back(t);
+    targetOffsets.push_back(0);
+    for (int r=0; r<numRoutes; r++)
+        routeTarget[r].setMax(getNumTargets() - 1);
+}
+
+//--------------------------------------------------------------
+void ModulationMatrix::addTarget(ofParameter<int>& _parameter, const string& _prefix) {
+    Target t;
+    t.isInt = true;
+    t.intParameter = _parameter;
+    t.name = _prefix.empty() ? _parameter.getName() : _prefix + " " + _parameter.getName();
+    t.base = t.written = _parameter.get();
+    targets.push_back(t);
+    targetOffsets.push_back(0);
+    for (int r=0; r<numRoutes; r++)
+        routeTarget[r].setMax(getNumTargets() - 1);
+}
+
+//--------------------------------------------------------------
+void ModulationMatrix::refreshNames() {
+    for (int r=0; r<numRoutes; r++) {
+        int s = routeSource[r].get();
+        string sourceName = s >= 0 && s < getNumSources() ? sourceNames[s] : "none";
+        if (routeSourceName[r].get() != sourceName)
+            routeSourceName[r].set(sourceName);
+
+        // the slider moved, or the name did: loaded from the settings
+        int t = routeTarget[r].get();
+        if (t == routeNamedTarget[r] && routeTargetName[r].get() != (t >= 0 && t < getNumTargets() ? targets[t].name : "off")) {
+            t = findTarget(routeTargetName[r].get());
+            routeTarget[r].set(t);
+        }
+        string targetName = t >= 0 && t < getNumTargets() ? targets[t].name : "off";
+        if (routeTargetName[r].get() != targetName)
+            routeTargetName[r].set(targetName);
+        routeNamedTarget[r] = t;
+    }
+}
+
+//--------------------------------------------------------------
+int ModulationMatrix::findTarget(const string& _name) const {
+    for (int t=0; t<getNumTargets(); t++)
+        if (targets[t].name == _name)
+            return t;
+    return -1;
+}
+
+//--------------------------------------------------------------
+void ModulationMatrix::setTargetValue(Target& _target, float _value) {
+    if (_target.isInt)
+        _target.intParameter.set(_value);
+    else
+        _target.floatParameter.set(_value);
+    _target.written = _value;
+}
+
+//--------------------------------------------------------------
+void ModulationMatrix::restoreBases() {
+    for (int t=0; t<getNumTargets(); t++) {
+        Target& destination = targets[t];
+        float current = getTargetValue(destination);
+        if (current != destination.written)
+            destination.base = current;
+        else if (current != destination.base)
+            setTargetValue(destination, destination.base);
+    }
+}
+
+//--------------------------------------------------------------
+void ModulationMatrix::update(float _dt) {
+    refreshNames();
+    int numSources = getNumSources();
+    int numTargets = getNumTargets();
+    if (numSources == 0)
+        return;
+
+    // sources without a fixed range follow a peak that falls over ten seconds
+    float peakDecay = expf(-_dt / 10.0f);
+    for (int s=0; s<numSources; s++) {
+        if (sourceNormalized[s]) {
+            sourcePeaks[s] = max(sourceValues[s], sourcePeaks[s] * peakDecay);
+            sourceLevels[s] = sourcePeaks[s] > 1e-6f ? sourceValues[s] / sourcePeaks[s] : 0.0f;
+        }
+        else {
+            sourceLevels[s] = ofClamp(sourceValues[s], 0, 1);
+        }
+    }
+
+    // gather the route settings into the flat arrays
+    for (int r=0; r<numRoutes; r++) {
+        int s = routeSource[r].get();
+        int t = routeTarget[r].get();
+        bool active = s >= 0 && s < numSources && t >= 0 && t < numTargets;
+        source[r] = active ? s : 0;
+        target[r] = active ? t : -1;
+        depth[r] = active ? routeDepth[r].get() : 0.0f;
+        curve[r] = routeCurve[r].get();
+        float smoothing = routeSmoothing[r].get();
+        coefficient[r] = smoothing > 0 ? 1.0f - expf(-_dt / smoothing) : 1.0f;
+    }
+
+    // curve, smooth and scale every route, summed per target
+    std::fill(targetOffsets.begin(), targetOffsets.end(), 0.0f);
+    for (int r=0; r<numRoutes; r++) {
+        float x = sourceLevels[source[r]];
+        float y = curve[r] == 1.0f ? x : powf(x, curve[r]);
+        state[r] += (y - state[r]) * coefficient[r];
+        if (target[r] >= 0)
+            targetOffsets[target[r]] += state[r] * depth[r];
+    }
+
+    // one write per target that actually moved; a value nobody wrote here
+    // came from the gui or the settings and becomes the new base
+    for (int t=0; t<numTargets; t++) {
+        Target& destination = targets[t];
+        float current = getTargetValue(destination);
+        if (current != destination.written)
+            destination.base = current;
+
+        float low = destination.isInt ? destination.intParameter.getMin() : destination.floatParameter.getMin();
+        float high = destination.isInt ? destination.intParameter.getMax() : destination.floatParameter.getMax();
+        float value = ofClamp(destination.base + targetOffsets[t] * (high - low), low, high);
+        if (destination.isInt)
+            value = roundf(value);
+        if (value != current)
+            setTargetValue(destination, value);
+        destination.written = value;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Routes audio features to any registered float or int ofParameter.
+// Sources are plain 0..1 values set every frame (set them, then update());
+// targets are parameters registered once. Each route slot picks a source and
+// a target in the gui and has its own depth, response curve and smoothing.
+// update() evaluates all routes in one pass over flat arrays, sums them per
+// target and writes each target at most once, only when its value changed,
+// so a target's listeners fire at most once a frame. The modulation is an
+// offset on the target's own value: moving the slider by hand moves the
+// center the route swings around, and restoreBases() puts the centers back
+// for the settings to be saved without the swing. A route keeps its target
+// by name in the settings, the index is only the slider that picks it, so
+// adding a target never moves a saved route onto another one.
+
+class ModulationMatrix {
+public:
+    static const int	maxRoutes = 16;
+
+    ModulationMatrix();
+
+    void	setup(int _numRoutes = 8);
+
+    // _normalize scales the source by its own recent peak, for features
+    // like band energies that have no fixed range
+    int		addSource(const string& _name, bool _normalize = false);
+    void	setSourceName(int _source, const string& _name)	{ sourceNames[_source] = _name; }
+    void	setSource(int _source, float _value)				{ sourceValues[_source] = _value; }
+    int		getNumSources() const								{ return sourceValues.size(); }
+
+    void	addTarget(ofParameter<float>& _parameter, const string& _prefix = "");
+    void	addTarget(ofParameter<int>& _parameter, const string& _prefix = "");
+    int		getNumTargets() const								{ return targets.size(); }
+
+    void	update(float _dt);
+    // every target back on its own value until the next update()
+    void	restoreBases();
+
+    ofParameterGroup	parameters;
+
+private:
+    // copies of an ofParameter share its value
+    struct Target {
+        bool				isInt;
+        ofParameter<float>	floatParameter;
+        ofParameter<int>	intParameter;
+        string				name;
+        float				base;		// the value set by hand or from settings
+        float				written;	// what update() last wrote
+    };
+
+    float	getTargetValue(const Target& _target) const	{ return _target.isInt ? _target.intParameter.get() : _target.floatParameter.get(); }
+    void	setTargetValue(Target& _target, float _value);
+    int		findTarget(const string& _name) const;
+    void	refreshNames();
+
+    // sources
+    vector<string>		sourceNames;
+    vector<float>		sourceValues;
+    vector<float>		sourceLevels;		// 0..1, what the routes read
+    vector<float>		sourcePeaks;
+    vector<bool>		sourceNormalized;
+
+    vector<Target>		targets;
+    vector<float>		targetOffsets;
+
+    // one gui group per route
+    int					numRoutes;
+    ofParameterGroup	routeParameters[maxRoutes];
+    ofParameter<int>	routeSource[maxRoutes];
+    ofParameter<string>	routeSourceName[maxRoutes];
+    ofParameter<int>	routeTarget[maxRoutes];
+    ofParameter<string>	routeTargetName[maxRoutes];	// what the settings keep
+    int					routeNamedTarget[maxRoutes];	// the index the name was last taken from
+    ofParameter<float>	routeDepth[maxRoutes];
+    ofParameter<float>	routeCurve[maxRoutes];
+    ofParameter<float>	routeSmoothing[maxRoutes];
+
+    // the routes as flat arrays for the per frame pass
+    vector<int>			source;
+    vector<int>			target;
+    vector<float>		depth;
+    vector<float>		curve;
+    vector<float>		coefficient;
+    vector<float>		state;
+};
@@ -0,0 +1,89 @@
+#include "OnsetDetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+//--------------------------------------------------------------
+OnsetDetector::OnsetDetector() {
+    compression = 100;
+    sensitivity = 1.5;
+    floor = 0.002;
+    minInterval = 0.05;
+
+    numBins = 0;
+    hopDuration = 0;
+    peakDecay = 1;
+    reset();
+}
+
+//--------------------------------------------------------------
+void OnsetDetector::setup(int _numBins, float _hopDuration) {
+    numBins = _numBins;
+    hopDuration = _hopDuration;
+
+    previousLog.assign(numBins, 0);
+    // the threshold follows roughly the last half second
+    int historySize = std::max(8, (int)(0.5f / hopDuration));
+    history.assign(historySize, 0);
+    sorted.assign(historySize, 0);
+    // and strength is relative to the peak of the last few seconds
+    peakDecay = expf(-hopDuration / 5.0f);
+    reset();
+}
+
+//--------------------------------------------------------------
+void OnsetDetector::reset() {
+    std::fill(previousLog.begin(), previousLog.end(), 0.0f);
+    std::fill(history.begin(), history.end(), 0.0f);
+    historyIndex = 0;
+    historyCount = 0;
+    novelty = 0;
+    previousNovelty = 0;
+    previousThreshold = 0;
+    threshold = 0;
+    strength = 0;
+    peak = 0;
+    hopsSinceOnset = 1 << 20;
+}
+
+//--------------------------------------------------------------
+bool OnsetDetector::process(const float* _amplitudes) {
+    float beforeNovelty = previousNovelty;
+    previousNovelty = novelty;
+    previousThreshold = threshold;
+
+    float flux = 0;
+    for (int i=0; i<numBins; i++) {
+        float l = logf(1.0f + compression * _amplitudes[i]);
+        float rise = l - previousLog[i];
+        flux += rise > 0 ? rise : 0;
+        previousLog[i] = l;
+    }
+    novelty = flux / numBins;
+
+    history[historyIndex] = novelty;
+    historyIndex = (historyIndex + 1) % history.size();
+    historyCount = std::min(historyCount + 1, (int)history.size());
+
+    std::copy(history.begin(), history.begin() + historyCount, sorted.begin());
+    std::nth_element(sorted.begin(), sorted.begin() + historyCount / 2, sorted.begin() + historyCount);
+    threshold = std::max(floor, sensitivity * sorted[historyCount / 2]);
+
+    // the previous hop is an onset when it is a local maximum above its threshold
+    hopsSinceOnset++;
+    bool onset = previousNovelty > previousThreshold &&
+                 previousNovelty > beforeNovelty &&
+                 previousNovelty >= novelty &&
+                 hopsSinceOnset * hopDuration >= minInterval;
+
+    peak = std::max(peak * peakDecay, previousNovelty);
+    if (onset) {
+        hopsSinceOnset = 1;
+        float range = peak - previousThreshold;
+        strength = range > 0 ? std::min(1.0f, (previousNovelty - previousThreshold) / range) : 1.0f;
+    }
+    else {
+        strength = 0;
+    }
+    return onset;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+// Streaming onset detection on an amplitude spectrum, one call per hop.
+// The novelty curve is the half wave rectified spectral flux of the log
+// compressed spectrum; an onset is a local peak of it above an adaptive
+// threshold (a multiple of the recent median plus a floor). Peaks are picked
+// one hop late, so every onset is reported with one hop of delay.
+// No allocation after setup(), no openFrameworks dependency (see bench/).
+
+class OnsetDetector {
+public:
+    OnsetDetector();
+
+    void	setup(int _numBins, float _hopDuration);
+    void	reset();
+
+    // returns true when the previous hop was an onset
+    bool	process(const float* _amplitudes);
+
+    float	getNovelty() const			{ return novelty; }		// spectral flux of the last hop
+    float	getThreshold() const		{ return threshold; }
+    float	getOnsetStrength() const	{ return strength; }	// 0..1, how far the last onset rose over the threshold
+
+    float	compression;		// log(1 + compression * amplitude)
+    float	sensitivity;		// threshold multiple of the median novelty
+    float	floor;				// threshold never drops below this
+    float	minInterval;		// seconds between two onsets
+
+private:
+    int					numBins;
+    float				hopDuration;
+    std::vector<float>	previousLog;
+    std::vector<float>	history;		// recent novelty, ring
+    std::vector<float>	sorted;			// scratch for the median
+    int					historyIndex;
+    int					historyCount;
+
+    float				novelty;
+    float				previousNovelty;
+    float				previousThreshold;
+    float				threshold;
+    float				strength;
+    float				peak;
+    float				peakDecay;
+    int					hopsSinceOnset;
+};
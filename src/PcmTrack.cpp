@@ -0,0 +1,441 @@
+#include "PcmTrack.h"
+
+#include <sys/stat.h>
+#ifndef TARGET_WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef OF_SOUND_PLAYER_FMOD
+#include "fmod.h"
+#endif
+
+#ifdef OF_SOUND_PLAYER_OPENAL
+#include <sndfile.h>
+#ifdef OF_USING_MPG123
+#include <mpg123.h>
+#endif
+#endif
+
+namespace {
+    const char		magic[4] = { 'G', 'R', 'V', 'P' };
+    const uint32_t	version = 1;
+
+    // file layout: header, then numFrames * numChannels floats
+    struct PcmCacheHeader {
+        char		magic[4];
+        uint32_t	version;
+        uint64_t	sourceHash;
+        uint64_t	sourceBytes;
+        int32_t		sampleRate;
+        int32_t		numChannels;
+        int64_t		numFrames;
+    };
+
+    // 64 bit FNV-1a over the whole file, a few ms for a song against the
+    // seconds it takes to decode it
+    bool hashFile(const string& _path, uint64_t& _hash, uint64_t& _bytes) {
+        FILE* file = fopen(_path.c_str(), "rb");
+        if (file == NULL)
+            return false;
+        _hash = 0xcbf29ce484222325ULL;
+        _bytes = 0;
+        vector<unsigned char> chunk(1 << 20);
+        size_t count;
+        while ((count = fread(chunk.data(), 1, chunk.size(), file)) > 0) {
+            for (size_t i=0; i<count; i++) {
+                _hash ^= chunk[i];
+                _hash *= 0x100000001b3ULL;
+            }
+            _bytes += count;
+        }
+        fclose(file);
+        return true;
+    }
+}
+
+#ifdef OF_SOUND_PLAYER_FMOD
+struct PcmDecoder {
+    FMOD_SYSTEM*			system;
+    FMOD_SOUND*				sound;
+    FMOD_SOUND_FORMAT		format;
+    int						bytesPerSample;
+    vector<unsigned char>	chunk;
+};
+#endif
+
+#ifdef OF_SOUND_PLAYER_OPENAL
+struct PcmDecoder {
+#ifdef OF_USING_MPG123
+    mpg123_handle*	mp3;
+#endif
+    SNDFILE*		file;
+};
+#endif
+
+#if !defined(OF_SOUND_PLAYER_FMOD) && !defined(OF_SOUND_PLAYER_OPENAL)
+struct PcmDecoder {
+};
+#endif
+
+//--------------------------------------------------------------
+PcmTrack::PcmTrack() {
+    sourceHash = 0;
+    sourceBytes = 0;
+    sampleRate = 0;
+    numChannels = 0;
+    numFrames = 0;
+    decodedFrames = 0;
+    decoded = false;
+    data = NULL;
+    mapped = NULL;
+    mappedSize = 0;
+    decoder = NULL;
+}
+
+//--------------------------------------------------------------
+PcmTrack::~PcmTrack() {
+    close();
+}
+
+//--------------------------------------------------------------
+void PcmTrack::close() {
+    if (isThreadRunning())
+        waitForThread(true);
+    closeDecoder();
+#ifndef TARGET_WIN32
+    if (mapped != NULL)
+        munmap((void*)mapped, mappedSize);
+#endif
+    fallbackBuffer = ofBuffer();
+    mapped = NULL;
+    mappedSize = 0;
+    data = NULL;
+    samples.clear();
+    path.clear();
+    sampleRate = 0;
+    numChannels = 0;
+    numFrames = 0;
+    decodedFrames = 0;
+    decoded = false;
+}
+
+//--------------------------------------------------------------
+bool PcmTrack::load(string _path) {
+    close();
+
+    path = ofToDataPath(_path, true);
+    if (!hashFile(path, sourceHash, sourceBytes)) {
+        ofLogError("PcmTrack") << "could not read " << _path;
+        path.clear();
+        return false;
+    }
+    if (openCache(sourceHash, sourceBytes)) {
+        ofLogNotice("PcmTrack") << "mapped " << getCachePath() << ": " << getNumFrames() << " frames, " << numChannels << " channels, " << sampleRate << " Hz";
+        return true;
+    }
+
+    if (!openDecoder(path) || numChannels <= 0 || numFrames <= 0) {
+        ofLogError("PcmTrack") << "could not decode " << _path;
+        closeDecoder();
+        path.clear();
+        numFrames = 0;
+        return false;
+    }
+    samples.assign((size_t)getNumFrames() * numChannels, 0.0f);
+    data = samples.data();
+    ofLogNotice("PcmTrack") << "decoding " << _path << ": " << getNumFrames() << " frames, " << numChannels << " channels, " << sampleRate << " Hz";
+    startThread();
+    return true;
+}
+
+//--------------------------------------------------------------
+void PcmTrack::threadedFunction() {
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+    int64_t capacity = getNumFrames();
+    int64_t frames = 0;
+    while (isThreadRunning() && frames < capacity) {
+        int64_t count = readDecoder(samples.data() + frames * numChannels, min<int64_t>(16384, capacity - frames));
+        if (count <= 0)
+            break;
+        frames += count;
+        decodedFrames.store(frames, std::memory_order_release);
+    }
+    closeDecoder();
+    if (!isThreadRunning())
+        return;
+
+    // the length up front can be an estimate
+    numFrames = frames;
+    decoded.store(true, std::memory_order_release);
+    ofLogNotice("PcmTrack") << "decoded " << path << " in " << (ofGetElapsedTimeMicros() - startMicros) / 1000 << " ms";
+    writeCache();
+}
+
+//--------------------------------------------------------------
+bool PcmTrack::openCache(uint64_t _sourceHash, uint64_t _sourceBytes) {
+    string cachePath = getCachePath();
+    if (!ofFile::doesFileExist(cachePath, false))
+        return false;
+
+    const char* file = NULL;
+    size_t fileSize = 0;
+#ifndef TARGET_WIN32
+    int fd = ::open(cachePath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(PcmCacheHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* region = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (region == MAP_FAILED)
+        return false;
+    file = (const char*)region;
+    fileSize = info.st_size;
+#else
+    fallbackBuffer = ofBufferFromFile(cachePath, true);
+    file = fallbackBuffer.getData();
+    fileSize = fallbackBuffer.size();
+#endif
+
+    PcmCacheHeader header;
+    bool valid = fileSize >= sizeof(header);
+    if (valid)
+        memcpy(&header, file, sizeof(header));
+    valid = valid &&
+        memcmp(header.magic, magic, sizeof(magic)) == 0 &&
+        header.version == version &&
+        header.sourceHash == _sourceHash &&
+        header.sourceBytes == _sourceBytes &&
+        header.sampleRate > 0 && header.numChannels > 0 && header.numFrames > 0 &&
+        fileSize == sizeof(header) + (size_t)header.numFrames * header.numChannels * sizeof(float);
+    if (!valid) {
+#ifndef TARGET_WIN32
+        munmap((void*)file, fileSize);
+#endif
+        fallbackBuffer = ofBuffer();
+        ofLogNotice("PcmTrack") << cachePath << " is stale";
+        return false;
+    }
+
+    mapped = file;
+    mappedSize = fileSize;
+    data = (const float*)(file + sizeof(header));
+    sampleRate = header.sampleRate;
+    numChannels = header.numChannels;
+    numFrames = header.numFrames;
+    decodedFrames = header.numFrames;
+    decoded = true;
+    return true;
+}
+
+//--------------------------------------------------------------
+bool PcmTrack::writeCache() {
+    PcmCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.sourceHash = sourceHash;
+    header.sourceBytes = sourceBytes;
+    header.sampleRate = sampleRate;
+    header.numChannels = numChannels;
+    header.numFrames = getNumFrames();
+
+    // write next to it and rename, a reader never sees half a file
+    string cachePath = getCachePath();
+    string temporaryPath = cachePath + ".tmp";
+    FILE* file = fopen(temporaryPath.c_str(), "wb");
+    if (file == NULL) {
+        ofLogError("PcmTrack") << "could not write " << temporaryPath;
+        return false;
+    }
+    size_t count = (size_t)header.numFrames * numChannels;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(samples.data(), sizeof(float), count, file) == count;
+    written = fclose(file) == 0 && written;
+    if (!written || !ofFile::moveFromTo(temporaryPath, cachePath, false, true)) {
+        ofLogError("PcmTrack") << "could not write " << cachePath;
+        ofFile::removeFile(temporaryPath, false);
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+void PcmTrack::readMono(int64_t _frame, int _count, float* _dst) const {
+    float scale = 1.0f / max(numChannels, 1);
+    int64_t available = getNumDecodedFrames();
+    for (int i=0; i<_count; i++) {
+        int64_t frame = _frame + i;
+        if (frame < 0 || frame >= available) {
+            _dst[i] = 0.0f;
+            continue;
+        }
+        const float* src = data + frame * numChannels;
+        float sum = 0;
+        for (int c=0; c<numChannels; c++)
+            sum += src[c];
+        _dst[i] = sum * scale;
+    }
+}
+
+#ifdef OF_SOUND_PLAYER_FMOD
+//--------------------------------------------------------------
+bool PcmTrack::openDecoder(const string& _path) {
+    // a private non-realtime system, so decoding never touches the system
+    // ofFmodSoundPlayer is mixing on
+    decoder = new PcmDecoder();
+    decoder->system = NULL;
+    decoder->sound = NULL;
+    if (FMOD_System_Create(&decoder->system) != FMOD_OK)
+        return false;
+    FMOD_System_SetOutput(decoder->system, FMOD_OUTPUTTYPE_NOSOUND_NRT);
+    if (FMOD_System_Init(decoder->system, 1, FMOD_INIT_NORMAL, NULL) != FMOD_OK)
+        return false;
+    if (FMOD_System_CreateSound(decoder->system, _path.c_str(), FMOD_OPENONLY | FMOD_ACCURATETIME, NULL, &decoder->sound) != FMOD_OK)
+        return false;
+
+    int bits = 0;
+    float frequency = 0;
+    unsigned int length = 0;
+    FMOD_Sound_GetFormat(decoder->sound, NULL, &decoder->format, &numChannels, &bits);
+    FMOD_Sound_GetDefaults(decoder->sound, &frequency, NULL, NULL, NULL);
+    FMOD_Sound_GetLength(decoder->sound, &length, FMOD_TIMEUNIT_PCM);
+    sampleRate = (int)frequency;
+    numFrames = length;
+    decoder->bytesPerSample = bits / 8;
+    return decoder->bytesPerSample > 0 && numChannels > 0;
+}
+
+//--------------------------------------------------------------
+int64_t PcmTrack::readDecoder(float* _dst, int64_t _numFrames) {
+    int bytesPerSample = decoder->bytesPerSample;
+    decoder->chunk.resize(_numFrames * numChannels * bytesPerSample);
+    unsigned int bytesRead = 0;
+    FMOD_Sound_ReadData(decoder->sound, decoder->chunk.data(), decoder->chunk.size(), &bytesRead);
+    int count = bytesRead / bytesPerSample / numChannels * numChannels;
+    for (int i=0; i<count; i++) {
+        const unsigned char* s = &decoder->chunk[i * bytesPerSample];
+        switch (decoder->format) {
+            case FMOD_SOUND_FORMAT_PCM8:		_dst[i] = ((signed char)s[0]) / 128.0f; break;
+            case FMOD_SOUND_FORMAT_PCM16:		_dst[i] = *(const short*)s / 32768.0f; break;
+            case FMOD_SOUND_FORMAT_PCM24:		_dst[i] = (int)((s[0] << 8) | (s[1] << 16) | (s[2] << 24)) / 2147483648.0f; break;
+            case FMOD_SOUND_FORMAT_PCM32:		_dst[i] = *(const int*)s / 2147483648.0f; break;
+            case FMOD_SOUND_FORMAT_PCMFLOAT:	_dst[i] = *(const float*)s; break;
+            default: return 0;
+        }
+    }
+    return count / numChannels;
+}
+
+//--------------------------------------------------------------
+void PcmTrack::closeDecoder() {
+    if (decoder == NULL)
+        return;
+    if (decoder->sound != NULL)
+        FMOD_Sound_Release(decoder->sound);
+    if (decoder->system != NULL) {
+        FMOD_System_Close(decoder->system);
+        FMOD_System_Release(decoder->system);
+    }
+    delete decoder;
+    decoder = NULL;
+}
+#endif
+
+#ifdef OF_SOUND_PLAYER_OPENAL
+//--------------------------------------------------------------
+bool PcmTrack::openDecoder(const string& _path) {
+    decoder = new PcmDecoder();
+    decoder->file = NULL;
+#ifdef OF_USING_MPG123
+    decoder->mp3 = NULL;
+    if (ofToLower(ofFilePath::getFileExt(_path)) == "mp3") {
+        int err = MPG123_OK;
+        mpg123_init();
+        decoder->mp3 = mpg123_new(NULL, &err);
+        if (decoder->mp3 == NULL)
+            return false;
+        if (mpg123_open(decoder->mp3, _path.c_str()) != MPG123_OK)
+            return false;
+        long rate;
+        int channels, encoding;
+        mpg123_getformat(decoder->mp3, &rate, &channels, &encoding);
+        mpg123_format_none(decoder->mp3);
+        mpg123_format(decoder->mp3, rate, channels, MPG123_ENC_FLOAT_32);
+        // walks the frame headers for an exact length, far quicker than decoding
+        mpg123_scan(decoder->mp3);
+        sampleRate = rate;
+        numChannels = channels;
+        numFrames = mpg123_length(decoder->mp3);
+        return true;
+    }
+#endif
+    SF_INFO info;
+    info.format = 0;
+    decoder->file = sf_open(_path.c_str(), SFM_READ, &info);
+    if (decoder->file == NULL)
+        return false;
+    sampleRate = info.samplerate;
+    numChannels = info.channels;
+    numFrames = info.frames;
+    return true;
+}
+
+//--------------------------------------------------------------
+int64_t PcmTrack::readDecoder(float* _dst, int64_t _numFrames) {
+#ifdef OF_USING_MPG123
+    if (decoder->mp3 != NULL) {
+        int64_t frames = 0;
+        while (frames < _numFrames) {
+            size_t done = 0;
+            int err = mpg123_read(decoder->mp3, (unsigned char*)(_dst + frames * numChannels), (_numFrames - frames) * numChannels * sizeof(float), &done);
+            frames += done / sizeof(float) / numChannels;
+            if (err == MPG123_NEW_FORMAT)
+                continue;
+            if (err != MPG123_OK)
+                break;
+        }
+        return frames;
+    }
+#endif
+    return sf_readf_float(decoder->file, _dst, _numFrames);
+}
+
+//--------------------------------------------------------------
+void PcmTrack::closeDecoder() {
+    if (decoder == NULL)
+        return;
+#ifdef OF_USING_MPG123
+    if (decoder->mp3 != NULL) {
+        mpg123_close(decoder->mp3);
+        mpg123_delete(decoder->mp3);
+    }
+#endif
+    if (decoder->file != NULL)
+        sf_close(decoder->file);
+    delete decoder;
+    decoder = NULL;
+}
+#endif
+
+#if !defined(OF_SOUND_PLAYER_FMOD) && !defined(OF_SOUND_PLAYER_OPENAL)
+//--------------------------------------------------------------
+bool PcmTrack::openDecoder(const string& _path) {
+    ofLogError("PcmTrack") << "no decoder available on this platform";
+    return false;
+}
+
+//--------------------------------------------------------------
+int64_t PcmTrack::readDecoder(float* _dst, int64_t _numFrames) {
+    return 0;
+}
+
+//--------------------------------------------------------------
+void PcmTrack::closeDecoder() {
+}
+#endif
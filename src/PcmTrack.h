@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ofMain.h"
+
+struct PcmDecoder;
+
+// A sound file decoded into interleaved float PCM.
+// ofSoundPlayer keeps its decoded data to itself, so anything that needs to
+// look at the actual samples (analysis, our own playback) decodes the file
+// again through here, using the same codec libraries the player is built on.
+// The decoded samples are cached in <file>.pcm next to it, keyed on a hash of
+// the file's contents: load() maps that cache and returns when it is there,
+// otherwise it only reads the format and decodes on a background thread.
+// The track is playable as soon as load() returns, frames become readable as
+// getNumDecodedFrames() grows, and isDecoded() says when all of it is in.
+// Call load() before handing the track to another thread.
+
+class PcmTrack : public ofThread {
+public:
+    PcmTrack();
+    ~PcmTrack();
+
+    bool	load(string _path);
+    void	close();
+    bool	isLoaded() const		{ return data != NULL; }
+    bool	isDecoded() const		{ return decoded.load(std::memory_order_acquire); }
+    bool	isCached() const		{ return mapped != NULL; }
+
+    int		getSampleRate() const	{ return sampleRate; }
+    int		getNumChannels() const	{ return numChannels; }
+    int64_t	getNumFrames() const	{ return numFrames.load(); }
+    int64_t	getNumDecodedFrames() const	{ return decodedFrames.load(std::memory_order_acquire); }
+    double	getDuration() const		{ return sampleRate > 0 ? (double)getNumFrames() / sampleRate : 0.0; }
+    const string&	getPath() const	{ return path; }	// absolute path of the decoded file
+
+    // the first getNumDecodedFrames() frames are valid
+    const float*	getSamples() const	{ return data; }
+
+    // mixes _count frames starting at _frame down to mono, reading past either
+    // end of what is decoded as silence
+    void	readMono(int64_t _frame, int _count, float* _dst) const;
+
+private:
+    void	threadedFunction();
+
+    bool	openCache(uint64_t _sourceHash, uint64_t _sourceBytes);
+    bool	writeCache();
+    string	getCachePath() const	{ return path + ".pcm"; }
+
+    // per sound player backend, in PcmTrack.cpp
+    bool	openDecoder(const string& _path);	// format and length
+    int64_t	readDecoder(float* _dst, int64_t _numFrames);
+    void	closeDecoder();
+
+    string					path;
+    uint64_t				sourceHash;
+    uint64_t				sourceBytes;
+    int						sampleRate;
+    int						numChannels;
+    std::atomic<int64_t>	numFrames;
+    std::atomic<int64_t>	decodedFrames;
+    std::atomic<bool>		decoded;
+
+    const float*		data;			// samples, or the mapped cache
+    vector<float>		samples;		// sized once, before the decoder starts
+    const char*			mapped;
+    size_t				mappedSize;
+    ofBuffer			fallbackBuffer;	// where there is no mmap
+    PcmDecoder*			decoder;
+};
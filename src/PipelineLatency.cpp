@@ -0,0 +1,154 @@
+#include "PipelineLatency.h"
+
+namespace {
+    const char*	stageNames[PipelineLatency::numStages] = {
+        "source", "flow", "mask", "fluid", "particles", "drawn", "shown"
+    };
+
+    // 20 seconds of the Kinect's frames
+    const int	window = 600;
+}
+
+//--------------------------------------------------------------
+PipelineLatency::PipelineLatency() {
+    sequence = 0;
+    capturedMicros = 0;
+    lastReadout = 0;
+    output = NULL;
+    numFences = 0;
+    tracer.setup(numStages, window);
+
+    parameters.setName("latency");
+    parameters.add(log.set("log", false));
+    parameters.add(file.set("file", ""));
+    for (int s=0; s<numStages; s++)
+        parameters.add(readouts[s].set(string(stageNames[s]) + " ms", "-"));
+    log.addListener(this, &PipelineLatency::setLog);
+}
+
+//--------------------------------------------------------------
+PipelineLatency::~PipelineLatency() {
+    stop();
+    for (int f=0; f<numFences; f++)
+        glDeleteSync(fences[f].sync);
+    numFences = 0;
+}
+
+//--------------------------------------------------------------
+void PipelineLatency::setLog(bool& _value) {
+    if (_value == (output != NULL))
+        return;
+    if (_value) {
+        if (!start(ofToDataPath("latency-" + ofGetTimestampString("%Y%m%d-%H%M%S") + ".csv", true)))
+            log.setWithoutEventNotifications(false);
+    }
+    else
+        stop();
+}
+
+//--------------------------------------------------------------
+bool PipelineLatency::start(const string& _path) {
+    stop();
+    output = fopen(_path.c_str(), "w");
+    if (output == NULL) {
+        ofLogError("PipelineLatency") << "could not write " << _path;
+        return false;
+    }
+    fprintf(output, "sequence,captured us");
+    for (int s=0; s<numStages; s++)
+        fprintf(output, ",%s ms", stageNames[s]);
+    fprintf(output, "\n");
+    file.set(ofFilePath::getFileName(_path));
+    return true;
+}
+
+//--------------------------------------------------------------
+void PipelineLatency::stop() {
+    if (output == NULL)
+        return;
+    fclose(output);
+    output = NULL;
+    tracer.updateSpreads();
+    const LatencyTracer::Spread& shown = tracer.getSpread(STAGE_SHOWN);
+    ofLogNotice("PipelineLatency") << "wrote " << file.get() << ", sensor to screen p50 " << shown.p50
+        << " p95 " << shown.p95 << " p99 " << shown.p99 << " ms over the last " << shown.count << " frames";
+}
+
+//--------------------------------------------------------------
+void PipelineLatency::setFrame(const DepthFrame& _frame) {
+    sequence = _frame.sequence;
+    capturedMicros = _frame.capturedMicros;
+    markFrame(STAGE_SOURCE, sequence, capturedMicros);
+}
+
+//--------------------------------------------------------------
+void PipelineLatency::mark(Stage _stage) {
+    markFrame(_stage, sequence, capturedMicros);
+}
+
+//--------------------------------------------------------------
+void PipelineLatency::markFrame(Stage _stage, uint64_t _sequence, uint64_t _capturedMicros) {
+    if (!tracer.mark(_stage, _sequence, _capturedMicros, ofGetElapsedTimeMicros()) || output == NULL)
+        return;
+
+    // the frame is on the screen, its row is complete
+    const LatencyTracer::Row& row = tracer.getRow(_sequence);
+    fprintf(output, "%llu,%llu", (unsigned long long)row.sequence, (unsigned long long)row.capturedMicros);
+    for (int s=0; s<numStages; s++) {
+        if (row.ages[s] >= 0)
+            fprintf(output, ",%.2f", row.ages[s]);
+        else
+            fprintf(output, ",");
+    }
+    fprintf(output, "\n");
+}
+
+//--------------------------------------------------------------
+void PipelineLatency::drawn() {
+    // one fence for each frame's first draw, the later ones show nothing new
+    const LatencyTracer::Row& row = tracer.getRow(sequence);
+    if (sequence == 0 || (row.sequence == sequence && row.ages[STAGE_DRAWN] >= 0))
+        return;
+    mark(STAGE_DRAWN);
+
+    // never wait on the GPU, with the ring full the oldest goes unmeasured
+    if (numFences == maxFences) {
+        glDeleteSync(fences[0].sync);
+        for (int f=1; f<numFences; f++)
+            fences[f - 1] = fences[f];
+        numFences--;
+    }
+    Fence& fence = fences[numFences++];
+    fence.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    fence.sequence = sequence;
+    fence.capturedMicros = capturedMicros;
+}
+
+//--------------------------------------------------------------
+void PipelineLatency::update() {
+    // the draws the GPU is through with, in the order they were fenced
+    int done = 0;
+    while (done < numFences) {
+        GLenum state = glClientWaitSync(fences[done].sync, 0, 0);
+        if (state == GL_TIMEOUT_EXPIRED)
+            break;
+        if (state != GL_WAIT_FAILED)
+            markFrame(STAGE_SHOWN, fences[done].sequence, fences[done].capturedMicros);
+        glDeleteSync(fences[done].sync);
+        done++;
+    }
+    for (int f=done; f<numFences; f++)
+        fences[f - done] = fences[f];
+    numFences -= done;
+
+    float now = ofGetElapsedTimef();
+    if (now - lastReadout < 0.5f)
+        return;
+    lastReadout = now;
+    tracer.updateSpreads();
+    for (int s=0; s<numStages; s++) {
+        const LatencyTracer::Spread& spread = tracer.getSpread(s);
+        if (spread.count > 0)
+            readouts[s].set(ofToString(spread.p50, 1) + " / " + ofToString(spread.p95, 1) + " / " + ofToString(spread.p99, 1));
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ofMain.h"
+#include "LatencyTracer.h"
+#include "DepthSource.h"
+
+// How old the depth is at each step between the sensor and the screen.
+// ofApp hands over every new depth frame as the render thread takes it,
+// and marks each stage as it finishes with the frame it is working from:
+// the optical flow and the velocity mask run once per depth frame, the
+// fluid and the particles every app frame on the newest one, then the
+// draw. The end of draw() also fences the GPU, and the frame counts as
+// shown once that fence has passed, which is checked at the start of the
+// next update(), after the buffer swap: with vsync that is the refresh the
+// frame goes out on, short only of the display's own lag. The stages are
+// CPU times, when the work was handed to the driver. Each stage's p50,
+// p95 and p99 over the last 20 seconds are in the gui, and "log" writes
+// every frame's ages to a csv in the data folder. Render thread only.
+
+class PipelineLatency {
+public:
+    enum Stage {
+        STAGE_SOURCE = 0,	// taken by the render thread
+        STAGE_FLOW,
+        STAGE_MASK,
+        STAGE_FLUID,
+        STAGE_PARTICLES,
+        STAGE_DRAWN,
+        STAGE_SHOWN,
+        numStages
+    };
+    static const int	maxFences = 4;
+
+    PipelineLatency();
+    ~PipelineLatency();
+
+    bool	start(const string& _path);
+    void	stop();
+
+    ofParameterGroup	parameters;
+
+    // at the start of update(), checks on the frames drawn before
+    void	update();
+    // a new depth frame for the stages after it
+    void	setFrame(const DepthFrame& _frame);
+    void	mark(Stage _stage);
+    // at the end of draw()
+    void	drawn();
+
+protected:
+    void	markFrame(Stage _stage, uint64_t _sequence, uint64_t _capturedMicros);
+
+    ofParameter<bool>	log;
+    void				setLog(bool& _value);
+    ofParameter<string>	file;
+    ofParameter<string>	readouts[numStages];	// p50 / p95 / p99 ms
+
+    LatencyTracer	tracer;
+    uint64_t		sequence;			// the frame the stages are on
+    uint64_t		capturedMicros;
+    float			lastReadout;
+    FILE*			output;
+
+    // the draws the GPU may not have finished yet, oldest first
+    struct Fence {
+        GLsync		sync;
+        uint64_t	sequence;
+        uint64_t	capturedMicros;
+    };
+    Fence			fences[maxFences];
+    int				numFences;
+};
@@ -0,0 +1,295 @@
+#include "PointCloud.h"
+
+#define STRINGIFY(A) #A
+
+namespace {
+    // the fluid's textures are rectangles, as everywhere in ofxFlowTools
+    const string vertexBody = STRINGIFY(
+        uniform sampler2DRect velocity;
+        uniform vec2 velocitySize;
+        uniform float mirror;
+        uniform float pointSize;
+        uniform float speedScale;
+
+        vec3 hsv(float h, float s, float v) {
+            vec3 p = abs(fract(vec3(h) + vec3(1.0, 2.0 / 3.0, 1.0 / 3.0)) * 6.0 - 3.0);
+            return v * mix(vec3(1.0), clamp(p - 1.0, 0.0, 1.0), s);
+        }
+
+        vec4 place(vec4 eye, mat4 projection) {
+            // no reading, nothing drawn
+            if (pointZ == 0.0)
+                return vec4(0.0, 0.0, 2.0, 1.0);
+            return projection * eye;
+        }
+
+        vec3 shade(vec2 v) {
+            float speed = clamp(length(v) * speedScale, 0.0, 1.0);
+            float hue = speed > 0.0 ? atan(v.y, v.x) / 6.2831853 + 0.5 : 0.0;
+            return hsv(hue, speed, 0.6 + 0.4 * speed);
+        }
+    );
+
+    const string vertex120 = string("#version 120\n#extension GL_ARB_texture_rectangle : enable\n") +
+        "attribute float pointX;\nattribute float pointY;\nattribute float pointZ;\nattribute vec2 coord;\nvarying vec3 color;\n" +
+        vertexBody + STRINGIFY(
+        void main() {
+            vec4 eye = gl_ModelViewMatrix * vec4(pointX, pointY, pointZ, 1.0);
+            vec2 c = vec2(mix(coord.x, 1.0 - coord.x, mirror), coord.y) * velocitySize;
+            color = shade(texture2DRect(velocity, c).xy);
+            gl_Position = place(eye, gl_ProjectionMatrix);
+            gl_PointSize = pointSize / max(-eye.z, 0.1);
+        }
+    );
+
+    const string fragment120 = string("#version 120\nvarying vec3 color;\n") + STRINGIFY(
+        void main() {
+            vec2 p = gl_PointCoord * 2.0 - 1.0;
+            if (dot(p, p) > 1.0)
+                discard;
+            gl_FragColor = vec4(color, 1.0);
+        }
+    );
+
+    const string vertex150 = string("#version 150\n") +
+        "in float pointX;\nin float pointY;\nin float pointZ;\nin vec2 coord;\nout vec3 color;\n" +
+        "uniform mat4 modelViewMatrix;\nuniform mat4 projectionMatrix;\n" +
+        vertexBody + STRINGIFY(
+        void main() {
+            vec4 eye = modelViewMatrix * vec4(pointX, pointY, pointZ, 1.0);
+            vec2 c = vec2(mix(coord.x, 1.0 - coord.x, mirror), coord.y) * velocitySize;
+            color = shade(texture(velocity, c).xy);
+            gl_Position = place(eye, projectionMatrix);
+            gl_PointSize = pointSize / max(-eye.z, 0.1);
+        }
+    );
+
+    const string fragment150 = string("#version 150\nin vec3 color;\nout vec4 fragColor;\n") + STRINGIFY(
+        void main() {
+            vec2 p = gl_PointCoord * 2.0 - 1.0;
+            if (dot(p, p) > 1.0)
+                discard;
+            fragColor = vec4(color, 1.0);
+        }
+    );
+}
+
+//--------------------------------------------------------------
+PointCloud::PointCloud() {
+    numPoints = 0;
+    persistent = false;
+    coordBuffer = 0;
+    vertexArray = 0;
+    writeBuffer = 0;
+    drawBuffer = -1;
+    for (int b=0; b<numBuffers; b++) {
+        buffers[b] = 0;
+        mapped[b] = NULL;
+        fences[b] = NULL;
+    }
+
+    parameters.setName("point cloud");
+    parameters.add(nearClip.set("near mm", 500, 0, 4000));
+    parameters.add(farClip.set("far mm", 4000, 500, 8000));
+    parameters.add(pointSize.set("point size", 6, 1, 30));
+    parameters.add(speedScale.set("speed", 0.5, 0, 5));
+    parameters.add(spin.set("spin", 6, -45, 45));
+    parameters.add(distance.set("distance m", 2.5, 0.5, 6));
+    parameters.add(projectMs.set("project ms", 0, 0, 10));
+    parameters.add(waits.set("waits", 0, 0, 1000000));
+}
+
+//--------------------------------------------------------------
+PointCloud::~PointCloud() {
+    release();
+}
+
+//--------------------------------------------------------------
+void PointCloud::release() {
+    for (int b=0; b<numBuffers; b++) {
+        if (fences[b] != NULL)
+            glDeleteSync(fences[b]);
+        fences[b] = NULL;
+        if (mapped[b] != NULL) {
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[b]);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            mapped[b] = NULL;
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (buffers[0] != 0)
+        glDeleteBuffers(numBuffers, buffers);
+    for (int b=0; b<numBuffers; b++)
+        buffers[b] = 0;
+    if (coordBuffer != 0)
+        glDeleteBuffers(1, &coordBuffer);
+    coordBuffer = 0;
+    if (vertexArray != 0)
+        glDeleteVertexArrays(1, &vertexArray);
+    vertexArray = 0;
+    drawBuffer = -1;
+}
+
+//--------------------------------------------------------------
+void PointCloud::setupShader() {
+    if (ofIsGLProgrammableRenderer()) {
+        shader.setupShaderFromSource(GL_VERTEX_SHADER, vertex150);
+        shader.setupShaderFromSource(GL_FRAGMENT_SHADER, fragment150);
+    }
+    else {
+        shader.setupShaderFromSource(GL_VERTEX_SHADER, vertex120);
+        shader.setupShaderFromSource(GL_FRAGMENT_SHADER, fragment120);
+    }
+    // the legacy renderer wants something at attribute 0
+    shader.bindAttribute(0, "pointZ");
+    shader.linkProgram();
+}
+
+//--------------------------------------------------------------
+void PointCloud::setup(int _width, int _height) {
+    release();
+    projector.setup(_width, _height);
+    numPoints = projector.getNumPoints();
+    if (!shader.isLoaded())
+        setupShader();
+
+    // where each point sits in the image, for the velocity under it
+    vector<float> coords(numPoints * 2);
+    for (int y=0; y<_height; y++) {
+        for (int x=0; x<_width; x++) {
+            coords[(y * _width + x) * 2] = (x + 0.5f) / _width;
+            coords[(y * _width + x) * 2 + 1] = (y + 0.5f) / _height;
+        }
+    }
+    glGenBuffers(1, &coordBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, coordBuffer);
+    glBufferData(GL_ARRAY_BUFFER, coords.size() * sizeof(float), coords.data(), GL_STATIC_DRAW);
+
+    GLsizeiptr size = numPoints * 3 * sizeof(float);
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    persistent = ofGLCheckExtension("GL_ARB_buffer_storage");
+    glGenBuffers(numBuffers, buffers);
+    for (int b=0; b<numBuffers; b++) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[b]);
+        if (persistent) {
+            glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+            mapped[b] = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+        }
+        else {
+            glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (ofIsGLProgrammableRenderer())
+        glGenVertexArrays(1, &vertexArray);
+    writeBuffer = 0;
+    drawBuffer = -1;
+}
+
+//--------------------------------------------------------------
+void PointCloud::update(const ofShortPixels& _rawDepth) {
+    if (buffers[0] == 0 || (int)_rawDepth.getWidth() != projector.getWidth() || (int)_rawDepth.getHeight() != projector.getHeight())
+        return;
+
+    // drawn from numBuffers frames ago, and long since done with
+    int b = writeBuffer;
+    writeBuffer = (writeBuffer + 1) % numBuffers;
+    if (fences[b] != NULL) {
+        if (glClientWaitSync(fences[b], 0, 0) == GL_TIMEOUT_EXPIRED) {
+            waits.set(waits + 1);
+            glClientWaitSync(fences[b], GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+        }
+        glDeleteSync(fences[b]);
+        fences[b] = NULL;
+    }
+
+    GLsizeiptr size = numPoints * 3 * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[b]);
+    float* dst = mapped[b];
+    if (!persistent)
+        dst = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst != NULL) {
+        uint64_t start = ofGetElapsedTimeMicros();
+        projector.setRange(nearClip, farClip);
+        projector.project(_rawDepth.getData(), dst, dst + numPoints, dst + numPoints * 2);
+        projectMs.set((ofGetElapsedTimeMicros() - start) / 1000.0f);
+        if (!persistent)
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        drawBuffer = b;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//--------------------------------------------------------------
+void PointCloud::draw(const ofTexture& _velocity, bool _mirror, int _x, int _y, int _width, int _height) {
+    if (drawBuffer < 0 || !shader.isLoaded())
+        return;
+
+    // round the middle of the stage, starting from where the kinect stands
+    float angle = ofGetElapsedTimef() * spin * DEG_TO_RAD;
+    camera.setNearClip(0.05f);
+    camera.setFarClip(50);
+    camera.setFov(45);
+    camera.setPosition(sinf(angle) * distance, 0, -distance + cosf(angle) * distance);
+    camera.lookAt(ofVec3f(0, 0, -distance));
+    camera.begin(ofRectangle(_x, _y, _width, _height));
+    ofPushStyle();
+    ofPushMatrix();
+    if (_mirror)
+        ofScale(-1, 1, 1);
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    ofEnableDepthTest();
+    ofEnablePointSprites();
+    glEnable(ofIsGLProgrammableRenderer() ? GL_PROGRAM_POINT_SIZE : GL_VERTEX_PROGRAM_POINT_SIZE);
+
+    shader.begin();
+    shader.setUniformTexture("velocity", _velocity, 0);
+    shader.setUniform2f("velocitySize", _velocity.getWidth(), _velocity.getHeight());
+    shader.setUniform1f("mirror", _mirror ? 1 : 0);
+    shader.setUniform1f("pointSize", pointSize);
+    shader.setUniform1f("speedScale", speedScale);
+
+    // one call for the whole frame
+    if (vertexArray != 0)
+        glBindVertexArray(vertexArray);
+    GLint pointX = shader.getAttributeLocation("pointX");
+    GLint pointY = shader.getAttributeLocation("pointY");
+    GLint pointZ = shader.getAttributeLocation("pointZ");
+    GLint coord = shader.getAttributeLocation("coord");
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[drawBuffer]);
+    GLint planes[3] = { pointX, pointY, pointZ };
+    for (int p=0; p<3; p++) {
+        if (planes[p] < 0)
+            continue;
+        glEnableVertexAttribArray(planes[p]);
+        glVertexAttribPointer(planes[p], 1, GL_FLOAT, GL_FALSE, 0, (const void*)(p * numPoints * sizeof(float)));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, coordBuffer);
+    if (coord >= 0) {
+        glEnableVertexAttribArray(coord);
+        glVertexAttribPointer(coord, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    }
+    glDrawArrays(GL_POINTS, 0, numPoints);
+    for (int p=0; p<3; p++) {
+        if (planes[p] >= 0)
+            glDisableVertexAttribArray(planes[p]);
+    }
+    if (coord >= 0)
+        glDisableVertexAttribArray(coord);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (vertexArray != 0)
+        glBindVertexArray(0);
+    shader.end();
+
+    // the buffer is the GPU's until this has been drawn
+    if (fences[drawBuffer] != NULL)
+        glDeleteSync(fences[drawBuffer]);
+    fences[drawBuffer] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    glDisable(ofIsGLProgrammableRenderer() ? GL_PROGRAM_POINT_SIZE : GL_VERTEX_PROGRAM_POINT_SIZE);
+    ofDisablePointSprites();
+    ofDisableDepthTest();
+    ofPopMatrix();
+    ofPopStyle();
+    camera.end();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ofMain.h"
+#include "DepthProjector.h"
+
+// The dancers as points in space, each coloured by the fluid's velocity
+// where it stands: hue for the direction, saturation for the speed. Every
+// depth frame is back-projected with a DepthProjector straight into one of
+// a ring of vertex buffers, persistently mapped where the driver can
+// (GL_ARB_buffer_storage) and mapped unsynchronized per frame elsewhere,
+// with a fence per buffer as in DepthUpload. The whole frame is then one
+// draw call of GL_POINTS, sized by distance in the vertex shader and drawn
+// round by the fragment shader, which also reads the velocity texture; no
+// per point work on the CPU past the projection. Render thread only.
+
+class PointCloud {
+public:
+    static const int	numBuffers = 3;
+
+    PointCloud();
+    ~PointCloud();
+
+    void	setup(int _width, int _height);
+    void	update(const ofShortPixels& _rawDepth);
+    // _velocity the fluid's, mirrored along with the points if asked
+    void	draw(const ofTexture& _velocity, bool _mirror, int _x, int _y, int _width, int _height);
+
+    ofParameterGroup	parameters;
+
+protected:
+    void	release();
+    void	setupShader();
+
+    ofParameter<int>	nearClip;		// mm
+    ofParameter<int>	farClip;
+    ofParameter<float>	pointSize;		// pixels at a metre
+    ofParameter<float>	speedScale;		// velocity to full colour
+    ofParameter<float>	spin;			// degrees a second round the dancers
+    ofParameter<float>	distance;		// metres from the camera to the stage centre
+    ofParameter<float>	projectMs;		// readout
+    ofParameter<int>	waits;			// updates that found their buffer still busy
+
+    DepthProjector	projector;
+    ofShader		shader;
+    ofCamera		camera;
+    int				numPoints;
+    bool			persistent;
+    GLuint			buffers[numBuffers];	// x, y and z planes
+    float*			mapped[numBuffers];
+    GLsync			fences[numBuffers];
+    GLuint			coordBuffer;			// each point's place in the image, 0 .. 1
+    GLuint			vertexArray;			// programmable renderer only
+    int				writeBuffer;
+    int				drawBuffer;				// the latest written, -1 before the first
+};
@@ -0,0 +1,188 @@
+#include "RealFft.h"
+#include "Simd.h"
+
+#include <cmath>
+
+//--------------------------------------------------------------
+RealFft::RealFft() {
+    size = 0;
+    half = 0;
+    window = REAL_FFT_WINDOW_HANN;
+    amplitudeScale = 1;
+}
+
+//--------------------------------------------------------------
+void RealFft::setup(int _size, RealFftWindow _window) {
+    size = minSize;
+    while (size < _size && size < maxSize)
+        size <<= 1;
+    half = size / 2;
+    window = _window;
+
+    const double pi = 3.14159265358979323846;
+
+    // periodic windows, they overlap-add cleanly at the usual hops
+    windowTable.resize(size);
+    double sum = 0;
+    for (int n=0; n<size; n++) {
+        double x = 2.0 * pi * n / size;
+        double w = 1.0;
+        switch (window) {
+            case REAL_FFT_WINDOW_HANN:				w = 0.5 - 0.5 * cos(x); break;
+            case REAL_FFT_WINDOW_HAMMING:			w = 0.54 - 0.46 * cos(x); break;
+            case REAL_FFT_WINDOW_BLACKMAN_HARRIS:	w = 0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2 * x) - 0.01168 * cos(3 * x); break;
+            default: break;
+        }
+        windowTable[n] = w;
+        sum += w;
+    }
+    amplitudeScale = 2.0 / sum;
+
+    int bits = 0;
+    while ((1 << bits) < half)
+        bits++;
+    bitReverse.resize(half);
+    for (int n=0; n<half; n++) {
+        int r = 0;
+        for (int b=0; b<bits; b++)
+            if (n & (1 << b))
+                r |= 1 << (bits - 1 - b);
+        bitReverse[n] = r;
+    }
+
+    // the first two stages are done as one twiddle free radix 4 pass, the
+    // stage with half length h keeps its h twiddles at offset h - 4
+    stageRe.resize(half);
+    stageIm.resize(half);
+    for (int h=4; h<half; h<<=1) {
+        for (int j=0; j<h; j++) {
+            stageRe[h - 4 + j] = cos(-pi * j / h);
+            stageIm[h - 4 + j] = sin(-pi * j / h);
+        }
+    }
+
+    splitRe.resize(half);
+    splitIm.resize(half);
+    for (int k=0; k<half; k++) {
+        splitRe[k] = cos(-pi * k / half);
+        splitIm[k] = sin(-pi * k / half);
+    }
+
+    zRe.assign(half, 0);
+    zIm.assign(half, 0);
+    binRe.assign(half + 1, 0);
+    binIm.assign(half + 1, 0);
+}
+
+//--------------------------------------------------------------
+void RealFft::forward(const float* _input, float* _re, float* _im) {
+    // even samples become the real part, odd ones the imaginary part, already
+    // windowed and in bit reversed order
+    const float* w = windowTable.data();
+    for (int n=0; n<half; n++) {
+        int m = 2 * bitReverse[n];
+        zRe[n] = _input[m] * w[m];
+        zIm[n] = _input[m + 1] * w[m + 1];
+    }
+
+    transformHalf();
+
+    // untangle the spectra of the even and odd samples into the real spectrum
+    _re[0] = zRe[0] + zIm[0];
+    _im[0] = 0;
+    _re[half] = zRe[0] - zIm[0];
+    _im[half] = 0;
+    for (int k=1; k<half; k++) {
+        float aRe = zRe[k];
+        float aIm = zIm[k];
+        float bRe = zRe[half - k];
+        float bIm = -zIm[half - k];
+
+        float eRe = 0.5f * (aRe + bRe);
+        float eIm = 0.5f * (aIm + bIm);
+        float oRe = 0.5f * (aIm - bIm);
+        float oIm = -0.5f * (aRe - bRe);
+
+        _re[k] = eRe + splitRe[k] * oRe - splitIm[k] * oIm;
+        _im[k] = eIm + splitRe[k] * oIm + splitIm[k] * oRe;
+    }
+}
+
+//--------------------------------------------------------------
+void RealFft::amplitudes(const float* _input, float* _amplitudes) {
+    forward(_input, binRe.data(), binIm.data());
+
+    int numBins = half + 1;
+    int k = 0;
+    simd::vfloat scale = simd::set1(amplitudeScale);
+    for (; k + simd::width <= numBins; k += simd::width) {
+        simd::vfloat re = simd::load(&binRe[k]);
+        simd::vfloat im = simd::load(&binIm[k]);
+        simd::vfloat power = simd::madd(im, im, simd::mul(re, re));
+        simd::store(&_amplitudes[k], simd::mul(simd::sqrt(power), scale));
+    }
+    for (; k<numBins; k++)
+        _amplitudes[k] = std::sqrt(binRe[k] * binRe[k] + binIm[k] * binIm[k]) * amplitudeScale;
+}
+
+//--------------------------------------------------------------
+void RealFft::transformHalf() {
+    float* re = zRe.data();
+    float* im = zIm.data();
+
+    // stages 1 and 2: twiddles are 1 and -i
+    for (int i=0; i<half; i+=4) {
+        float s0Re = re[i] + re[i + 1],		s0Im = im[i] + im[i + 1];
+        float d0Re = re[i] - re[i + 1],		d0Im = im[i] - im[i + 1];
+        float s1Re = re[i + 2] + re[i + 3],	s1Im = im[i + 2] + im[i + 3];
+        float d1Re = re[i + 2] - re[i + 3],	d1Im = im[i + 2] - im[i + 3];
+
+        re[i]		= s0Re + s1Re;	im[i]		= s0Im + s1Im;
+        re[i + 2]	= s0Re - s1Re;	im[i + 2]	= s0Im - s1Im;
+        // -i * d1 = (d1Im, -d1Re)
+        re[i + 1]	= d0Re + d1Im;	im[i + 1]	= d0Im - d1Re;
+        re[i + 3]	= d0Re - d1Im;	im[i + 3]	= d0Im + d1Re;
+    }
+
+    for (int h=4; h<half; h<<=1) {
+        const float* twRe = &stageRe[h - 4];
+        const float* twIm = &stageIm[h - 4];
+
+        if (h >= simd::width) {
+            for (int i=0; i<half; i+=2*h) {
+                float* aRe = re + i;
+                float* aIm = im + i;
+                float* bRe = aRe + h;
+                float* bIm = aIm + h;
+                for (int j=0; j<h; j+=simd::width) {
+                    simd::vfloat wr = simd::load(twRe + j);
+                    simd::vfloat wi = simd::load(twIm + j);
+                    simd::vfloat br = simd::load(bRe + j);
+                    simd::vfloat bi = simd::load(bIm + j);
+                    simd::vfloat tr = simd::nmadd(bi, wi, simd::mul(br, wr));
+                    simd::vfloat ti = simd::madd(bi, wr, simd::mul(br, wi));
+                    simd::vfloat ar = simd::load(aRe + j);
+                    simd::vfloat ai = simd::load(aIm + j);
+                    simd::store(aRe + j, simd::add(ar, tr));
+                    simd::store(aIm + j, simd::add(ai, ti));
+                    simd::store(bRe + j, simd::sub(ar, tr));
+                    simd::store(bIm + j, simd::sub(ai, ti));
+                }
+            }
+        }
+        else {
+            for (int i=0; i<half; i+=2*h) {
+                for (int j=0; j<h; j++) {
+                    int a = i + j;
+                    int b = a + h;
+                    float tr = re[b] * twRe[j] - im[b] * twIm[j];
+                    float ti = re[b] * twIm[j] + im[b] * twRe[j];
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+    }
+}
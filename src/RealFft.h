@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+// Forward FFT of real, windowed blocks, for the audio analysis.
+// The input is packed into a complex transform of half the size, which runs
+// iteratively on split real / imaginary arrays so every butterfly stage maps
+// straight onto the vector lanes in Simd.h. All twiddles, the bit reversal and
+// the window are computed in setup(); forward() never allocates.
+// This file deliberately doesn't depend on openFrameworks so it can be built
+// into the benchmark in bench/ on its own.
+
+enum RealFftWindow {
+    REAL_FFT_WINDOW_RECTANGULAR = 0,
+    REAL_FFT_WINDOW_HANN,
+    REAL_FFT_WINDOW_HAMMING,
+    REAL_FFT_WINDOW_BLACKMAN_HARRIS,
+};
+
+class RealFft {
+public:
+    static const int	minSize = 256;
+    static const int	maxSize = 8192;
+
+    RealFft();
+
+    // _size is rounded up to a power of two within [minSize, maxSize]
+    void	setup(int _size, RealFftWindow _window = REAL_FFT_WINDOW_HANN);
+
+    int		getSize() const			{ return size; }
+    int		getNumBins() const		{ return size / 2 + 1; }
+    RealFftWindow	getWindow() const	{ return window; }
+    // scales a bin so a full scale sine reads 1.0 through the current window
+    float	getAmplitudeScale() const	{ return amplitudeScale; }
+
+    // windows getSize() samples and writes getNumBins() complex bins
+    void	forward(const float* _input, float* _re, float* _im);
+    // windowed amplitude spectrum, getNumBins() values, scaled by getAmplitudeScale()
+    void	amplitudes(const float* _input, float* _amplitudes);
+
+private:
+    void	transformHalf();
+
+    int					size;
+    int					half;
+    RealFftWindow		window;
+    float				amplitudeScale;
+
+    std::vector<float>	windowTable;
+    std::vector<int>	bitReverse;
+    std::vector<float>	stageRe;		// twiddles of each butterfly stage, back to back
+    std::vector<float>	stageIm;
+    std::vector<float>	splitRe;		// exp(-i pi k / half), for unpacking the real spectrum
+    std::vector<float>	splitIm;
+
+    std::vector<float>	zRe;
+    std::vector<float>	zIm;
+    std::vector<float>	binRe;
+    std::vector<float>	binIm;
+};
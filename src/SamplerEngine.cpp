@@ -0,0 +1,183 @@
+#include "SamplerEngine.h"
+
+//--------------------------------------------------------------
+SamplerEngine::SamplerEngine() {
+    sample = NULL;
+    droppedCommands = 0;
+    renderedFrames = 0;
+    callbackVolume = 1.0f;
+    callbackSmoothing = 5.0f;
+    callbackVoices = 64;
+    active = 0;
+    stolen = 0;
+    numPending = 0;
+    maxBlockSize = 0;
+    outputSampleRate = 44100;
+    sampleReady = false;
+
+    // a few blocks worth of hundreds of triggers a second
+    commands.setup(1024);
+
+    parameters.setName("sampler");
+    parameters.add(volume.set("volume", 1.0, 0.0, 4.0));
+    parameters.add(smoothing.set("smoothing ms", 5.0, 0.0, 100.0));
+    parameters.add(numVoices.set("voices", 64, 1, VoicePool::maxVoices));
+    parameters.add(activeVoices.set("active", 0, 0, VoicePool::maxVoices * 2));
+    parameters.add(stolenVoices.set("stolen", 0, 0, 1000000));
+    volume.addListener(this, &SamplerEngine::setVolume);
+    smoothing.addListener(this, &SamplerEngine::setSmoothing);
+    numVoices.addListener(this, &SamplerEngine::setNumVoices);
+}
+
+//--------------------------------------------------------------
+void SamplerEngine::setup(const PcmTrack& _sample, int _outputSampleRate, int _maxBlockSize) {
+    sample = &_sample;
+    maxBlockSize = _maxBlockSize;
+    mixLeft.assign(maxBlockSize, 0);
+    mixRight.assign(maxBlockSize, 0);
+    pool.setup(numVoices.get(), _outputSampleRate, maxBlockSize);
+    outputSampleRate = _outputSampleRate;
+    sampleReady = false;
+}
+
+//--------------------------------------------------------------
+void SamplerEngine::send(SamplerCommandType _type, float _speed, float _pan, float _gain, float _priority, int _group, int64_t _frame) {
+    SamplerCommand command;
+    command.type = _type;
+    command.speed = _speed;
+    command.pan = _pan;
+    command.gain = _gain;
+    command.priority = _priority;
+    command.group = _group;
+    command.frame = _frame;
+    if (!commands.push(command))
+        droppedCommands++;
+}
+
+//--------------------------------------------------------------
+void SamplerEngine::trigger(float _speed, float _pan, float _gain, float _priority, int _group, int64_t _frame) {
+    send(SAMPLER_TRIGGER, _speed, _pan, _gain, _priority, _group, _frame);
+}
+
+//--------------------------------------------------------------
+void SamplerEngine::setSpeed(int _group, float _speed, int64_t _frame)	{ send(SAMPLER_SPEED, _speed, 0, 0, 0, _group, _frame); }
+void SamplerEngine::setPan(int _group, float _pan, int64_t _frame)		{ send(SAMPLER_PAN, 0, _pan, 0, 0, _group, _frame); }
+void SamplerEngine::setGain(int _group, float _gain, int64_t _frame)	{ send(SAMPLER_GAIN, 0, 0, _gain, 0, _group, _frame); }
+void SamplerEngine::stop(int _group, int64_t _frame)					{ send(SAMPLER_STOP, 0, 0, 0, 0, _group, _frame); }
+
+//--------------------------------------------------------------
+void SamplerEngine::update() {
+    activeVoices.set(active.load());
+    stolenVoices.set(stolen.load());
+}
+
+//--------------------------------------------------------------
+void SamplerEngine::apply(const SamplerCommand& _command) {
+    switch (_command.type) {
+        case SAMPLER_TRIGGER:	pool.trigger(_command.speed, _command.pan, _command.gain, _command.priority, _command.group); break;
+        case SAMPLER_SPEED:		pool.setSpeed(_command.group, _command.speed); break;
+        case SAMPLER_PAN:		pool.setPan(_command.group, _command.pan); break;
+        case SAMPLER_GAIN:		pool.setGain(_command.group, _command.gain); break;
+        case SAMPLER_STOP:		pool.release(_command.group); break;
+        default: break;
+    }
+}
+
+//--------------------------------------------------------------
+void SamplerEngine::renderVoices(const Destination& _destination, int _offset, int _numFrames) {
+    if (_destination.sources != NULL) {
+        float* sources[VoicePool::maxGroups + 1];
+        int numSources = min(_destination.numSources, (int)VoicePool::maxGroups + 1);
+        for (int start=0; start<_numFrames; start+=maxBlockSize) {
+            for (int s=0; s<numSources; s++)
+                sources[s] = _destination.sources[s] + _offset + start;
+            pool.renderSources(sources, numSources, min(maxBlockSize, _numFrames - start));
+        }
+        return;
+    }
+
+    // planar mix for the vectorized voices, interleaved at the end
+    int channels = _destination.numChannels;
+    for (int start=0; start<_numFrames; start+=maxBlockSize) {
+        int n = min(maxBlockSize, _numFrames - start);
+        std::fill(mixLeft.begin(), mixLeft.begin() + n, 0.0f);
+        std::fill(mixRight.begin(), mixRight.begin() + n, 0.0f);
+        pool.render(mixLeft.data(), mixRight.data(), n);
+
+        float* frame = _destination.output + (_offset + start) * channels;
+        if (channels == 1) {
+            for (int i=0; i<n; i++)
+                frame[i] += 0.5f * (mixLeft[i] + mixRight[i]);
+        }
+        else {
+            for (int i=0; i<n; i++, frame+=channels) {
+                frame[0] += mixLeft[i];
+                frame[1] += mixRight[i];
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void SamplerEngine::render(float* _output, int _numFrames, int _numChannels) {
+    Destination destination = { _output, _numChannels, NULL, 0 };
+    process(destination, _numFrames);
+}
+
+//--------------------------------------------------------------
+void SamplerEngine::renderSources(float* const* _sources, int _numSources, int _numFrames) {
+    Destination destination = { NULL, 0, _sources, _numSources };
+    process(destination, _numFrames);
+}
+
+//--------------------------------------------------------------
+void SamplerEngine::process(const Destination& _destination, int _numFrames) {
+    int64_t blockStart = renderedFrames.load(std::memory_order_relaxed);
+    int64_t blockEnd = blockStart + _numFrames;
+
+    SamplerCommand command;
+    while (numPending < maxPending && commands.pop(command))
+        pending[numPending++] = command;
+
+    if (!sampleReady && sample != NULL && sample->isDecoded()) {
+        pool.setSample(sample->getSamples(), sample->getNumFrames(), sample->getNumChannels(), (float)sample->getSampleRate() / outputSampleRate);
+        sampleReady = true;
+    }
+    if (!sampleReady) {
+        numPending = 0;
+        renderedFrames.store(blockEnd, std::memory_order_release);
+        return;
+    }
+    pool.setVolume(callbackVolume.load());
+    pool.setSmoothing(callbackSmoothing.load());
+    if (callbackVoices.load() != pool.getNumVoices())
+        pool.setNumVoices(callbackVoices.load());
+
+    // render up to each due command, apply it, carry on
+    int rendered = 0;
+    while (rendered < _numFrames) {
+        int next = -1;
+        for (int c=0; c<numPending; c++)
+            if (next < 0 || pending[c].frame < pending[next].frame)
+                next = c;
+
+        int until = _numFrames;
+        if (next >= 0 && pending[next].frame < blockEnd)
+            until = max(rendered, (int)(pending[next].frame - blockStart));
+
+        if (until > rendered)
+            renderVoices(_destination, rendered, until - rendered);
+        rendered = until;
+
+        if (next >= 0 && pending[next].frame < blockEnd) {
+            apply(pending[next]);
+            // keep the rest in order, commands for the same frame apply as sent
+            for (int c=next+1; c<numPending; c++)
+                pending[c - 1] = pending[c];
+            numPending--;
+        }
+    }
+    active.store(pool.getNumActive());
+    stolen.store(pool.getNumStolen());
+    renderedFrames.store(blockEnd, std::memory_order_release);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ofMain.h"
+#include "PcmTrack.h"
+#include "SpscRing.h"
+#include "VoicePool.h"
+
+// Plays a sample held in RAM from the audio callback, on a pool of voices.
+// The render thread only queues commands (trigger, speed, pan, gain) into a
+// lock free ring; the callback applies them at the exact output frame they
+// are stamped with, or at the start of the next block. Speed, pan and gain
+// glide to new values over the smoothing time so dragging can modulate a
+// playing voice without zipper noise. Voices in a group (the mouse synth is
+// group 0) are monophonic: a retrigger fades the previous one out instead
+// of cutting it, and the set* calls bend the latest. Nothing in render()
+// locks or allocates.
+
+enum SamplerCommandType {
+    SAMPLER_TRIGGER = 0,
+    SAMPLER_SPEED,
+    SAMPLER_PAN,
+    SAMPLER_GAIN,
+    SAMPLER_STOP,
+};
+
+struct SamplerCommand {
+    SamplerCommandType	type;
+    float				speed;
+    float				pan;		// -1 left .. 1 right
+    float				gain;
+    float				priority;	// which voice gives way when the pool is full
+    int					group;
+    int64_t				frame;		// output frame to apply at, 0 for as soon as possible
+};
+
+class SamplerEngine {
+public:
+    SamplerEngine();
+
+    void	setup(const PcmTrack& _sample, int _outputSampleRate, int _maxBlockSize = 4096);
+
+    ofParameterGroup	parameters;
+
+    // render thread
+    void	trigger(float _speed = 1, float _pan = 0, float _gain = 1, float _priority = 0, int _group = -1, int64_t _frame = 0);
+    void	setSpeed(int _group, float _speed, int64_t _frame = 0);
+    void	setPan(int _group, float _pan, int64_t _frame = 0);
+    void	setGain(int _group, float _gain, int64_t _frame = 0);
+    void	stop(int _group, int64_t _frame = 0);
+    void	update();		// publishes the voice count to the gui
+
+    int64_t		getRenderedFrames() const		{ return renderedFrames.load(); }
+    uint64_t	getNumDroppedCommands() const	{ return droppedCommands.load(); }
+
+    // audio thread, adds into _output
+    void	render(float* _output, int _numFrames, int _numChannels);
+    // or mono into _sources[0] for the ungrouped voices and _sources[group + 1]
+    // for each group, to be placed by a Spatializer
+    void	renderSources(float* const* _sources, int _numSources, int _numFrames);
+
+protected:
+    struct Destination {
+        float*			output;		// interleaved
+        int				numChannels;
+        float* const*	sources;	// or one mono buffer per source
+        int				numSources;
+    };
+
+    void	send(SamplerCommandType _type, float _speed, float _pan, float _gain, float _priority, int _group, int64_t _frame);
+    void	apply(const SamplerCommand& _command);
+    void	process(const Destination& _destination, int _numFrames);
+    void	renderVoices(const Destination& _destination, int _offset, int _numFrames);
+
+    ofParameter<float>	volume;
+    void				setVolume(float& _value)	{ callbackVolume.store(_value); }
+    ofParameter<float>	smoothing;		// ms
+    void				setSmoothing(float& _value)	{ callbackSmoothing.store(_value); }
+    ofParameter<int>	numVoices;
+    void				setNumVoices(int& _value)	{ callbackVoices.store(_value); }
+    ofParameter<int>	activeVoices;
+    ofParameter<int>	stolenVoices;
+
+    const PcmTrack*		sample;
+
+    SpscRing<SamplerCommand>	commands;
+    std::atomic<uint64_t>		droppedCommands;
+    std::atomic<int64_t>		renderedFrames;
+    std::atomic<float>			callbackVolume;
+    std::atomic<float>			callbackSmoothing;
+    std::atomic<int>			callbackVoices;
+    std::atomic<int>			active;
+    std::atomic<uint64_t>		stolen;
+
+    // audio thread only
+    static const int	maxPending = 256;
+    SamplerCommand		pending[maxPending];	// popped, waiting for their frame
+    int					numPending;
+    VoicePool			pool;
+    int					maxBlockSize;
+    int					outputSampleRate;
+    bool				sampleReady;	// handed to the pool once decoded
+    vector<float>		mixLeft;
+    vector<float>		mixRight;
+};
@@ -0,0 +1,117 @@
+#include "SilhouetteContours.h"
+
+//--------------------------------------------------------------
+SilhouetteContours::SilhouetteContours() {
+    depthWidth = 0;
+    depthHeight = 0;
+    lastMicros = 0;
+    traced = false;
+
+    parameters.setName("contours");
+    parameters.add(tolerance.set("tolerance", 1.5, 0.5, 5));
+    parameters.add(minLength.set("min length", 40, 10, 400));
+    parameters.add(obstacle.set("obstacle", false));
+    parameters.add(wallWidth.set("wall width", 2, 1, 8));
+    parameters.add(emit.set("emit", true));
+    parameters.add(strength.set("strength", 1, 0, 5));
+    parameters.add(fullSpeed.set("full speed", 300, 10, 2000));
+    parameters.add(numContours.set("count", 0, 0, 64));
+    parameters.add(numCorners.set("corners", 0, 0, 4096));
+    parameters.add(traceMs.set("trace ms", 0, 0, 5));
+}
+
+//--------------------------------------------------------------
+void SilhouetteContours::setup(int _depthWidth, int _depthHeight, int _flowWidth, int _flowHeight) {
+    depthWidth = _depthWidth;
+    depthHeight = _depthHeight;
+    tracer.setup(depthWidth, depthHeight);
+    obstacleFbo.allocate(_flowWidth, _flowHeight, GL_R8);
+    densityFbo.allocate(_flowWidth, _flowHeight, GL_RGBA32F);
+    lines.setMode(OF_PRIMITIVE_LINES);
+    reset();
+}
+
+//--------------------------------------------------------------
+void SilhouetteContours::reset() {
+    tracer.reset();
+    lastMicros = 0;
+    traced = true;
+}
+
+//--------------------------------------------------------------
+void SilhouetteContours::track(const ofPixels& _mask, const DepthFrame& _frame) {
+    if ((int)_mask.getWidth() != depthWidth || (int)_mask.getHeight() != depthHeight)
+        return;
+
+    // the speeds are per second of the camera's time, not the app's
+    float deltaTime = lastMicros != 0 && _frame.capturedMicros > lastMicros ? (_frame.capturedMicros - lastMicros) / 1000000.0f : 0.0f;
+    lastMicros = _frame.capturedMicros;
+
+    uint64_t start = ofGetElapsedTimeMicros();
+    tracer.tolerance = tolerance;
+    tracer.minLength = minLength;
+    tracer.process(_mask.getData(), deltaTime);
+    traceMs.set((ofGetElapsedTimeMicros() - start) / 1000.0f);
+    numContours.set(tracer.getContours().size());
+    numCorners.set(tracer.getVertices().size());
+    traced = true;
+}
+
+//--------------------------------------------------------------
+void SilhouetteContours::update() {
+    if (!traced || depthWidth == 0)
+        return;
+    traced = false;
+
+    // every side of every outline as a line of its own, each end as bright
+    // as its corner is moving outwards
+    const vector<ContourVertex>& vertices = tracer.getVertices();
+    const vector<Contour>& contours = tracer.getContours();
+    lines.clear();
+    for (size_t c=0; c<contours.size(); c++) {
+        const ContourVertex* v = &vertices[contours[c].first];
+        int n = contours[c].count;
+        for (int i=0; i<n; i++) {
+            const ContourVertex& a = v[i];
+            const ContourVertex& b = v[(i + 1) % n];
+            float brightA = ofClamp(a.speed / fullSpeed, 0, 1);
+            float brightB = ofClamp(b.speed / fullSpeed, 0, 1);
+            lines.addVertex(ofVec3f(a.x, a.y, 0));
+            lines.addColor(ofFloatColor(brightA, brightA));
+            lines.addVertex(ofVec3f(b.x, b.y, 0));
+            lines.addColor(ofFloatColor(brightB, brightB));
+        }
+    }
+
+    // the mask's pixel centres onto the flow's
+    float scaleX = obstacleFbo.getWidth() / depthWidth;
+    float scaleY = obstacleFbo.getHeight() / depthHeight;
+    ofPushStyle();
+    ofEnableBlendMode(OF_BLENDMODE_DISABLED);
+    ofSetLineWidth(wallWidth);
+
+    if (obstacle) {
+        obstacleFbo.begin();
+        ofClear(0);
+        ofPushMatrix();
+        ofScale(scaleX, scaleY);
+        ofTranslate(0.5, 0.5);
+        ofSetColor(255);
+        lines.disableColors();
+        lines.draw();
+        lines.enableColors();
+        ofPopMatrix();
+        obstacleFbo.end();
+    }
+    if (emit) {
+        densityFbo.begin();
+        ofClear(0, 0);
+        ofPushMatrix();
+        ofScale(scaleX, scaleY);
+        ofTranslate(0.5, 0.5);
+        lines.draw();
+        ofPopMatrix();
+        densityFbo.end();
+    }
+    ofPopStyle();
+}
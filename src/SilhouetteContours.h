@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ContourTracer.h"
+#include "DepthSource.h"
+
+// The dancers' outlines, traced from the foreground mask with a
+// ContourTracer whenever there is a new depth frame, and drawn at the
+// flow's resolution two ways: as a wall the fluid flows round, for
+// ftFluidSimulation::addTempObstacle, and as lines of density that are
+// brightest where the outline moves outwards fastest, so a dancer who
+// throws out an arm sheds smoke off its edge. Render thread only.
+
+class SilhouetteContours {
+public:
+    SilhouetteContours();
+
+    void	setup(int _depthWidth, int _depthHeight, int _flowWidth, int _flowHeight);
+    // a new mask and the depth frame it came from
+    void	track(const ofPixels& _mask, const DepthFrame& _frame);
+    // every frame, redraws the textures when the outlines have changed
+    void	update();
+    void	reset();
+
+    ofParameterGroup	parameters;
+
+    const vector<ContourVertex>&	getVertices() const	{ return tracer.getVertices(); }
+    const vector<Contour>&			getContours() const	{ return tracer.getContours(); }
+
+    bool		isObstacle() const		{ return obstacle; }
+    bool		isEmitting() const		{ return emit; }
+    float		getStrength() const		{ return strength; }
+    ofTexture&	getObstacleTexture()	{ return obstacleFbo.getTexture(); }
+    ofTexture&	getDensityTexture()		{ return densityFbo.getTexture(); }
+
+protected:
+    ofParameter<float>	tolerance;
+    ofParameter<int>	minLength;
+    ofParameter<bool>	obstacle;
+    ofParameter<float>	wallWidth;		// flow pixels
+    ofParameter<bool>	emit;
+    ofParameter<float>	strength;
+    ofParameter<float>	fullSpeed;		// depth pixels a second for the brightest density
+    ofParameter<int>	numContours;	// readouts
+    ofParameter<int>	numCorners;
+    ofParameter<float>	traceMs;
+
+    ContourTracer	tracer;
+    int				depthWidth;
+    int				depthHeight;
+    uint64_t		lastMicros;		// when the last frame traced was captured
+    bool			traced;			// since the textures were last drawn
+    ofFbo			obstacleFbo;
+    ofFbo			densityFbo;
+    ofMesh			lines;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+// Thin wrapper over the float vector instructions the DSP code uses, so a
+// kernel can be written once and compile to AVX2, NEON or SSE. AVX2 is only
+// picked up when the compiler is told the target has it (-mavx2 -mfma);
+// x86-64 builds otherwise get SSE, which every Mac we run on has.
+
+#if defined(__AVX2__)
+    #define GROOVE_SIMD_AVX2
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define GROOVE_SIMD_NEON
+    #include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #define GROOVE_SIMD_SSE
+    #include <emmintrin.h>
+#endif
+
+#include <cmath>
+
+namespace simd {
+
+#if defined(GROOVE_SIMD_AVX2)
+
+    typedef __m256 vfloat;
+    static const int width = 8;
+    inline vfloat	load(const float* _p)						{ return _mm256_loadu_ps(_p); }
+    inline void		store(float* _p, vfloat _v)					{ _mm256_storeu_ps(_p, _v); }
+    inline vfloat	set1(float _v)								{ return _mm256_set1_ps(_v); }
+    inline vfloat	add(vfloat _a, vfloat _b)					{ return _mm256_add_ps(_a, _b); }
+    inline vfloat	sub(vfloat _a, vfloat _b)					{ return _mm256_sub_ps(_a, _b); }
+    inline vfloat	mul(vfloat _a, vfloat _b)					{ return _mm256_mul_ps(_a, _b); }
+    inline vfloat	div(vfloat _a, vfloat _b)					{ return _mm256_div_ps(_a, _b); }
+    inline vfloat	min(vfloat _a, vfloat _b)					{ return _mm256_min_ps(_a, _b); }
+    inline vfloat	max(vfloat _a, vfloat _b)					{ return _mm256_max_ps(_a, _b); }
+    inline vfloat	sqrt(vfloat _a)								{ return _mm256_sqrt_ps(_a); }
+    inline float	sum(vfloat _a) {
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(_a), _mm256_extractf128_ps(_a, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+    #if defined(__FMA__)
+    inline vfloat	madd(vfloat _a, vfloat _b, vfloat _c)		{ return _mm256_fmadd_ps(_a, _b, _c); }
+    inline vfloat	nmadd(vfloat _a, vfloat _b, vfloat _c)		{ return _mm256_fnmadd_ps(_a, _b, _c); }
+    #else
+    inline vfloat	madd(vfloat _a, vfloat _b, vfloat _c)		{ return _mm256_add_ps(_mm256_mul_ps(_a, _b), _c); }
+    inline vfloat	nmadd(vfloat _a, vfloat _b, vfloat _c)		{ return _mm256_sub_ps(_c, _mm256_mul_ps(_a, _b)); }
+    #endif
+
+#elif defined(GROOVE_SIMD_NEON)
+
+    typedef float32x4_t vfloat;
+    static const int width = 4;
+    inline vfloat	load(const float* _p)						{ return vld1q_f32(_p); }
+    inline void		store(float* _p, vfloat _v)					{ vst1q_f32(_p, _v); }
+    inline vfloat	set1(float _v)								{ return vdupq_n_f32(_v); }
+    inline vfloat	add(vfloat _a, vfloat _b)					{ return vaddq_f32(_a, _b); }
+    inline vfloat	sub(vfloat _a, vfloat _b)					{ return vsubq_f32(_a, _b); }
+    inline vfloat	mul(vfloat _a, vfloat _b)					{ return vmulq_f32(_a, _b); }
+    inline vfloat	min(vfloat _a, vfloat _b)					{ return vminq_f32(_a, _b); }
+    inline vfloat	max(vfloat _a, vfloat _b)					{ return vmaxq_f32(_a, _b); }
+    inline vfloat	madd(vfloat _a, vfloat _b, vfloat _c)		{ return vmlaq_f32(_c, _a, _b); }
+    inline vfloat	nmadd(vfloat _a, vfloat _b, vfloat _c)		{ return vmlsq_f32(_c, _a, _b); }
+    inline float	sum(vfloat _a) {
+        float32x2_t s = vadd_f32(vget_low_f32(_a), vget_high_f32(_a));
+        return vget_lane_f32(vpadd_f32(s, s), 0);
+    }
+    #if defined(__aarch64__)
+    inline vfloat	sqrt(vfloat _a)								{ return vsqrtq_f32(_a); }
+    inline vfloat	div(vfloat _a, vfloat _b)					{ return vdivq_f32(_a, _b); }
+    #else
+    inline vfloat	div(vfloat _a, vfloat _b) {
+        // two newton steps on the reciprocal estimate
+        float32x4_t r = vrecpeq_f32(_b);
+        r = vmulq_f32(r, vrecpsq_f32(_b, r));
+        r = vmulq_f32(r, vrecpsq_f32(_b, r));
+        return vmulq_f32(_a, r);
+    }
+    inline vfloat	sqrt(vfloat _a) {
+        // two newton steps on the reciprocal estimate, zero stays zero
+        float32x4_t e = vrsqrteq_f32(vmaxq_f32(_a, vdupq_n_f32(1e-30f)));
+        e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(_a, e), e));
+        e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(_a, e), e));
+        return vmulq_f32(_a, e);
+    }
+    #endif
+
+#elif defined(GROOVE_SIMD_SSE)
+
+    typedef __m128 vfloat;
+    static const int width = 4;
+    inline vfloat	load(const float* _p)						{ return _mm_loadu_ps(_p); }
+    inline void		store(float* _p, vfloat _v)					{ _mm_storeu_ps(_p, _v); }
+    inline vfloat	set1(float _v)								{ return _mm_set1_ps(_v); }
+    inline vfloat	add(vfloat _a, vfloat _b)					{ return _mm_add_ps(_a, _b); }
+    inline vfloat	sub(vfloat _a, vfloat _b)					{ return _mm_sub_ps(_a, _b); }
+    inline vfloat	mul(vfloat _a, vfloat _b)					{ return _mm_mul_ps(_a, _b); }
+    inline vfloat	div(vfloat _a, vfloat _b)					{ return _mm_div_ps(_a, _b); }
+    inline vfloat	min(vfloat _a, vfloat _b)					{ return _mm_min_ps(_a, _b); }
+    inline vfloat	max(vfloat _a, vfloat _b)					{ return _mm_max_ps(_a, _b); }
+    inline vfloat	sqrt(vfloat _a)								{ return _mm_sqrt_ps(_a); }
+    inline vfloat	madd(vfloat _a, vfloat _b, vfloat _c)		{ return _mm_add_ps(_mm_mul_ps(_a, _b), _c); }
+    inline vfloat	nmadd(vfloat _a, vfloat _b, vfloat _c)		{ return _mm_sub_ps(_c, _mm_mul_ps(_a, _b)); }
+    inline float	sum(vfloat _a) {
+        __m128 s = _mm_add_ps(_a, _mm_movehl_ps(_a, _a));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+
+#else
+
+    typedef float vfloat;
+    static const int width = 1;
+    inline vfloat	load(const float* _p)						{ return *_p; }
+    inline void		store(float* _p, vfloat _v)					{ *_p = _v; }
+    inline vfloat	set1(float _v)								{ return _v; }
+    inline vfloat	add(vfloat _a, vfloat _b)					{ return _a + _b; }
+    inline vfloat	sub(vfloat _a, vfloat _b)					{ return _a - _b; }
+    inline vfloat	mul(vfloat _a, vfloat _b)					{ return _a * _b; }
+    inline vfloat	div(vfloat _a, vfloat _b)					{ return _a / _b; }
+    inline vfloat	min(vfloat _a, vfloat _b)					{ return _a < _b ? _a : _b; }
+    inline vfloat	max(vfloat _a, vfloat _b)					{ return _a > _b ? _a : _b; }
+    inline vfloat	sqrt(vfloat _a)								{ return std::sqrt(_a); }
+    inline vfloat	madd(vfloat _a, vfloat _b, vfloat _c)		{ return _a * _b + _c; }
+    inline vfloat	nmadd(vfloat _a, vfloat _b, vfloat _c)		{ return _c - _a * _b; }
+    inline float	sum(vfloat _a)								{ return _a; }
+
+#endif
+
+    inline const char* getName() {
+#if defined(GROOVE_SIMD_AVX2)
+        return "avx2";
+#elif defined(GROOVE_SIMD_NEON)
+        return "neon";
+#elif defined(GROOVE_SIMD_SSE)
+        return "sse";
+#else
+        return "scalar";
+#endif
+    }
+}
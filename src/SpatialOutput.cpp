@@ -0,0 +1,78 @@
+#include "SpatialOutput.h"
+
+//--------------------------------------------------------------
+SpatialOutput::SpatialOutput() {
+    for (int s=0; s<Spatializer::maxSources; s++) {
+        azimuths[s] = 0;
+        distances[s] = 1;
+        gains[s] = 1;
+    }
+
+    parameters.setName("spatializer");
+    parameters.add(layout.set("layout", "stereo"));
+    parameters.add(speakers.set("speakers", 2, 1, Spatializer::maxSpeakers));
+}
+
+//--------------------------------------------------------------
+void SpatialOutput::setup(const string& _layoutPath, int _numSources, int _maxBlockSize) {
+    vector<float> layoutAzimuths;
+    if (loadLayout(_layoutPath, layoutAzimuths)) {
+        layout.set(ofFilePath::getFileName(_layoutPath));
+    }
+    else {
+        layoutAzimuths.clear();
+        layoutAzimuths.push_back(-30);
+        layoutAzimuths.push_back(30);
+        layout.set("stereo");
+    }
+    spatializer.setup(layoutAzimuths, _numSources, _maxBlockSize);
+    speakers.set(spatializer.getNumSpeakers());
+    ofLogNotice("SpatialOutput") << layout.get() << ", " << spatializer.getNumSpeakers() << " speakers, " << spatializer.getNumSources() << " sources";
+}
+
+//--------------------------------------------------------------
+bool SpatialOutput::loadLayout(const string& _layoutPath, vector<float>& _azimuths) {
+    ofXml xml;
+    if (!ofFile::doesFileExist(_layoutPath) || !xml.load(_layoutPath) || !xml.setTo("speakers"))
+        return false;
+    int count = min(xml.getNumChildren(), (int)Spatializer::maxSpeakers);
+    for (int i=0; i<count; i++) {
+        xml.setToChild(i);
+        if (xml.getName() == "speaker")
+            _azimuths.push_back(ofToFloat(xml.getAttribute("azimuth")));
+        xml.setToParent();
+    }
+    if (_azimuths.empty()) {
+        ofLogError("SpatialOutput") << "no speakers in " << _layoutPath;
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+void SpatialOutput::setSource(int _source, float _azimuth, float _distance, float _gain) {
+    if (_source < 0 || _source >= Spatializer::maxSources)
+        return;
+    azimuths[_source].store(_azimuth);
+    distances[_source].store(_distance);
+    gains[_source].store(_gain);
+}
+
+//--------------------------------------------------------------
+void SpatialOutput::setSource(int _source, const ofVec2f& _position, float _gain) {
+    float azimuth = atan2f(_position.x, -_position.y) * RAD_TO_DEG;
+    setSource(_source, azimuth, min(_position.length(), 1.0f), _gain);
+}
+
+//--------------------------------------------------------------
+float* const* SpatialOutput::begin(int _numFrames) {
+    for (int s=0; s<spatializer.getNumSources(); s++)
+        spatializer.setSource(s, azimuths[s].load(), distances[s].load(), gains[s].load());
+    spatializer.clear(_numFrames);
+    return spatializer.getSources();
+}
+
+//--------------------------------------------------------------
+void SpatialOutput::end(float* _output, int _numFrames, int _numChannels) {
+    spatializer.process(_output, _numFrames, _numChannels);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Spatializer.h"
+
+// The output stage for a speaker array: sound sources (the music, the
+// synth voices, the grain regions) render mono into their own buffers and
+// are placed on the speakers by a Spatializer. The layout is read from an
+// xml file, one speaker per output channel in order:
+//     <speakers>
+//         <speaker azimuth="-22.5"/>
+//         ...
+//     </speakers>
+// Without the file it is plain stereo at -30 and 30 degrees, and
+// isMultichannel() tells the caller to keep its usual stereo mix.
+// Source positions come from the render thread and are picked up once per
+// block.
+
+class SpatialOutput {
+public:
+    SpatialOutput();
+
+    void	setup(const string& _layoutPath, int _numSources, int _maxBlockSize = 1024);
+
+    ofParameterGroup	parameters;
+
+    int		getNumSpeakers() const		{ return spatializer.getNumSpeakers(); }
+    int		getMaxBlockSize() const		{ return spatializer.getMaxBlockSize(); }
+    bool	isMultichannel() const		{ return getNumSpeakers() > 2; }
+
+    // render thread; degrees clockwise from the front, the distance from the
+    // middle of the ring 0 .. 1
+    void	setSource(int _source, float _azimuth, float _distance = 1, float _gain = 1);
+    // or a point on the floor, -1 .. 1 both ways with the front at y = -1
+    void	setSource(int _source, const ofVec2f& _position, float _gain = 1);
+
+    // audio thread, at most getMaxBlockSize() frames: the cleared source
+    // buffers to fill, then the mix added into _output
+    float* const*	begin(int _numFrames);
+    void	end(float* _output, int _numFrames, int _numChannels);
+
+protected:
+    bool	loadLayout(const string& _layoutPath, vector<float>& _azimuths);
+
+    ofParameter<string>	layout;
+    ofParameter<int>	speakers;
+
+    Spatializer			spatializer;
+    std::atomic<float>	azimuths[Spatializer::maxSources];
+    std::atomic<float>	distances[Spatializer::maxSources];
+    std::atomic<float>	gains[Spatializer::maxSources];
+};
@@ -0,0 +1,159 @@
+#include "Spatializer.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const float degrees = 0.0174532925f;
+}
+
+//--------------------------------------------------------------
+Spatializer::Spatializer() {
+    numSpeakers = 0;
+    numSources = 0;
+    maxBlockSize = 0;
+    stride = 0;
+    for (int s=0; s<maxSources; s++)
+        sourcePointers[s] = NULL;
+}
+
+//--------------------------------------------------------------
+void Spatializer::setup(const std::vector<float>& _speakerAzimuths, int _numSources, int _maxBlockSize) {
+    numSpeakers = std::min((int)_speakerAzimuths.size(), (int)maxSpeakers);
+    numSources = std::min(_numSources, (int)maxSources);
+    maxBlockSize = _maxBlockSize;
+
+    // walk the ring in order, remembering which channel each speaker is on
+    std::vector<std::pair<float, int> > order;
+    for (int s=0; s<numSpeakers; s++) {
+        float azimuth = fmodf(_speakerAzimuths[s], 360.0f);
+        order.push_back(std::make_pair(azimuth < 0 ? azimuth + 360 : azimuth, s));
+    }
+    std::sort(order.begin(), order.end());
+    for (int s=0; s<numSpeakers; s++) {
+        speakerX[s] = sinf(order[s].first * degrees);
+        speakerY[s] = cosf(order[s].first * degrees);
+        speakerChannel[s] = order[s].second;
+    }
+
+    stride = (maxBlockSize + simd::width - 1) / simd::width * simd::width;
+    sourceData.assign(numSources * stride, 0);
+    for (int s=0; s<numSources; s++)
+        sourcePointers[s] = sourceData.data() + s * stride;
+    speakerData.assign(numSpeakers * stride, 0);
+    ramp.resize(stride);
+    for (int i=0; i<stride; i++)
+        ramp[i] = i;
+
+    for (int s=0; s<numSources; s++) {
+        setSource(s, 0);
+        std::copy(targets[s], targets[s] + numSpeakers, gains[s]);
+    }
+}
+
+//--------------------------------------------------------------
+void Spatializer::computeGains(float _azimuth, float _distance, float* _gains) const {
+    std::fill(_gains, _gains + numSpeakers, 0.0f);
+    if (numSpeakers == 0)
+        return;
+    float x = sinf(_azimuth * degrees);
+    float y = cosf(_azimuth * degrees);
+
+    // the pair the direction falls between: non negative gains in the
+    // base of two neighbours less than half the ring apart (clockwise, so
+    // their determinant is negative)
+    float pair[maxSpeakers] = { 0 };
+    bool found = false;
+    for (int a=0; a<numSpeakers && !found && numSpeakers > 1; a++) {
+        int b = (a + 1) % numSpeakers;
+        float det = speakerX[a] * speakerY[b] - speakerY[a] * speakerX[b];
+        if (fabsf(det) < 1e-4f)
+            continue;
+        float ga = (x * speakerY[b] - y * speakerX[b]) / det;
+        float gb = (speakerX[a] * y - speakerY[a] * x) / det;
+        if (ga >= -1e-4f && gb >= -1e-4f && det < 0) {
+            float norm = 1.0f / sqrtf(ga * ga + gb * gb);
+            pair[a] = std::max(ga, 0.0f) * norm;
+            pair[b] = std::max(gb, 0.0f) * norm;
+            found = true;
+        }
+    }
+    if (!found) {
+        // a gap of half the ring or more, or a single speaker: the nearest one
+        int nearest = 0;
+        for (int s=1; s<numSpeakers; s++)
+            if (x * speakerX[s] + y * speakerY[s] > x * speakerX[nearest] + y * speakerY[nearest])
+                nearest = s;
+        pair[nearest] = 1;
+    }
+
+    // towards the middle, fade to the same level everywhere at constant power
+    float d = std::max(0.0f, std::min(1.0f, _distance));
+    float uniform = (1 - d) / sqrtf((float)numSpeakers);
+    float power = 0;
+    float blend[maxSpeakers];
+    for (int s=0; s<numSpeakers; s++) {
+        blend[s] = d * pair[s] + uniform;
+        power += blend[s] * blend[s];
+    }
+    float norm = power > 0 ? 1.0f / sqrtf(power) : 0.0f;
+    for (int s=0; s<numSpeakers; s++)
+        _gains[speakerChannel[s]] = blend[s] * norm;
+}
+
+//--------------------------------------------------------------
+void Spatializer::setSource(int _source, float _azimuth, float _distance, float _gain) {
+    if (_source < 0 || _source >= numSources)
+        return;
+    computeGains(_azimuth, _distance, targets[_source]);
+    for (int s=0; s<numSpeakers; s++)
+        targets[_source][s] *= _gain;
+}
+
+//--------------------------------------------------------------
+void Spatializer::clear(int _numFrames) {
+    int n = std::min(_numFrames, maxBlockSize);
+    for (int s=0; s<numSources; s++)
+        std::fill(sourcePointers[s], sourcePointers[s] + n, 0.0f);
+}
+
+//--------------------------------------------------------------
+void Spatializer::process(float* _output, int _numFrames, int _numChannels) {
+    int n = std::min(_numFrames, maxBlockSize);
+    if (n <= 0)
+        return;
+    for (int c=0; c<numSpeakers; c++)
+        std::fill(speakerData.begin() + c * stride, speakerData.begin() + c * stride + n, 0.0f);
+
+    for (int s=0; s<numSources; s++) {
+        const float* src = sourcePointers[s];
+        for (int c=0; c<numSpeakers; c++) {
+            float g0 = gains[s][c];
+            float g1 = targets[s][c];
+            gains[s][c] = g1;
+            if (g0 == 0 && g1 == 0)
+                continue;
+
+            float* dst = speakerData.data() + c * stride;
+            simd::vfloat start = simd::set1(g0);
+            simd::vfloat step = simd::set1((g1 - g0) / n);
+            int i = 0;
+            for (; i+simd::width<=n; i+=simd::width) {
+                simd::vfloat g = simd::madd(step, simd::load(&ramp[i]), start);
+                simd::store(dst + i, simd::madd(simd::load(src + i), g, simd::load(dst + i)));
+            }
+            for (; i<n; i++)
+                dst[i] += src[i] * (g0 + (g1 - g0) * i / n);
+        }
+    }
+
+    // speakers past the device's channels are dropped
+    int channels = std::min(numSpeakers, _numChannels);
+    for (int c=0; c<channels; c++) {
+        const float* src = speakerData.data() + c * stride;
+        float* dst = _output + c;
+        for (int i=0; i<n; i++, dst+=_numChannels)
+            *dst += src[i];
+    }
+}
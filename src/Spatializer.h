@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+// Places mono sources on a ring of speakers with 2D vector base amplitude
+// panning (VBAP): a source between two neighbouring speakers plays from
+// those two only, with gains found by solving for its direction in the
+// pair's base and normalized to constant power. Moving a source in towards
+// the middle (distance < 1) blends in every speaker equally so it is heard
+// from all around. Azimuths are in degrees, 0 in front, clockwise.
+// The sources x speakers gain matrix is recomputed once per block and each
+// entry ramps linearly to its new value over the block; pairs that are
+// silent on both ends are skipped and the mix is vectorized.
+// Audio thread only, no allocation after setup(), no openFrameworks.
+
+class Spatializer {
+public:
+    static const int	maxSources = 64;
+    static const int	maxSpeakers = 32;
+
+    Spatializer();
+
+    void	setup(const std::vector<float>& _speakerAzimuths, int _numSources, int _maxBlockSize);
+
+    int		getNumSpeakers() const		{ return numSpeakers; }
+    int		getNumSources() const		{ return numSources; }
+    int		getMaxBlockSize() const		{ return maxBlockSize; }
+
+    // where a source is heard from the next block on
+    void	setSource(int _source, float _azimuth, float _distance = 1, float _gain = 1);
+    // the speaker gains for a direction, getNumSpeakers() of them
+    void	computeGains(float _azimuth, float _distance, float* _gains) const;
+
+    // one mono buffer per source, to be filled after clear()
+    float* const*	getSources() const	{ return sourcePointers; }
+    void	clear(int _numFrames);
+    // adds the sources, panned, into _output; speaker s on channel s
+    void	process(float* _output, int _numFrames, int _numChannels);
+
+private:
+    int					numSpeakers;
+    int					numSources;
+    int					maxBlockSize;
+    int					stride;				// padded block size
+    float				speakerX[maxSpeakers];	// unit vectors, sorted by azimuth
+    float				speakerY[maxSpeakers];
+    int					speakerChannel[maxSpeakers];
+
+    float				gains[maxSources][maxSpeakers];		// at the end of the last block
+    float				targets[maxSources][maxSpeakers];
+
+    std::vector<float>	sourceData;
+    float*				sourcePointers[maxSources];
+    std::vector<float>	speakerData;		// planar mix before interleaving
+    std::vector<float>	ramp;				// 0, 1, 2, ... for the vector gain ramps
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// Single-producer / single-consumer ring buffer.
+// One thread may push, one (other) thread may pop; neither side ever blocks
+// or allocates once setup() has been called. Capacity is rounded up to a
+// power of two so the read and write counters can wrap freely.
+
+template <typename T>
+class SpscRing {
+public:
+    SpscRing() : mask(0), writeIndex(0), readIndex(0) { }
+
+    void	setup(size_t _capacity) {
+        size_t capacity = 1;
+        while (capacity < _capacity)
+            capacity <<= 1;
+        buffer.assign(capacity, T());
+        mask = capacity - 1;
+        writeIndex.store(0, std::memory_order_relaxed);
+        readIndex.store(0, std::memory_order_relaxed);
+    }
+
+    size_t	capacity() const	{ return buffer.size(); }
+    size_t	size() const		{ return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire); }
+    bool	empty() const		{ return size() == 0; }
+
+    // producer side
+    bool push(const T& _value) {
+        size_t w = writeIndex.load(std::memory_order_relaxed);
+        if (w - readIndex.load(std::memory_order_acquire) >= buffer.size())
+            return false;
+        buffer[w & mask] = _value;
+        writeIndex.store(w + 1, std::memory_order_release);
+        return true;
+    }
+
+    // writes as many of _count values as fit, returns the number written
+    size_t write(const T* _values, size_t _count) {
+        size_t w = writeIndex.load(std::memory_order_relaxed);
+        size_t space = buffer.size() - (w - readIndex.load(std::memory_order_acquire));
+        if (_count > space)
+            _count = space;
+        for (size_t i=0; i<_count; i++)
+            buffer[(w + i) & mask] = _values[i];
+        writeIndex.store(w + _count, std::memory_order_release);
+        return _count;
+    }
+
+    // consumer side
+    bool pop(T& _value) {
+        size_t r = readIndex.load(std::memory_order_relaxed);
+        if (r == writeIndex.load(std::memory_order_acquire))
+            return false;
+        _value = buffer[r & mask];
+        readIndex.store(r + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t read(T* _values, size_t _count) {
+        size_t r = readIndex.load(std::memory_order_relaxed);
+        size_t available = writeIndex.load(std::memory_order_acquire) - r;
+        if (_count > available)
+            _count = available;
+        for (size_t i=0; i<_count; i++)
+            _values[i] = buffer[(r + i) & mask];
+        readIndex.store(r + _count, std::memory_order_release);
+        return _count;
+    }
+
+    // drops up to _count of the oldest values, returns the number dropped
+    size_t discard(size_t _count) {
+        size_t r = readIndex.load(std::memory_order_relaxed);
+        size_t available = writeIndex.load(std::memory_order_acquire) - r;
+        if (_count > available)
+            _count = available;
+        readIndex.store(r + _count, std::memory_order_release);
+        return _count;
+    }
+
+    // drops everything currently queued, consumer side only
+    void clear() { readIndex.store(writeIndex.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+    std::vector<T>		buffer;
+    size_t				mask;
+
+    // keep the two counters on separate cache lines so the producer and the
+    // consumer don't invalidate each other on every push / pop
+    char				padding0[64];
+    std::atomic<size_t>	writeIndex;
+    char				padding1[64];
+    std::atomic<size_t>	readIndex;
+    char				padding2[64];
+};
@@ -0,0 +1,92 @@
+#include "SteadyDepth.h"
+
+//--------------------------------------------------------------
+SteadyDepth::SteadyDepth() {
+    flowOff = -1;
+    flowOn = -1;
+    skipFlows = 0;
+
+    parameters.setName("depth filter");
+    parameters.add(enabled.set("enabled", true));
+    parameters.add(gate.set("gate mm", 30, 5, 200));
+    parameters.add(smoothing.set("smoothing", 0.7, 0, 0.95));
+    parameters.add(holdFrames.set("hold frames", 2, 0, 10));
+    parameters.add(roomFlow.set("room flow", 0, 0, 10));
+    parameters.add(flowRemoved.set("flow removed", 0, 0, 1));
+    parameters.add(filterMs.set("filter ms", 0, 0, 10));
+    enabled.addListener(this, &SteadyDepth::setEnabled);
+}
+
+//--------------------------------------------------------------
+void SteadyDepth::setup(int _width, int _height) {
+    filter.setup(_width, _height);
+    pixels.allocate(_width, _height, 1);
+    pixels.set(0);
+}
+
+//--------------------------------------------------------------
+void SteadyDepth::setEnabled(bool& _value) {
+    // start again from the next frame rather than from a stale one, and
+    // measure this setting afresh once the flow read back has caught up
+    filter.reset();
+    if (_value)
+        flowOn = -1;
+    else
+        flowOff = -1;
+    skipFlows = 3;
+}
+
+//--------------------------------------------------------------
+const ofShortPixels& SteadyDepth::update(const ofShortPixels& _rawDepth) {
+    if (!enabled || (int)_rawDepth.getWidth() != filter.getWidth() || (int)_rawDepth.getHeight() != filter.getHeight())
+        return _rawDepth;
+
+    uint64_t start = ofGetElapsedTimeMicros();
+    filter.setGate(gate);
+    filter.setSmoothing(smoothing);
+    filter.setHoldFrames(holdFrames);
+    filter.process(_rawDepth.getData(), pixels.getData());
+    filterMs.set((ofGetElapsedTimeMicros() - start) / 1000.0f);
+    return pixels;
+}
+
+//--------------------------------------------------------------
+void SteadyDepth::measureFlow(const float* _flow, int _width, int _height, const ofPixels& _mask) {
+    if (skipFlows > 0) {
+        skipFlows--;
+        return;
+    }
+
+    // a cell counts as room only if none of the mask under it is a dancer
+    int maskWidth = _mask.getWidth();
+    int maskHeight = _mask.getHeight();
+    const unsigned char* mask = _mask.getData();
+    double sum = 0;
+    int cells = 0;
+    for (int y=0; y<_height; y++) {
+        int my0 = y * maskHeight / _height;
+        int my1 = max((y + 1) * maskHeight / _height, my0 + 1);
+        for (int x=0; x<_width; x++) {
+            int mx0 = x * maskWidth / _width;
+            int mx1 = max((x + 1) * maskWidth / _width, mx0 + 1);
+            bool room = true;
+            for (int my=my0; my<my1 && room; my++)
+                for (int mx=mx0; mx<mx1 && room; mx++)
+                    room = mask[my * maskWidth + mx] == 0;
+            if (!room)
+                continue;
+            const float* v = _flow + (y * _width + x) * 2;
+            sum += v[0] * v[0] + v[1] * v[1];
+            cells++;
+        }
+    }
+    if (cells == 0)
+        return;
+
+    float energy = sum / cells;
+    float& smoothed = enabled ? flowOn : flowOff;
+    smoothed = smoothed < 0 ? energy : smoothed + (energy - smoothed) * 0.05f;
+    roomFlow.set(smoothed);
+    if (flowOn >= 0 && flowOff > 0)
+        flowRemoved.set(ofClamp(1 - flowOn / flowOff, 0, 1));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ofMain.h"
+#include "DepthFilter.h"
+
+// The source's depth steadied over time with a DepthFilter, for the optical
+// flow: the shimmer and the flickering edges it would read as motion are
+// taken out, a dancer's movement passes. What the filter is for is measured
+// on the flow itself: "room flow" is the mean squared speed of the optical
+// flow over the room, where the foreground mask has no dancer and any flow
+// is spurious, averaged over about a second. It is kept for the filter on
+// and off alike, and "flow removed" is the share of the unfiltered room
+// flow that is gone with the filter on; switch the filter off for a few
+// seconds and back on to measure it. Render thread only.
+
+class SteadyDepth {
+public:
+    SteadyDepth();
+
+    void	setup(int _width, int _height);
+    // the filtered frame, or _rawDepth itself while the filter is off
+    const ofShortPixels&	update(const ofShortPixels& _rawDepth);
+    void	reset()							{ filter.reset(); }
+    // the optical flow made from the last frame, read back x, y per cell as
+    // FluidReadback leaves it, and the foreground mask of the frame
+    void	measureFlow(const float* _flow, int _width, int _height, const ofPixels& _mask);
+
+    ofParameterGroup	parameters;
+
+protected:
+    ofParameter<bool>	enabled;
+    ofParameter<float>	gate;			// mm at 2 m
+    ofParameter<float>	smoothing;
+    ofParameter<int>	holdFrames;
+    ofParameter<float>	roomFlow;		// readouts
+    ofParameter<float>	flowRemoved;
+    ofParameter<float>	filterMs;
+    void	setEnabled(bool& _value);
+
+    DepthFilter		filter;
+    ofShortPixels	pixels;
+    float			flowOff;		// room flow smoothed over frames, -1 until measured
+    float			flowOn;
+    int				skipFlows;		// still made before the filter was switched
+};
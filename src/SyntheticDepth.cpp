@@ -0,0 +1,143 @@
+#include "SyntheticDepth.h"
+
+//--------------------------------------------------------------
+SyntheticDepth::SyntheticDepth() {
+    bandRows = 16;
+    generation = 0;
+    numBusy = 0;
+    quitting = false;
+    target = NULL;
+    nextBand = 0;
+    threadBodies = 6;
+    threadFrameRate = 30;
+    threadNoise = 3;
+    threadGenerateMs = 0;
+
+    parameters.setName("synthetic depth");
+    parameters.add(numBodies.set("bodies", 6, 0, CapsuleBodies::maxBodies));
+    parameters.add(frameRate.set("frame rate", 30, 1, 120));
+    parameters.add(noise.set("noise mm", 3, 0, 50));
+    parameters.add(generateMs.set("generate ms", 0, 0, 50));
+    numBodies.addListener(this, &SyntheticDepth::setBodies);
+    frameRate.addListener(this, &SyntheticDepth::setFrameRate);
+    noise.addListener(this, &SyntheticDepth::setNoise);
+}
+
+//--------------------------------------------------------------
+SyntheticDepth::~SyntheticDepth() {
+    close();
+}
+
+//--------------------------------------------------------------
+void SyntheticDepth::setup(int _width, int _height, float _frameRate, int _numThreads) {
+    close();
+    bodies.setup(_width, _height);
+    frameRate.set(_frameRate);
+
+    int numThreads = _numThreads > 0 ? _numThreads : max(1, (int)std::thread::hardware_concurrency());
+    scratch.assign(numThreads, std::vector<float>(bodies.getScratchSize()));
+    quitting = false;
+    for (int i=0; i<numThreads - 1; i++)
+        workers.push_back(std::thread(&SyntheticDepth::work, this, i));
+
+    ofLogNotice("SyntheticDepth") << _width << "x" << _height << " at " << _frameRate << " fps on " << numThreads << " threads";
+    startThread();
+}
+
+//--------------------------------------------------------------
+void SyntheticDepth::close() {
+    if (isThreadRunning())
+        waitForThread(true);
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        quitting = true;
+    }
+    poolStart.notify_all();
+    for (size_t i=0; i<workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+}
+
+//--------------------------------------------------------------
+bool SyntheticDepth::update() {
+    generateMs.set(threadGenerateMs.load());
+    return DepthSource::update();
+}
+
+//--------------------------------------------------------------
+void SyntheticDepth::renderBands(int _worker) {
+    float* rows = scratch[_worker].data();
+    int numBands = (bodies.getHeight() + bandRows - 1) / bandRows;
+    for (int band=nextBand++; band<numBands; band=nextBand++)
+        bodies.renderRows(band * bandRows, min((band + 1) * bandRows, bodies.getHeight()), target, rows);
+}
+
+//--------------------------------------------------------------
+void SyntheticDepth::work(int _worker) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            poolStart.wait(lock, [&] { return quitting || generation != seen; });
+            if (quitting)
+                return;
+            seen = generation;
+        }
+        renderBands(_worker);
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            numBusy--;
+        }
+        poolDone.notify_one();
+    }
+}
+
+//--------------------------------------------------------------
+void SyntheticDepth::render(uint16_t* _depth, bool _pooled) {
+    if (!_pooled) {
+        target = _depth;
+        nextBand = 0;
+        renderBands(scratch.size() - 1);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        target = _depth;
+        nextBand = 0;
+        numBusy = workers.size();
+        generation++;
+    }
+    poolStart.notify_all();
+    // the source thread takes bands too, then waits for the stragglers
+    renderBands(scratch.size() - 1);
+    std::unique_lock<std::mutex> lock(poolMutex);
+    poolDone.wait(lock, [&] { return numBusy == 0; });
+}
+
+//--------------------------------------------------------------
+void SyntheticDepth::threadedFunction() {
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+    uint64_t due = startMicros;
+
+    while (isThreadRunning()) {
+        uint64_t now = ofGetElapsedTimeMicros();
+        if (now < due) {
+            sleep(min<uint64_t>((due - now) / 1000, 10));
+            continue;
+        }
+        // a frame late is a frame late, don't try to catch up
+        uint64_t period = 1000000 / max(1.0f, threadFrameRate.load());
+        due = max(due + period, now);
+
+        bodies.setNoise(threadNoise.load());
+        int numBodies = threadBodies.load();
+        bodies.animate((now - startMicros) / 1000000.0, numBodies);
+        DepthFrame& back = getBackFrame();
+        back.rawDepth.allocate(bodies.getWidth(), bodies.getHeight(), 1);
+        // the empty room alone is cheap, not worth waking the pool for
+        render(back.rawDepth.getData(), numBodies > 0);
+        back.capturedMicros = now;
+        threadGenerateMs.store((ofGetElapsedTimeMicros() - now) / 1000.0f);
+        publish();
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ofMain.h"
+#include "DepthSource.h"
+#include "CapsuleBodies.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// A depth camera made up of CapsuleBodies, as a DepthSource in place of the
+// Kinect, for load testing the flow, mask and fluid stages at sizes and rates
+// the Kinect can't do. The source thread paces the frames; each frame is
+// posed once and its rows are then drawn in bands by a pool of workers, the
+// source thread being one of them, straight into the triple buffer's back
+// slot. With "bodies" at 0 only the background is drawn, by the source
+// thread alone, and the pool stays asleep.
+
+class SyntheticDepth : public DepthSource {
+public:
+    SyntheticDepth();
+    ~SyntheticDepth();
+
+    // _numThreads 0 uses every core
+    void	setup(int _width, int _height, float _frameRate, int _numThreads = 0);
+    void	close();
+
+    int		getWidth() const		{ return bodies.getWidth(); }
+    int		getHeight() const		{ return bodies.getHeight(); }
+
+    // render thread, also publishes the generation time to the gui
+    bool	update();
+
+protected:
+    void	threadedFunction();
+    // _pooled false draws every band on the source thread
+    void	render(uint16_t* _depth, bool _pooled);
+    void	work(int _worker);
+    void	renderBands(int _worker);
+
+    ofParameter<int>	numBodies;
+    ofParameter<float>	frameRate;
+    ofParameter<float>	noise;
+    ofParameter<float>	generateMs;		// readout
+
+    CapsuleBodies		bodies;
+    int					bandRows;
+
+    // the pool; a frame is handed out by bumping the generation
+    std::vector<std::thread>		workers;
+    std::vector<std::vector<float> >	scratch;	// one per worker, the source thread's last
+    std::mutex				poolMutex;
+    std::condition_variable	poolStart;
+    std::condition_variable	poolDone;
+    uint64_t				generation;
+    int						numBusy;
+    bool					quitting;
+    uint16_t*				target;
+    std::atomic<int>		nextBand;
+
+    std::atomic<int>		threadBodies;
+    std::atomic<float>		threadFrameRate;
+    std::atomic<float>		threadNoise;
+    std::atomic<float>		threadGenerateMs;
+    void					setBodies(int& _value)		{ threadBodies.store(_value); }
+    void					setFrameRate(float& _value)	{ threadFrameRate.store(_value); }
+    void					setNoise(float& _value)		{ threadNoise.store(_value); }
+};
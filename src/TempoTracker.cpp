@@ -0,0 +1,183 @@
+#include "TempoTracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+//--------------------------------------------------------------
+TempoTracker::TempoTracker() {
+    tempoSmoothing = 2.0;
+    phaseCorrection = 0.5;
+
+    hopDuration = 0;
+    minLag = 0;
+    maxLag = 0;
+    estimateInterval = 1;
+    historySize = 0;
+    lagsPerHop = 1;
+    reset();
+}
+
+//--------------------------------------------------------------
+void TempoTracker::setup(float _hopDuration, float _minBpm, float _maxBpm) {
+    hopDuration = _hopDuration;
+
+    // six seconds of novelty, enough for a few bars at the slowest tempo
+    historySize = std::max(64, (int)(6.0f / hopDuration));
+    history.assign(historySize, 0);
+    centered.assign(historySize, 0);
+
+    minLag = std::max(1, (int)floorf(60.0f / _maxBpm / hopDuration));
+    maxLag = std::min(historySize / 3, (int)ceilf(60.0f / _minBpm / hopDuration));
+    correlation.assign(maxLag + 2, 0);
+    rawCorrelation.assign(maxLag + 2, 0);
+
+    // ten estimates a second, the lags are spread over all but the last of
+    // the hops in between
+    estimateInterval = std::max(1, (int)(0.1f / hopDuration));
+    int numLags = maxLag + 3 - std::max(1, minLag - 1);
+    lagsPerHop = (numLags + std::max(1, estimateInterval - 1) - 1) / std::max(1, estimateInterval - 1);
+    reset();
+}
+
+//--------------------------------------------------------------
+void TempoTracker::reset() {
+    std::fill(history.begin(), history.end(), 0.0f);
+    historyIndex = 0;
+    historyCount = 0;
+    hopsUntilEstimate = estimateInterval;
+    estimating = false;
+    estimateCount = 0;
+    estimateAge = 0;
+    estimateEnergy = 0;
+    nextLag = 0;
+    bpm = 120;
+    targetBpm = 120;
+    phase = 0;
+    targetPhaseError = 0;
+    confidence = 0;
+}
+
+//--------------------------------------------------------------
+bool TempoTracker::process(float _novelty) {
+    history[historyIndex] = _novelty;
+    historyIndex = (historyIndex + 1) % historySize;
+    historyCount = std::min(historyCount + 1, historySize);
+
+    if (estimating) {
+        estimateAge++;
+        if (correlate(lagsPerHop))
+            finishEstimate();
+    }
+    if (--hopsUntilEstimate <= 0) {
+        hopsUntilEstimate = estimateInterval;
+        if (!estimating && historyCount >= historySize / 2)
+            beginEstimate();
+    }
+
+    bpm += (targetBpm - bpm) * (1.0f - expf(-hopDuration / tempoSmoothing));
+
+    // spread the phase correction over the hops until the next estimate
+    phase += hopDuration * bpm / 60.0f - targetPhaseError / estimateInterval;
+    if (phase < 0)
+        phase += 1;
+    if (phase >= 1) {
+        phase -= 1;
+        return true;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+void TempoTracker::beginEstimate() {
+    // snapshot the history newest first with the mean removed, the
+    // correlation then runs on the snapshot over the next few hops
+    estimateCount = historyCount;
+    float mean = 0;
+    for (int i=0; i<estimateCount; i++)
+        mean += history[i];
+    mean /= estimateCount;
+    for (int age=0; age<estimateCount; age++)
+        centered[age] = getHistory(age) - mean;
+
+    estimateEnergy = 0;
+    for (int i=0; i<estimateCount; i++)
+        estimateEnergy += centered[i] * centered[i];
+    estimateEnergy /= estimateCount;
+
+    estimating = true;
+    estimateAge = 0;
+    nextLag = std::max(1, minLag - 1);
+}
+
+//--------------------------------------------------------------
+bool TempoTracker::correlate(int _numLags) {
+    // autocorrelation, weighted by a log gaussian around 120 bpm so half and
+    // double tempo only win when they are clearly stronger
+    int lastLag = std::min(maxLag + 1, nextLag + _numLags - 1);
+    for (int lag=nextLag; lag<=lastLag; lag++) {
+        float r = 0;
+        const float* a = centered.data();
+        const float* b = centered.data() + lag;
+        int n = estimateCount - lag;
+        for (int i=0; i<n; i++)
+            r += a[i] * b[i];
+        r /= n;
+        float octaves = log2f(60.0f / (lag * hopDuration) / 120.0f);
+        correlation[lag] = r * expf(-0.5f * octaves * octaves);
+        rawCorrelation[lag] = r;
+    }
+    nextLag = lastLag + 1;
+    return nextLag > maxLag + 1;
+}
+
+//--------------------------------------------------------------
+void TempoTracker::finishEstimate() {
+    estimating = false;
+    if (estimateEnergy <= 0) {
+        confidence = 0;
+        targetPhaseError = 0;
+        return;
+    }
+
+    int bestLag = minLag;
+    for (int lag=minLag; lag<=maxLag; lag++)
+        if (correlation[lag] > correlation[bestLag])
+            bestLag = lag;
+    confidence = std::max(0.0f, std::min(1.0f, rawCorrelation[bestLag] / estimateEnergy));
+
+    // refine the lag between hops
+    float period = bestLag;
+    if (bestLag > 1) {
+        float l = correlation[bestLag - 1];
+        float c = correlation[bestLag];
+        float r = correlation[bestLag + 1];
+        float denominator = l - 2 * c + r;
+        if (denominator < 0)
+            period += std::max(-0.5f, std::min(0.5f, 0.5f * (l - r) / denominator));
+    }
+    targetBpm = 60.0f / (period * hopDuration);
+
+    // how long before the snapshot was the last beat: the offset where a
+    // pulse train with that period lines up best with the last four beats
+    int beats = 4;
+    int numOffsets = (int)period;
+    if (numOffsets + (beats - 1) * period >= estimateCount) {
+        targetPhaseError = 0;
+        return;
+    }
+    int bestOffset = 0;
+    float bestScore = -1e30f;
+    for (int offset=0; offset<numOffsets; offset++) {
+        float score = 0;
+        for (int k=0; k<beats; k++)
+            score += centered[offset + (int)(k * period + 0.5f)];
+        if (score > bestScore) {
+            bestScore = score;
+            bestOffset = offset;
+        }
+    }
+
+    float error = phase - (bestOffset + estimateAge) / period;
+    error -= floorf(error + 0.5f);
+    targetPhaseError = confidence > 0.05f ? phaseCorrection * error : 0;
+}
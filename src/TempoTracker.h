@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+// Streaming tempo and beat tracking from an onset novelty curve, one call per
+// hop. Ten times a second the tempo is re-estimated from the autocorrelation
+// of the last few seconds of novelty, weighted towards 120 BPM, and the beat
+// phase by matching a pulse train at that tempo against the same history.
+// The autocorrelation is spread over the hops between estimates so no single
+// hop pays for all of it. A phase oscillator runs in between and is pulled
+// towards the estimates, so the phase is continuous and a beat is flagged
+// exactly when it wraps. No allocation after setup(), no openFrameworks.
+
+class TempoTracker {
+public:
+    TempoTracker();
+
+    void	setup(float _hopDuration, float _minBpm = 60, float _maxBpm = 200);
+    void	reset();
+
+    // returns true on the hop a beat falls on
+    bool	process(float _novelty);
+
+    float	getBpm() const			{ return bpm; }
+    float	getBeatPhase() const	{ return phase; }		// 0 on the beat, rising to 1 just before the next
+    float	getConfidence() const	{ return confidence; }	// 0..1, how periodic the recent novelty is
+
+    float	tempoSmoothing;		// seconds for the bpm to follow a new estimate
+    float	phaseCorrection;	// fraction of the phase error corrected per estimate
+
+private:
+    void	beginEstimate();
+    bool	correlate(int _numLags);
+    void	finishEstimate();
+    float	getHistory(int _age) const { return history[(historyIndex - 1 - _age + historySize) % historySize]; }
+
+    float				hopDuration;
+    int					minLag;
+    int					maxLag;
+    int					estimateInterval;
+
+    std::vector<float>	history;		// novelty ring, mean removed at estimate time
+    std::vector<float>	centered;
+    std::vector<float>	correlation;		// weighted towards 120 bpm
+    std::vector<float>	rawCorrelation;
+    int					historySize;
+    int					historyIndex;
+    int					historyCount;
+    int					hopsUntilEstimate;
+
+    // estimate in progress
+    bool				estimating;
+    int					estimateCount;
+    int					estimateAge;		// hops since the history was snapshot
+    float				estimateEnergy;
+    int					nextLag;
+    int					lagsPerHop;
+
+    float				bpm;
+    float				targetBpm;
+    float				phase;
+    float				targetPhaseError;
+    float				confidence;
+};
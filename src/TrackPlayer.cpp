@@ -0,0 +1,105 @@
+#include "TrackPlayer.h"
+
+//--------------------------------------------------------------
+TrackPlayer::TrackPlayer() {
+    track = NULL;
+    rateRatio = 1;
+    playing = false;
+    looping = false;
+    position = 0;
+    callbackVolume = 1.0f;
+    callbackUnderruns = 0;
+
+    parameters.setName("track player");
+    parameters.add(volume.set("volume", 1.0, 0.0, 2.0));
+    parameters.add(underruns.set("underruns", 0, 0, 1000000));
+    volume.addListener(this, &TrackPlayer::setVolume);
+}
+
+//--------------------------------------------------------------
+void TrackPlayer::setup(const PcmTrack& _track, int _outputSampleRate) {
+    track = &_track;
+    rateRatio = track->getSampleRate() > 0 ? (float)track->getSampleRate() / _outputSampleRate : 1.0f;
+    position = 0;
+}
+
+//--------------------------------------------------------------
+double TrackPlayer::getPosition() const {
+    if (track == NULL || track->getSampleRate() <= 0)
+        return 0;
+    return position.load() / track->getSampleRate();
+}
+
+//--------------------------------------------------------------
+double TrackPlayer::getDuration() const {
+    if (track == NULL || track->getSampleRate() <= 0)
+        return 0;
+    return (double)track->getNumFrames() / track->getSampleRate();
+}
+
+//--------------------------------------------------------------
+void TrackPlayer::update() {
+    underruns.set(callbackUnderruns.load());
+}
+
+//--------------------------------------------------------------
+void TrackPlayer::render(float* _output, int _numFrames, int _numChannels) {
+    play(_output, _numChannels, NULL, NULL, _numFrames);
+}
+
+//--------------------------------------------------------------
+void TrackPlayer::renderSources(float* const* _sources, int _numSources, int _numFrames) {
+    if (_numSources > 0)
+        play(NULL, 0, _sources[0], _sources[min(1, _numSources - 1)], _numFrames);
+}
+
+//--------------------------------------------------------------
+void TrackPlayer::play(float* _output, int _numChannels, float* _left, float* _right, int _numFrames) {
+    if (track == NULL || !track->isLoaded() || !playing.load())
+        return;
+
+    const float* samples = track->getSamples();
+    int channels = track->getNumChannels();
+    int64_t length = track->getNumFrames();
+    bool complete = track->isDecoded();
+    int64_t available = track->getNumDecodedFrames();
+    float gain = callbackVolume.load();
+    if (_output == NULL && _left == _right)
+        gain *= 0.5f;		// one source for both channels
+    double p = position.load(std::memory_order_relaxed);
+
+    for (int i=0; i<_numFrames; i++) {
+        if (p >= length - 1 && complete) {
+            if (!looping.load()) {
+                playing.store(false);
+                break;
+            }
+            p -= length - 1;
+        }
+        int64_t frame = (int64_t)p;
+        if (frame + 1 >= available && !complete) {
+            // caught up with the decoder, wait for it where we are
+            callbackUnderruns++;
+            break;
+        }
+        float t = p - frame;
+        const float* a = samples + frame * channels;
+        const float* b = a + channels;
+        float left = a[0] + (b[0] - a[0]) * t;
+        float right = channels > 1 ? a[1] + (b[1] - a[1]) * t : left;
+
+        if (_output == NULL) {
+            _left[i] += left * gain;
+            _right[i] += right * gain;
+        }
+        else if (_numChannels == 1) {
+            _output[i] += 0.5f * (left + right) * gain;
+        }
+        else {
+            _output[i * _numChannels] += left * gain;
+            _output[i * _numChannels + 1] += right * gain;
+        }
+        p += rateRatio;
+    }
+    position.store(p, std::memory_order_relaxed);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ofMain.h"
+#include "PcmTrack.h"
+
+// Plays a PcmTrack from the audio callback, in place of ofSoundPlayer, so
+// the music starts as soon as the track is loaded and the position is the
+// exact frame being heard rather than the player's guess. While the track is
+// still decoding and playback catches up with the decoder it holds and
+// plays silence (counted as an underrun) instead of skipping ahead.
+// Resamples linearly when the track's rate differs from the output's.
+
+class TrackPlayer {
+public:
+    TrackPlayer();
+
+    void	setup(const PcmTrack& _track, int _outputSampleRate);
+
+    ofParameterGroup	parameters;
+
+    // render thread
+    void	play()					{ playing.store(true); }
+    void	stop()					{ playing.store(false); }
+    void	setLoop(bool _loop)		{ looping.store(_loop); }
+    bool	isPlaying() const		{ return playing.load(); }
+    double	getPosition() const;	// seconds
+    int		getPositionMS() const	{ return getPosition() * 1000; }
+    double	getDuration() const;	// seconds
+    bool	isLooping() const		{ return looping.load(); }
+    void	update();				// publishes the underruns to the gui
+
+    // audio thread, adds into _output
+    void	render(float* _output, int _numFrames, int _numChannels);
+    // or the left channel into _sources[0] and the right into _sources[1]
+    void	renderSources(float* const* _sources, int _numSources, int _numFrames);
+
+protected:
+    void	play(float* _output, int _numChannels, float* _left, float* _right, int _numFrames);
+
+    ofParameter<float>	volume;
+    void				setVolume(float& _value)	{ callbackVolume.store(_value); }
+    ofParameter<int>	underruns;
+
+    const PcmTrack*		track;
+    float				rateRatio;		// track frames per output frame
+
+    std::atomic<bool>		playing;
+    std::atomic<bool>		looping;
+    std::atomic<double>		position;	// in track frames
+    std::atomic<float>		callbackVolume;
+    std::atomic<int>		callbackUnderruns;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Latest value exchange between one writer and one reader. The writer fills
+// its back slot and swaps it with the middle one; the reader swaps its front
+// slot with the middle one when something new is there. Both swaps are a
+// single atomic exchange of an index, so neither side ever waits or copies,
+// and the reader always gets the newest complete value. Values the reader
+// never got to are overwritten, not queued.
+
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), back(0), front(2) { }
+
+    // writer side: fill getBack(), then publish(); false when the previous
+    // value was overwritten before the reader took it
+    T&		getBack()		{ return slots[back]; }
+    bool	publish() {
+        uint32_t previous = middle.exchange(back | freshBit, std::memory_order_acq_rel);
+        back = previous & indexMask;
+        return (previous & freshBit) == 0;
+    }
+    // true until the reader has taken the last value published
+    bool	isWaiting() const	{ return (middle.load(std::memory_order_acquire) & freshBit) != 0; }
+
+    // reader side: true when getFront() moved to a newer value
+    bool	acquire() {
+        if ((middle.load(std::memory_order_relaxed) & freshBit) == 0)
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+    T&			getFront()			{ return slots[front]; }
+    const T&	getFront() const	{ return slots[front]; }
+
+    // direct access to every slot, only while neither side is running
+    T&		getSlot(int _index)	{ return slots[_index]; }
+
+private:
+    static const uint32_t	freshBit = 4;
+    static const uint32_t	indexMask = 3;
+
+    T						slots[3];
+    std::atomic<uint32_t>	middle;		// slot index, with freshBit until read
+    uint32_t				back;		// writer only
+    uint32_t				front;		// reader only
+};
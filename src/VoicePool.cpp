@@ -0,0 +1,300 @@
+#include "VoicePool.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+//--------------------------------------------------------------
+VoicePool::VoicePool() {
+    sample = NULL;
+    sampleFrames = 0;
+    sampleChannels = 1;
+    rateRatio = 1;
+    numVoices = 0;
+    numSlots = 0;
+    triggers = 0;
+    stolen = 0;
+    rejected = 0;
+    outputSampleRate = 44100;
+    fadeFrames = 1;
+    glide = 1;
+    volume = 1;
+    for (int v=0; v<maxVoices + maxVoices / 4; v++)
+        voices[v].active = false;
+    for (int g=0; g<maxGroups; g++)
+        groupVoice[g] = -1;
+}
+
+//--------------------------------------------------------------
+void VoicePool::setup(int _numVoices, int _outputSampleRate, int _maxBlockSize) {
+    outputSampleRate = _outputSampleRate;
+    // 5 ms to get a retriggered or stolen voice out of the way
+    fadeFrames = std::max(1, outputSampleRate / 200);
+    setSmoothing(5);
+    setNumVoices(_numVoices);
+
+    // padded to a whole number of vectors
+    int size = (_maxBlockSize + simd::width - 1) / simd::width * simd::width;
+    scratchLeft.assign(size, 0);
+    scratchRight.assign(size, 0);
+    ramp.resize(size);
+    for (int i=0; i<size; i++)
+        ramp[i] = i;
+}
+
+//--------------------------------------------------------------
+void VoicePool::setSample(const float* _data, int64_t _numFrames, int _numChannels, float _rateRatio) {
+    for (int v=0; v<numSlots; v++)
+        voices[v].active = false;
+    sample = _data;
+    sampleFrames = _numFrames;
+    sampleChannels = _numChannels;
+    rateRatio = _rateRatio;
+}
+
+//--------------------------------------------------------------
+void VoicePool::setSmoothing(float _ms) {
+    glide = _ms > 0 ? 1.0f - expf(-1000.0f / (_ms * outputSampleRate)) : 1.0f;
+}
+
+//--------------------------------------------------------------
+void VoicePool::setNumVoices(int _numVoices) {
+    numVoices = std::max(1, std::min(_numVoices, (int)maxVoices));
+    int slots = numVoices + std::max(4, numVoices / 4);
+    for (int v=numSlots; v<slots; v++)
+        voices[v].active = false;
+    // slots only grow, a voice above a lower count still plays out
+    numSlots = std::max(numSlots, slots);
+}
+
+//--------------------------------------------------------------
+int VoicePool::getNumActive() const {
+    int n = 0;
+    for (int v=0; v<numSlots; v++)
+        n += voices[v].active;
+    return n;
+}
+
+//--------------------------------------------------------------
+int VoicePool::getGroupVoice(int _group) const {
+    if (_group < 0 || _group >= maxGroups)
+        return -1;
+    int v = groupVoice[_group];
+    return v >= 0 && voices[v].active && voices[v].group == _group ? v : -1;
+}
+
+//--------------------------------------------------------------
+void VoicePool::fadeOut(Voice& _voice) {
+    if (_voice.fadeRemaining == 0)
+        _voice.fadeRemaining = fadeFrames;
+}
+
+//--------------------------------------------------------------
+bool VoicePool::trigger(float _speed, float _pan, float _gain, float _priority, int _group) {
+    if (sample == NULL || sampleFrames == 0)
+        return false;
+
+    int previous = getGroupVoice(_group);
+    if (previous >= 0)
+        fadeOut(voices[previous]);
+
+    // make room among the audible voices
+    int audible = 0;
+    int victim = -1;
+    for (int v=0; v<numSlots; v++) {
+        const Voice& voice = voices[v];
+        if (!voice.active || voice.fadeRemaining > 0)
+            continue;
+        audible++;
+        if (victim < 0 || voice.priority < voices[victim].priority ||
+            (voice.priority == voices[victim].priority && voice.age < voices[victim].age))
+            victim = v;
+    }
+    if (audible >= numVoices) {
+        if (voices[victim].priority > _priority) {
+            rejected++;
+            return false;
+        }
+        fadeOut(voices[victim]);
+        stolen++;
+    }
+
+    // a free slot, or else the fading voice closest to silence
+    int slot = -1;
+    for (int v=0; v<numSlots; v++) {
+        if (!voices[v].active) {
+            slot = v;
+            break;
+        }
+        if (voices[v].fadeRemaining > 0 && (slot < 0 || voices[v].fadeRemaining < voices[slot].fadeRemaining))
+            slot = v;
+    }
+    if (slot < 0) {
+        rejected++;
+        return false;
+    }
+
+    Voice& voice = voices[slot];
+    voice.active = true;
+    voice.group = _group;
+    voice.priority = _priority;
+    voice.age = triggers++;
+    voice.position = 0;
+    voice.speed = voice.targetSpeed = _speed;
+    voice.pan = voice.targetPan = std::max(-1.0f, std::min(1.0f, _pan));
+    voice.gain = voice.targetGain = _gain;
+    voice.fadeRemaining = 0;
+    if (_group >= 0 && _group < maxGroups)
+        groupVoice[_group] = slot;
+    return true;
+}
+
+//--------------------------------------------------------------
+void VoicePool::setSpeed(int _group, float _speed) {
+    int v = getGroupVoice(_group);
+    if (v >= 0)
+        voices[v].targetSpeed = _speed;
+}
+
+//--------------------------------------------------------------
+void VoicePool::setPan(int _group, float _pan) {
+    int v = getGroupVoice(_group);
+    if (v >= 0)
+        voices[v].targetPan = std::max(-1.0f, std::min(1.0f, _pan));
+}
+
+//--------------------------------------------------------------
+void VoicePool::setGain(int _group, float _gain) {
+    int v = getGroupVoice(_group);
+    if (v >= 0)
+        voices[v].targetGain = _gain;
+}
+
+//--------------------------------------------------------------
+void VoicePool::release(int _group) {
+    int v = getGroupVoice(_group);
+    if (v >= 0)
+        fadeOut(voices[v]);
+}
+
+//--------------------------------------------------------------
+int VoicePool::resample(Voice& _voice, int _numFrames) {
+    // 4 point, 3rd order hermite into the scratch buffers, returns how many
+    // frames the voice has left in it
+    float* dst[2] = { scratchLeft.data(), scratchRight.data() };
+    int channels = std::min(sampleChannels, 2);
+    double position = _voice.position;
+    float speed = _voice.speed;
+    int i = 0;
+    for (; i<_numFrames; i++) {
+        if (position >= sampleFrames)
+            break;
+        int64_t p = (int64_t)position;
+        float t = position - p;
+        for (int c=0; c<channels; c++) {
+            float y[4];
+            if (p >= 1 && p + 2 < sampleFrames) {
+                const float* s = sample + (p - 1) * sampleChannels + c;
+                y[0] = s[0];
+                y[1] = s[sampleChannels];
+                y[2] = s[2 * sampleChannels];
+                y[3] = s[3 * sampleChannels];
+            }
+            else {
+                for (int k=0; k<4; k++) {
+                    int64_t q = p - 1 + k;
+                    y[k] = q >= 0 && q < sampleFrames ? sample[q * sampleChannels + c] : 0.0f;
+                }
+            }
+            float c1 = 0.5f * (y[2] - y[0]);
+            float c2 = y[0] - 2.5f * y[1] + 2.0f * y[2] - 0.5f * y[3];
+            float c3 = 0.5f * (y[3] - y[0]) + 1.5f * (y[1] - y[2]);
+            dst[c][i] = ((c3 * t + c2) * t + c1) * t + y[1];
+        }
+        speed += (_voice.targetSpeed - speed) * glide;
+        position += speed * rateRatio;
+    }
+    for (int c=0; c<channels; c++)
+        std::fill(dst[c] + i, dst[c] + _numFrames, 0.0f);
+    _voice.position = position;
+    _voice.speed = speed;
+    return i;
+}
+
+//--------------------------------------------------------------
+void VoicePool::render(float* _left, float* _right, int _numFrames) {
+    mix(_left, _right, NULL, 0, _numFrames);
+}
+
+//--------------------------------------------------------------
+void VoicePool::renderSources(float* const* _sources, int _numSources, int _numFrames) {
+    if (_numSources > 0)
+        mix(NULL, NULL, _sources, _numSources, _numFrames);
+}
+
+//--------------------------------------------------------------
+void VoicePool::addRamp(const float* _src, float* _dst, float _gain0, float _gain1, int _numFrames) const {
+    simd::vfloat start = simd::set1(_gain0);
+    simd::vfloat step = simd::set1((_gain1 - _gain0) / _numFrames);
+    int i = 0;
+    for (; i+simd::width<=_numFrames; i+=simd::width) {
+        simd::vfloat g = simd::madd(step, simd::load(&ramp[i]), start);
+        simd::store(_dst + i, simd::madd(simd::load(_src + i), g, simd::load(_dst + i)));
+    }
+    for (; i<_numFrames; i++)
+        _dst[i] += _src[i] * (_gain0 + (_gain1 - _gain0) * i / _numFrames);
+}
+
+//--------------------------------------------------------------
+void VoicePool::mix(float* _left, float* _right, float* const* _sources, int _numSources, int _numFrames) {
+    if (sample == NULL)
+        return;
+    int n = std::min(_numFrames, (int)ramp.size());
+    // the one pole glide of pan and gain, applied over the whole block
+    float blockGlide = 1.0f - powf(1.0f - glide, n);
+
+    for (int v=0; v<numSlots; v++) {
+        Voice& voice = voices[v];
+        if (!voice.active)
+            continue;
+
+        int frames = resample(voice, n);
+
+        // gains at the start and end of the block, ramped linearly between
+        float pan0 = voice.pan;
+        float gain0 = voice.gain;
+        voice.pan += (voice.targetPan - voice.pan) * blockGlide;
+        voice.gain += (voice.targetGain - voice.gain) * blockGlide;
+        float fade0 = 1, fade1 = 1;
+        if (voice.fadeRemaining > 0) {
+            fade0 = (float)voice.fadeRemaining / fadeFrames;
+            voice.fadeRemaining = std::max(0, voice.fadeRemaining - n);
+            fade1 = (float)voice.fadeRemaining / fadeFrames;
+            if (voice.fadeRemaining == 0)
+                frames = 0;		// faded out, whatever is left of the sample
+        }
+
+        if (_sources != NULL) {
+            // mono, the source's position does the panning
+            if (sampleChannels > 1) {
+                simd::vfloat half = simd::set1(0.5f);
+                for (int i=0; i<n; i+=simd::width)
+                    simd::store(&scratchLeft[i], simd::mul(half, simd::add(simd::load(&scratchLeft[i]), simd::load(&scratchRight[i]))));
+            }
+            int source = voice.group < 0 ? 0 : std::min(voice.group + 1, _numSources - 1);
+            addRamp(scratchLeft.data(), _sources[source], gain0 * fade0 * volume, voice.gain * fade1 * volume, n);
+        }
+        else {
+            const float quarterPi = 0.785398163f;
+            float angle0 = (pan0 + 1) * quarterPi;
+            float angle1 = (voice.pan + 1) * quarterPi;
+            float gain1 = voice.gain * fade1 * volume;
+            gain0 *= fade0 * volume;
+            addRamp(scratchLeft.data(), _left, cosf(angle0) * gain0, cosf(angle1) * gain1, n);
+            addRamp(sampleChannels == 1 ? scratchLeft.data() : scratchRight.data(), _right, sinf(angle0) * gain0, sinf(angle1) * gain1, n);
+        }
+
+        if (frames < n)
+            voice.active = false;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// A fixed pool of sample playback voices, rendered into planar stereo.
+// Each voice resamples the shared sample with cubic interpolation at its own
+// speed and is mixed with its own gain and equal power pan, ramped linearly
+// over the block so a change never clicks; the mix itself is vectorized.
+// When more than getNumVoices() want to sound, the voice with the lowest
+// priority (then the oldest) is faded out to make room, unless the new one
+// ranks lower still, in which case it is dropped. Fading voices keep their
+// slot until they are silent, in a few spare slots on top of the pool.
+// Voices can be put in a group: a trigger fades out the group's previous
+// voice and the set* calls address its latest one (monophonic, like the
+// mouse synth); group -1 is plain polyphony. renderSources() mixes mono
+// instead, one buffer per group (plus one for the ungrouped voices) for a
+// Spatializer to place; pan is ignored there.
+// Audio thread only, no allocation after setup(), no openFrameworks.
+
+class VoicePool {
+public:
+    static const int	maxVoices = 128;
+    static const int	maxGroups = 16;
+
+    VoicePool();
+
+    void	setup(int _numVoices, int _outputSampleRate, int _maxBlockSize);
+    void	setSample(const float* _data, int64_t _numFrames, int _numChannels, float _rateRatio);
+    void	setVolume(float _volume)	{ volume = _volume; }
+    void	setSmoothing(float _ms);
+    void	setNumVoices(int _numVoices);
+
+    int		getNumVoices() const		{ return numVoices; }
+    int		getNumActive() const;
+    uint64_t	getNumStolen() const	{ return stolen; }
+    uint64_t	getNumRejected() const	{ return rejected; }
+
+    // false when the pool is full of voices that rank higher
+    bool	trigger(float _speed, float _pan, float _gain, float _priority = 0, int _group = -1);
+    void	setSpeed(int _group, float _speed);
+    void	setPan(int _group, float _pan);
+    void	setGain(int _group, float _gain);
+    void	release(int _group);
+
+    // adds _numFrames (at most the setup() block size) into _left and _right
+    void	render(float* _left, float* _right, int _numFrames);
+    // or into _sources[0] for ungrouped voices and _sources[group + 1]
+    // for the rest, the last one taking any groups beyond it
+    void	renderSources(float* const* _sources, int _numSources, int _numFrames);
+
+private:
+    struct Voice {
+        bool		active;
+        int			group;
+        float		priority;
+        uint64_t	age;			// trigger count when it started
+        double		position;		// in sample frames
+        float		speed;
+        float		targetSpeed;
+        float		pan;
+        float		targetPan;
+        float		gain;
+        float		targetGain;
+        int			fadeRemaining;	// > 0 while fading out
+    };
+
+    int		getGroupVoice(int _group) const;
+    void	fadeOut(Voice& _voice);
+    int		resample(Voice& _voice, int _numFrames);
+    void	mix(float* _left, float* _right, float* const* _sources, int _numSources, int _numFrames);
+    void	addRamp(const float* _src, float* _dst, float _gain0, float _gain1, int _numFrames) const;
+
+    const float*		sample;
+    int64_t				sampleFrames;
+    int					sampleChannels;
+    float				rateRatio;
+
+    int					numVoices;
+    int					numSlots;		// voices plus room for the fading ones
+    Voice				voices[maxVoices + maxVoices / 4];
+    int					groupVoice[maxGroups];
+    uint64_t			triggers;
+    uint64_t			stolen;
+    uint64_t			rejected;
+
+    int					outputSampleRate;
+    int					fadeFrames;
+    float				glide;			// per sample smoothing coefficient
+    float				volume;
+
+    std::vector<float>	scratchLeft;	// one voice, resampled
+    std::vector<float>	scratchRight;
+    std::vector<float>	ramp;			// 0, 1, 2, ... for the vector gain ramps
+};
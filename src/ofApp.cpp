@@ -1,11 +1,25 @@
 #include "ofApp.h"
 
-const int N = 256;
-float spectrum[ N ];	//Smoothed spectrum values
 float Rad = 500;
 float Vel = 0.1;
-int bandRad = 2;
-int bandVel = 100;
+int bandRad = 0;		//Filter bank bands driving Rad and Vel,
+int bandVel = 0;		//looked up by frequency in update()
+
+//Rhythm from the analysis thread
+float onsetPulse = 0;	//Jumps on every onset, then decays
+float onsetStrength = 0;	//Strongest onset since the last frame
+float beatPulse = 0;	//Peaks on the beat, follows the beat phase
+float beatPhase = 0;
+float bpm = 120;
+int cachedHop = -1;		//Last hop read from the feature cache
+
+//Modulation matrix sources, the bands follow the rest
+enum { MOD_RMS, MOD_ONSET, MOD_BEAT, MOD_BEAT_PHASE, MOD_BAND };
+int modulationBands = -1;	//Band count the source names were made for
+
+//Spatializer sources, the sampler's ungrouped voices then its mouse group
+enum { SOURCE_MUSIC_LEFT, SOURCE_MUSIC_RIGHT, SOURCE_MOVEMENT, SOURCE_MOUSE, SOURCE_GRAINS,
+       NUM_SOURCES = SOURCE_GRAINS + GranularEngine::numRegions };
 
 const int n = 300;
 
@@ -14,22 +28,38 @@ float tx[n], ty[n];
 
 ofPoint p[n];			//Cloud's points positions
 
-float time0 = 0;		//Time value, used for dt computing
+double time0 = 0;		//Time value, used for dt computing
 
 //--------------------------------------------------------------
 void ofApp::setup(){
-    sound.load( "DreamSpark.mp3" );
-    sound.setLoop( true );
-    sound.play();
+    // both decode in the background the first time, then come straight
+    // from their .pcm caches; playback starts before decoding is done
+    soundTrack.load( "DreamSpark.mp3" );
+    synthSample.load("synth.wav");
+    player.setup( soundTrack, 44100 );
+    player.setLoop( true );
+    player.play();
+    
+    sampler.setup(synthSample, 44100);
+    granular.setup(synthSample, 44100);
+    synthDragging = false;
+    movementBaseline = 0;
+    movementHoldoff = 0;
+    
+    // speakers.xml describes the installation's ring, stereo without it
+    spatialOutput.setup("speakers.xml", NUM_SOURCES);
+    spatialOutput.setSource(SOURCE_MUSIC_LEFT, -45, 0.5f);
+    spatialOutput.setSource(SOURCE_MUSIC_RIGHT, 45, 0.5f);
+    for (int r=0; r<GranularEngine::numRegions; r++)
+        spatialOutput.setSource(SOURCE_GRAINS + r, GranularEngine::getRegionCenter(r));
+    audioClock.setup(44100, 256, 4);
+    soundStream.setup(this, spatialOutput.getNumSpeakers(), 0, 44100, 256, 4);
+    
+    // the analysis thread follows the player through the same decoded track
+    audioAnalyzer.setup( soundTrack, 512, 256, REAL_FFT_WINDOW_HANN );
+    audioAnalyzer.start();
+    featureCache.setup( soundTrack );
     
-    synth.load("synth.wav");
-    synth.setVolume(1.85f);
-    synth.setMultiPlay(false);
-    
-    //Set spectrum values to 0
-    for (int i=0; i<N; i++) {
-        spectrum[i] = 0.0f;
-    }
     for ( int j=0; j<n; j++ ) {
         tx[j] = ofRandom( 0, 1000 );
         ty[j] = ofRandom( 0, 1000 );
@@ -48,11 +78,14 @@ void ofApp::setup(){
     
     // FLOW & MASK
     opticalFlow.setup(flowWidth, flowHeight);
+    averageFlow.setup(flowWidth / 4, flowHeight / 4, "average flow");
     velocityMask.setup(drawWidth, drawHeight);
     
     // FLUID & PARTICLES
     fluidSimulation.setup(flowWidth, flowHeight, drawWidth, drawHeight);
     particleFlow.setup(flowWidth, flowHeight, drawWidth, drawHeight);
+    fluidReadback.setup(flowWidth, flowHeight, flowWidth / 8, flowHeight / 8);
+    flowReadback.setup(flowWidth, flowHeight, flowWidth / 2, flowHeight / 2);
     
     velocityDots.setup(flowWidth / 4, flowHeight / 4);
     
@@ -67,15 +100,44 @@ void ofApp::setup(){
     mouseForces.setup(flowWidth, flowHeight, drawWidth, drawHeight);
     
     // CAMERA
-    kinect.init(true);
-    kinect.open();
-    kinectFbo.allocate(kinect.getWidth(), kinect.getHeight(), GL_RGBA32F);
-    kinectFbo.getTexture().setRGToRGBASwizzles(true);
-    //std::cout<<"djsk:"<<&kinect.getDistancePixels();
-    
-    kinectFbo.begin();
-    ofClear(255, 255, 255, 0);
-    kinectFbo.end();
+    // depth, captured on the grabber's thread and streamed into one texture;
+    // the kinects in sensors.xml stitched into one when it's there, else the
+    // one kinect; without a kinect, replay the newest depth-*.grvd the
+    // recorder left in bin/data instead, and without that, dancers made up
+    // on the spot.
+    // GROOVE_DEPTH_RECORDING set to a .grvd file replays it even with the
+    // kinects plugged in; GROOVE_SYNTHETIC_DEPTH set to a size and rate such
+    // as 1920x1080@60 skips the kinects for a load test
+    int synthWidth = 640, synthHeight = 480;
+    float synthRate = 30;
+    const char* loadTest = getenv("GROOVE_SYNTHETIC_DEPTH");
+    if (loadTest != NULL)
+        sscanf(loadTest, "%dx%d@%f", &synthWidth, &synthHeight, &synthRate);
+    const char* replay = getenv("GROOVE_DEPTH_RECORDING");
+    if (loadTest == NULL && replay != NULL && !depthPlayer.load(replay))
+        ofLogError("ofApp") << "could not replay " << replay;
+    depthSource = &kinect;
+    if (depthPlayer.isLoaded())
+        depthSource = &depthPlayer;
+    else if (loadTest == NULL && fusedDepth.setup("sensors.xml"))
+        depthSource = &fusedDepth;
+    else if (loadTest != NULL || !kinect.setup()) {
+        string newest = DepthPlayer::findNewest();
+        if (loadTest == NULL && !newest.empty() && depthPlayer.load(newest))
+            depthSource = &depthPlayer;
+        else {
+            syntheticDepth.setup(max(synthWidth, 16), max(synthHeight, 16), synthRate);
+            depthSource = &syntheticDepth;
+        }
+    }
+    depthSource->setRecorder(&depthRecorder);
+    depthRecording = false;
+    steadyDepth.setup(depthSource->getWidth(), depthSource->getHeight());
+    kinectDepth.setup(depthSource->getWidth(), depthSource->getHeight());
+    foregroundMask.setup(depthSource->getWidth(), depthSource->getHeight());
+    pointCloud.setup(depthSource->getWidth(), depthSource->getHeight());
+    blobForces.setup(depthSource->getWidth(), depthSource->getHeight(), flowWidth, flowHeight);
+    silhouetteContours.setup(depthSource->getWidth(), depthSource->getHeight(), flowWidth, flowHeight);
     ofLogError("kinect inited");
     
     
@@ -127,12 +189,58 @@ void ofApp::setupGui() {
     gui.setDefaultFillColor(guiFillColor[guiColorSwitch]);
     guiColorSwitch = 1 - guiColorSwitch;
     gui.add(particleFlow.parameters);
+    gui.add(depthSource->parameters);
+    gui.add(depthRecorder.parameters);
+    gui.add(steadyDepth.parameters);
+    gui.add(kinectDepth.parameters);
+    gui.add(foregroundMask.parameters);
+    gui.add(pointCloud.parameters);
+    gui.add(blobForces.parameters);
+    gui.add(silhouetteContours.parameters);
+    gui.add(latency.parameters);
     
     gui.setDefaultHeaderBackgroundColor(guiHeaderColor[guiColorSwitch]);
     gui.setDefaultFillColor(guiFillColor[guiColorSwitch]);
     guiColorSwitch = 1 - guiColorSwitch;
     gui.add(visualizeParameters);
     
+    gui.setDefaultHeaderBackgroundColor(guiHeaderColor[guiColorSwitch]);
+    gui.setDefaultFillColor(guiFillColor[guiColorSwitch]);
+    guiColorSwitch = 1 - guiColorSwitch;
+    gui.add(audioAnalyzer.parameters);
+    gui.add(featureCache.parameters);
+    gui.add(liveInput.parameters);
+    gui.add(player.parameters);
+    gui.add(audioClock.parameters);
+    gui.add(sampler.parameters);
+    
+    movementParameters.setName("movement triggers");
+    movementParameters.add(movementTriggers.set("enabled", true));
+    movementParameters.add(movementThreshold.set("threshold", 2.0, 1.0, 8.0));
+    movementParameters.add(movementFloor.set("floor", 0.02, 0.0, 0.5));
+    movementParameters.add(movementRate.set("max rate", 200, 1, 1000));
+    movementParameters.add(movementGain.set("gain", 0.6, 0.0, 2.0));
+    gui.add(movementParameters);
+    gui.add(granular.parameters);
+    gui.add(spatialOutput.parameters);
+    
+    audioReactParameters.setName("audio reaction");
+    audioReactParameters.add(onsetRadius.set("onset radius", 200, 0, 800));
+    audioReactParameters.add(beatForcing.set("beat forcing", 1.0, 0.0, 5.0));
+    audioReactParameters.add(beatLead.set("beat lead", 0.0, 0.0, 0.2));
+    audioReactParameters.add(bandAttack.set("band attack", 0.01, 0.001, 0.5));
+    audioReactParameters.add(bandRelease.set("band release", 0.55, 0.01, 3.0));
+    bandAttack.addListener(this, &ofApp::setBandAttack);
+    bandRelease.addListener(this, &ofApp::setBandRelease);
+    gui.add(audioReactParameters);
+    
+    setupModulation();
+    gui.setDefaultHeaderBackgroundColor(guiHeaderColor[guiColorSwitch]);
+    gui.setDefaultFillColor(guiFillColor[guiColorSwitch]);
+    guiColorSwitch = 1 - guiColorSwitch;
+    gui.add(modulationMatrix.parameters);
+    ofAddListener(gui.savePressedE, this, &ofApp::saveModulationBases);
+    
     
     // if the settings file is not present the parameters will not be set during this setup
     if (!ofFile("settings.xml"))
@@ -145,26 +253,114 @@ void ofApp::setupGui() {
 
 //--------------------------------------------------------------
 void ofApp::update(){
-    ofSoundUpdate();
+    player.update();
+    // after the swap, so the frames drawn before are on the screen
+    latency.update();
+    
+    //Analyze the live input while it is open, the track otherwise
+    liveInput.update();
+    if ( liveInput.isOpen() != audioAnalyzer.isLive() ) {
+        if ( liveInput.isOpen() ) {
+            audioAnalyzer.setSource( liveInput );
+        }
+        else {
+            audioAnalyzer.setSource( soundTrack );
+        }
+        audioAnalyzer.start();
+    }
     
-    //Get current spectrum with N bands
-    float *val = ofSoundGetSpectrum( N );
+    //Read the track's features from the cache when it is there for the
+    //current analysis settings, the live analysis only runs when it is not
+    bool cached = false;
+    if ( !audioAnalyzer.isLive() ) {
+        featureCache.update( audioAnalyzer.getConfig() );
+        cached = featureCache.isReady();
+    }
+    //Look up the track where it will be heard when this frame reaches the
+    //projector, not where the player is right now
+    audioClock.update();
+    double position = player.getPosition();
+    if ( audioClock.isRunning() ) {
+        position = audioClock.getMediaSeconds();
+        double duration = player.getDuration();
+        if ( player.isLooping() && duration > 0 ) {
+            position -= floor( position / duration ) * duration;
+        }
+        position = max( position, 0.0 );
+    }
+    audioAnalyzer.setPlaybackPosition( position * 1000, player.isPlaying() );
+    audioAnalyzer.setPaused( cached );
+    
+    //Follow the band energies of every hop analyzed since the last frame,
+    //fast up and slow down
+    onsetStrength = 0;
+    if ( cached ) {
+        int hop = featureCache.getHop( position );
+        if ( hop < cachedHop || hop > cachedHop + 32 ) {
+            cachedHop = hop - 1;	//looped or seeked
+        }
+        while ( cachedHop < hop && featureCache.getFrame( cachedHop + 1, audioFrame ) ) {
+            cachedHop++;
+            applyAudioFrame();
+        }
+    }
+    else {
+        cachedHop = -1;
+        while ( audioAnalyzer.popFrame( audioFrame ) ) {
+            applyAudioFrame();
+        }
+    }
     
-    //Update our smoothed spectrum,
-    for ( int i=0; i<N; i++ ) {
-        spectrum[i] *= 0.97;	//Slow decreasing
-        spectrum[i] = max( spectrum[i], val[i] );
+    //The clock already makes up for the output and display latency, the
+    //lead fires the beat earlier still; the cache knows exactly when it comes
+    float leadPhase = -1;
+    if ( cached ) {
+        leadPhase = featureCache.getBeatPhase( position + beatLead );
+    }
+    if ( leadPhase < 0 ) {
+        leadPhase = beatPhase + beatLead * bpm / 60.0f;
+        leadPhase -= floorf( leadPhase );
     }
+    beatPulse = powf( 1.0f - leadPhase, 4.0f ) * audioFrame.tempoConfidence;
     
-    //Update particles using spectrum values
-    float time = ofGetElapsedTimef();
+    //Update particles using band values, in step with the sound card
+    double time = audioClock.getPresentedSeconds();
     float dt = time - time0;
     dt = ofClamp( dt, 0.0, 0.1 );
     time0 = time; //Store the current time
     
-    //Update Rad and Vel from spectrum
-    Rad = ofMap( spectrum[ bandRad ], 1, 3, 400, 800, true );
-    Vel = ofMap( spectrum[ bandVel ], 0, 0.1, 0.05, 0.5 );
+    onsetPulse *= expf( -dt / 0.15f );
+    onsetPulse = max( onsetPulse, onsetStrength );
+    
+    //Drive the routed parameters
+    int numBands = bandEnvelopes.getNumBands();
+    if ( numBands != modulationBands ) {
+        for ( int i=0; i<AudioFrame::maxBands; i++ ) {
+            string name = "band " + ofToString( i + 1 );
+            modulationMatrix.setSourceName( MOD_BAND + i, i < numBands ? name + " (" + audioAnalyzer.getBandName( i ) + ")" : name + " (unused)" );
+        }
+        modulationBands = numBands;
+    }
+    modulationMatrix.setSource( MOD_RMS, audioFrame.rms );
+    modulationMatrix.setSource( MOD_ONSET, onsetPulse );
+    modulationMatrix.setSource( MOD_BEAT, beatPulse );
+    modulationMatrix.setSource( MOD_BEAT_PHASE, leadPhase );
+    for ( int i=0; i<AudioFrame::maxBands; i++ ) {
+        modulationMatrix.setSource( MOD_BAND + i, i < numBands ? bandEnvelopes.get( i ) : 0.0f );
+    }
+    modulationMatrix.update( dt );
+    
+    //Update Rad from the bass and Vel from the highs, the cloud bursts out
+    //on onsets and drifts faster with the tempo
+    float bass = 0, high = 0;
+    if ( bandEnvelopes.getNumBands() > 0 ) {
+        bandRad = audioAnalyzer.findBand( 90 );
+        bandVel = audioAnalyzer.findBand( 8600 );
+        bass = bandEnvelopes.get( bandRad );
+        high = bandEnvelopes.get( bandVel );
+    }
+    Rad = ofMap( bass, 0, 0.3, 400, 800, true ) + onsetRadius * onsetPulse;
+    Vel = ofMap( high, 0, 0.02, 0.05, 0.5 ) * bpm / 120.0f;
     
     //Update particles positions
     for (int j=0; j<n; j++) {
@@ -178,59 +374,77 @@ void ofApp::update(){
     deltaTime = ofGetElapsedTimef() - lastTime;
     lastTime = ofGetElapsedTimef();
     
-    //Update the Kinect
-    
-    kinect.update();
+    //Take the newest frame the depth source has, if there is one
     
-    if (kinect.isFrameNew()) {
-        ofPushStyle();
-        ofEnableBlendMode(OF_BLENDMODE_DISABLED);
-        if (doFlipCamera)
-            kinect.drawDepth(kinectFbo.getWidth(), 0, -kinectFbo.getWidth(), kinectFbo.getHeight());
-        else
-            kinect.drawDepth(0, 0, kinectFbo.getWidth(), kinectFbo.getHeight());
-        
-        
-        ofPopStyle();
-        opticalFlow.setSource(kinect.getTexture());
+    depthRecorder.update();
+    if (depthRecorder.isRecording() != depthRecording) {
+        depthRecording = depthRecorder.isRecording();
+        depthSource->setRecording(depthRecording);
+    }
+    if (depthSource->update()) {
+        latency.setFrame(depthSource->getFrame());
+        const ofShortPixels& steady = steadyDepth.update(depthSource->getFrame().rawDepth);
+        kinectDepth.upload(steady, doFlipCamera);
+        if (drawMode.get() == DRAW_POINT_CLOUD)
+            pointCloud.update(steady);
+        foregroundMask.update(depthSource->getFrame().rawDepth, doFlipCamera);
+        blobForces.track(foregroundMask.getPixels(), depthSource->getFrame(), doFlipCamera);
+        silhouetteContours.track(foregroundMask.getPixels(), depthSource->getFrame());
+        opticalFlow.setSource(kinectDepth.getTexture());
         
         opticalFlow.update();
+        latency.mark(PipelineLatency::STAGE_FLOW);
+        flowReadback.update(opticalFlow.getOpticalFlow());
+        if (flowReadback.isReady())
+            steadyDepth.measureFlow(flowReadback.getVelocity(), flowReadback.getWidth(), flowReadback.getHeight(), foregroundMask.getPixels());
         
-        velocityMask.setDensity(kinectFbo.getTexture());
+        // only the dancers, not the room, feed the fluid
+        velocityMask.setDensity(foregroundMask.getTexture());
         velocityMask.setVelocity(opticalFlow.getOpticalFlow());
         velocityMask.update();
+        latency.mark(PipelineLatency::STAGE_MASK);
+        
+        averageFlow.setTexture(opticalFlow.getOpticalFlow());
+        averageFlow.update();
+        updateMovementTriggers(deltaTime);
     }
+    sampler.update();
     
     
-    fluidSimulation.addVelocity(opticalFlow.getOpticalFlowDecay());
-    fluidSimulation.addDensity(velocityMask.getColorMask());
+    // push the dancer's forces harder on the beat
+    float beatForce = 1.0 + beatForcing * beatPulse;
+    fluidSimulation.addVelocity(opticalFlow.getOpticalFlowDecay(), beatForce);
+    fluidSimulation.addDensity(velocityMask.getColorMask(), beatForce);
     fluidSimulation.addTemperature(velocityMask.getLuminanceMask());
     
     mouseForces.update(deltaTime);
-    
     for (int i=0; i<mouseForces.getNumForces(); i++) {
-        if (mouseForces.didChange(i)) {
-            switch (mouseForces.getType(i)) {
-                case FT_DENSITY:
-                    fluidSimulation.addDensity(mouseForces.getTextureReference(i), mouseForces.getStrength(i));
-                    break;
-                case FT_VELOCITY:
-                    fluidSimulation.addVelocity(mouseForces.getTextureReference(i), mouseForces.getStrength(i));
-                    particleFlow.addFlowVelocity(mouseForces.getTextureReference(i), mouseForces.getStrength(i));
-                    break;
-                case FT_TEMPERATURE:
-                    fluidSimulation.addTemperature(mouseForces.getTextureReference(i), mouseForces.getStrength(i));
-                    break;
-                case FT_PRESSURE:
-                    fluidSimulation.addPressure(mouseForces.getTextureReference(i), mouseForces.getStrength(i));
-                    break;
-                default:
-                    break;
-            }
-        }
+        if (mouseForces.didChange(i))
+            addForce(mouseForces.getType(i), mouseForces.getTextureReference(i), mouseForces.getStrength(i));
+    }
+    
+    // and every dancer's
+    blobForces.update();
+    for (int i=0; i<blobForces.getNumForces(); i++) {
+        if (blobForces.didChange(i))
+            addForce(blobForces.getType(i), blobForces.getTextureReference(i), blobForces.getStrength(i));
     }
     
+    // and their outlines, as walls and as edges shedding density
+    silhouetteContours.update();
+    if (silhouetteContours.isObstacle())
+        fluidSimulation.addTempObstacle(silhouetteContours.getObstacleTexture());
+    if (silhouetteContours.isEmitting())
+        fluidSimulation.addDensity(silhouetteContours.getDensityTexture(), silhouetteContours.getStrength() * beatForce);
+    
     fluidSimulation.update();
+    latency.mark(PipelineLatency::STAGE_FLUID);
+    
+    // the readback is a couple of frames behind, it never waits on the GPU
+    fluidReadback.update(fluidSimulation.getVelocity());
+    if (fluidReadback.isReady())
+        granular.setField(fluidReadback.getVelocity(), fluidReadback.getWidth(), fluidReadback.getHeight());
+    granular.update();
     
     if (particleFlow.isActive()) {
         particleFlow.setSpeed(fluidSimulation.getSpeed());
@@ -240,16 +454,150 @@ void ofApp::update(){
         particleFlow.setObstacle(fluidSimulation.getObstacle());
     }
     particleFlow.update();
+    latency.mark(PipelineLatency::STAGE_PARTICLES);
+    
+}
+//--------------------------------------------------------------
+void ofApp::setupModulation() {
+    modulationMatrix.addSource( "rms", true );
+    modulationMatrix.addSource( "onset" );
+    modulationMatrix.addSource( "beat" );
+    modulationMatrix.addSource( "beat phase" );
+    for ( int i=0; i<AudioFrame::maxBands; i++ ) {
+        modulationMatrix.addSource( "band " + ofToString( i + 1 ), true );
+    }
     
+    modulationMatrix.addTarget( fluidSimulation.parameters.getFloat( "speed" ), "fluid" );
+    modulationMatrix.addTarget( fluidSimulation.parameters.getFloat( "viscosity" ), "fluid" );
+    modulationMatrix.addTarget( fluidSimulation.parameters.getFloat( "vorticity" ), "fluid" );
+    modulationMatrix.addTarget( fluidSimulation.parameters.getFloat( "dissipation" ), "fluid" );
+    modulationMatrix.addTarget( particleFlow.parameters.getFloat( "speed" ), "particles" );
+    modulationMatrix.addTarget( particleFlow.parameters.getFloat( "birth chance" ), "particles" );
+    modulationMatrix.addTarget( particleFlow.parameters.getFloat( "size" ), "particles" );
+    modulationMatrix.addTarget( opticalFlow.parameters.getFloat( "strength" ), "optical flow" );
+    modulationMatrix.addTarget( velocityMask.parameters.getFloat( "strength" ), "velocity mask" );
+    modulationMatrix.addTarget( onsetRadius, "cloud" );
+    modulationMatrix.addTarget( beatForcing );
+    
+    modulationMatrix.setup( 8 );
+}
+
+//--------------------------------------------------------------
+void ofApp::addForce(ftDrawForceType _type, ofTexture& _texture, float _strength){
+    switch (_type) {
+        case FT_DENSITY:
+            fluidSimulation.addDensity(_texture, _strength);
+            break;
+        case FT_VELOCITY:
+            fluidSimulation.addVelocity(_texture, _strength);
+            particleFlow.addFlowVelocity(_texture, _strength);
+            break;
+        case FT_TEMPERATURE:
+            fluidSimulation.addTemperature(_texture, _strength);
+            break;
+        case FT_PRESSURE:
+            fluidSimulation.addPressure(_texture, _strength);
+            break;
+        default:
+            break;
+    }
 }
+
+//--------------------------------------------------------------
+void ofApp::updateMovementTriggers(float _dt){
+    //A burst is a jump in the flow well over its recent average; the
+    //sampler's voice pool decides what gives way when they pile up
+    float magnitude = averageFlow.getMagnitude();
+    movementHoldoff = max( movementHoldoff - _dt, 0.0f );
+    float threshold = max( movementBaseline * movementThreshold, movementFloor.get() );
+    if ( movementTriggers && movementHoldoff == 0 && magnitude > threshold ) {
+        float strength = ofClamp( magnitude / threshold - 1, 0, 1 );
+        ofVec2f direction = averageFlow.getDirection();
+        sampler.trigger( 0.5f + 1.5f * strength,
+                         ofClamp( direction.x, -1, 1 ),
+                         movementGain * ( 0.3f + 0.7f * strength ),
+                         strength );
+        spatialOutput.setSource( SOURCE_MOVEMENT, direction * strength );
+        movementHoldoff = 1.0f / movementRate;
+    }
+    movementBaseline += ( magnitude - movementBaseline ) * min( _dt / 1.5f, 1.0f );
+}
+
+//--------------------------------------------------------------
+void ofApp::applyAudioFrame(){
+    if ( bandEnvelopes.getNumBands() != audioFrame.numBands ) {
+        bandEnvelopes.setup( audioFrame.numBands, bandAttack, bandRelease );
+    }
+    bandEnvelopes.update( audioFrame.bands, audioAnalyzer.getHopDuration() );
+    if ( audioFrame.onset ) {
+        onsetStrength = max( onsetStrength, audioFrame.onsetStrength );
+    }
+    //the latest frame carries the current tempo and phase
+    bpm = audioFrame.bpm;
+    beatPhase = audioFrame.beatPhase;
+}
+
+//--------------------------------------------------------------
+void ofApp::exit(){
+    soundStream.close();
+    depthRecorder.stop();
+    latency.stop();
+    fusedDepth.close();
+    kinect.close();
+    depthPlayer.close();
+    syntheticDepth.close();
+    audioAnalyzer.stop();
+    liveInput.close();
+    featureCache.close();
+    soundTrack.close();
+    synthSample.close();
+}
+
 //--------------------------------------------------------------
 
 void ofApp::mousePressed(int x, int y, int button){
     float widthStep = ofGetWidth();
-    if (x < widthStep){
-        synth.play();
-        synth.setSpeed( 0.1f + ((float)(ofGetHeight() - y) / (float)ofGetHeight())*5);
-        synth.setPan(ofMap(x, 0, widthStep, -1, 1, true));
+    synthDragging = x < widthStep;
+    if (synthDragging){
+        sampler.trigger(0.1f + ((float)(ofGetHeight() - y) / (float)ofGetHeight())*5,
+                        ofMap(x, 0, widthStep, -1, 1, true),
+                        1.85f, 1.0f, 0);
+        spatialOutput.setSource(SOURCE_MOUSE, ofVec2f(ofMap(x, 0, ofGetWidth(), -1, 1, true), ofMap(y, 0, ofGetHeight(), -1, 1, true)));
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::mouseDragged(int x, int y, int button){
+    //Bend the sound that is playing
+    if (synthDragging){
+        sampler.setSpeed(0, 0.1f + ((float)(ofGetHeight() - ofClamp(y, 0, ofGetHeight())) / (float)ofGetHeight())*5);
+        sampler.setPan(0, ofMap(x, 0, ofGetWidth(), -1, 1, true));
+        spatialOutput.setSource(SOURCE_MOUSE, ofVec2f(ofMap(x, 0, ofGetWidth(), -1, 1, true), ofMap(y, 0, ofGetHeight(), -1, 1, true)));
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::audioOut(ofSoundBuffer& _buffer){
+    _buffer.set(0);
+    float* output = _buffer.getBuffer();
+    int frames = _buffer.getNumFrames();
+    int channels = _buffer.getNumChannels();
+    audioClock.tick(frames, player.getPosition(), player.isPlaying());
+    if (!spatialOutput.isMultichannel()) {
+        player.render(output, frames, channels);
+        sampler.render(output, frames, channels);
+        granular.render(output, frames, channels);
+        return;
+    }
+    
+    //Every source mono into its own buffer, then placed on the speakers
+    for (int start=0; start<frames; start+=spatialOutput.getMaxBlockSize()) {
+        int n = min(spatialOutput.getMaxBlockSize(), frames - start);
+        float* const* sources = spatialOutput.begin(n);
+        player.renderSources(sources + SOURCE_MUSIC_LEFT, 2, n);
+        sampler.renderSources(sources + SOURCE_MOVEMENT, 2, n);
+        granular.renderSources(sources + SOURCE_GRAINS, GranularEngine::numRegions, n);
+        spatialOutput.end(output + start * channels, n, channels);
     }
 }
 
@@ -267,23 +615,26 @@ void ofApp::keyPressed(int key){
         case '3': drawMode.set(DRAW_FLUID_PRESSURE); break;
         case '4': drawMode.set(DRAW_FLOW_MASK); break;
         case '5': drawMode.set(DRAW_SOURCE); break;
+        case '6': drawMode.set(DRAW_POINT_CLOUD); break;
             
         case 'r':
         case 'R':
             fluidSimulation.reset();
             mouseForces.reset();
+            blobForces.reset();
+            silhouetteContours.reset();
+            steadyDepth.reset();
             break;
         default: break;
     }
-    if(key == OF_KEY_UP){
-        angle++;
+    // to whichever sensors are running; their threads send only the last
+    // angle, the keys never wait on USB
+    if(key == OF_KEY_UP || key == OF_KEY_DOWN){
+        angle += key == OF_KEY_UP ? 1 : -1;
         if(angle>30) angle=30;
-        kinect.setCameraTiltAngle(angle);
-    }
-    else if(key == OF_KEY_DOWN){
-        angle--;
         if(angle<-30) angle=-30;
-        kinect.setCameraTiltAngle(angle);
+        if(!depthSource->setTiltAngle(angle))
+            ofLogNotice("ofApp") << "the depth source has no motor to tilt";
     }
     
 }
@@ -298,6 +649,7 @@ void ofApp::drawModeSetName(int &_value) {
         case DRAW_FLUID_VORTICITY:	drawName.set("Fluid Vorticity"); break;
         case DRAW_FLOW_MASK:		drawName.set("Mask      (4)"); break;
         case DRAW_SOURCE:			drawName.set("Source     (5)"); break;
+        case DRAW_POINT_CLOUD:		drawName.set("Point Cloud (6)"); break;
     }
 }
 
@@ -316,6 +668,7 @@ void ofApp::draw(){
             case DRAW_FLUID_PRESSURE: drawFluidPressure(); break;
             case DRAW_FLOW_MASK: drawMask(); break;
             case DRAW_SOURCE: drawSource(); break;
+            case DRAW_POINT_CLOUD: drawPointCloud(); break;
         }
     }
     else {
@@ -329,9 +682,11 @@ void ofApp::draw(){
             case DRAW_FLUID_PRESSURE: drawFluidPressure(); break;
             case DRAW_FLOW_MASK: drawMask(); break;
             case DRAW_SOURCE: drawSource(); break;
+            case DRAW_POINT_CLOUD: drawPointCloud(); break;
         }
         drawGui();
     }
+    latency.drawn();
 }
 
 //--------------------------------------------------------------
@@ -445,6 +800,12 @@ void ofApp::drawMask(int _x, int _y, int _width, int _height) {
     ofPopStyle();
 }
 
+//--------------------------------------------------------------
+void ofApp::drawPointCloud(int _x, int _y, int _width, int _height) {
+    ofClear(0,0);
+    pointCloud.draw(fluidSimulation.getVelocity(), doFlipCamera, _x, _y, _width, _height);
+}
+
 void ofApp::drawSource(int _x, int _y, int _width, int _height) {
     ofPushStyle();
     ofClear(0,0);
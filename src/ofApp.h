@@ -4,6 +4,29 @@
 #include "ofxGui.h"
 #include "ofxFlowTools.h"
 #include "ofxKinect.h"
+#include "PcmTrack.h"
+#include "TrackPlayer.h"
+#include "AudioClock.h"
+#include "AudioAnalyzer.h"
+#include "BandEnvelopes.h"
+#include "FeatureCache.h"
+#include "ModulationMatrix.h"
+#include "SamplerEngine.h"
+#include "FluidReadback.h"
+#include "GranularEngine.h"
+#include "SpatialOutput.h"
+#include "KinectGrabber.h"
+#include "DepthPlayer.h"
+#include "DepthRecorder.h"
+#include "DepthUpload.h"
+#include "ForegroundMask.h"
+#include "SteadyDepth.h"
+#include "PointCloud.h"
+#include "BlobForces.h"
+#include "SilhouetteContours.h"
+#include "SyntheticDepth.h"
+#include "FusedDepth.h"
+#include "PipelineLatency.h"
 
 //#define USE_PROGRAMMABLE_GL
 
@@ -21,6 +44,7 @@ enum drawModeEnum{
     DRAW_FLOW_MASK,
     DRAW_OPTICAL_FLOW,
     DRAW_SOURCE,
+    DRAW_POINT_CLOUD,
     
 };
 
@@ -29,20 +53,82 @@ public:
     void	setup();
     void	update();
     void	draw();
+    void	exit();
     void    mousePressed(int x, int y, int button);
-    
-    ofSoundPlayer sound;
-    ofSoundPlayer synth;
+    void	mouseDragged(int x, int y, int button);
+    void	audioOut(ofSoundBuffer& _buffer);
+    
+    // The music, played from the sound card callback like the synth
+    TrackPlayer			player;
+    // what the sound card is playing, to line the visuals up with it
+    AudioClock			audioClock;
+    
+    // Synth, played from the sound card callback
+    ofSoundStream		soundStream;
+    PcmTrack			synthSample;
+    SamplerEngine		sampler;
+    bool				synthDragging;
+    
+    // Movement bursts in the optical flow trigger the synth too
+    ftAverageVelocity	averageFlow;
+    ofParameterGroup	movementParameters;
+    ofParameter<bool>	movementTriggers;
+    ofParameter<float>	movementThreshold;	// times the running average
+    ofParameter<float>	movementFloor;
+    ofParameter<float>	movementRate;		// triggers per second at most
+    ofParameter<float>	movementGain;
+    float				movementBaseline;
+    float				movementHoldoff;
+    void				updateMovementTriggers(float _dt);
+    
+    // The fluid's velocity, heard through a cloud of grains
+    FluidReadback		fluidReadback;
+    GranularEngine		granular;
+    
+    // Everything above placed on the speakers, when there are more than two
+    SpatialOutput		spatialOutput;
+    
+    // Audio analysis
+    PcmTrack			soundTrack;
+    LiveAudioInput		liveInput;
+    AudioAnalyzer		audioAnalyzer;
+    FeatureCache		featureCache;
+    AudioFrame			audioFrame;
+    void				applyAudioFrame();
+    BandEnvelopes		bandEnvelopes;
+    ofParameterGroup	audioReactParameters;
+    ofParameter<float>	onsetRadius;
+    ofParameter<float>	beatForcing;
+    ofParameter<float>	beatLead;
+    ofParameter<float>	bandAttack;
+    void				setBandAttack(float& _value) { bandEnvelopes.setAttack(_value); }
+    ofParameter<float>	bandRelease;
+    void				setBandRelease(float& _value) { bandEnvelopes.setRelease(_value); }
+    ModulationMatrix	modulationMatrix;
+    void				setupModulation();
+    // the gui's save button, the settings keep the unmodulated values
+    void				saveModulationBases()	{ modulationMatrix.restoreBases(); }
     // Camera
     
-    ofxKinect kinect;
-    ftFbo kinectFbo;
+    FusedDepth			fusedDepth;		// several kinects as one, from sensors.xml
+    KinectGrabber		kinect;
+    DepthPlayer			depthPlayer;	// a recording, when there is no kinect
+    SyntheticDepth		syntheticDepth;	// or generated bodies, also for load tests
+    DepthSource*		depthSource;	// whichever of them is running
+    DepthRecorder		depthRecorder;
+    bool				depthRecording;	// as the source was last told
+    SteadyDepth			steadyDepth;	// the source's latest frame without the flicker
+    DepthUpload			kinectDepth;	// and on the GPU, for the optical flow
+    ForegroundMask		foregroundMask;	// the dancers in it, for the velocity mask
+    PointCloud			pointCloud;		// and in space, for DRAW_POINT_CLOUD
+    FluidReadback		flowReadback;	// the optical flow back on the CPU, for the filter's readout
     bool				didCamUpdate;
     ofParameter<bool>	doFlipCamera;
     
     // Time
     float				lastTime;
     float				deltaTime;
+    PipelineLatency		latency;		// how old the depth is at each stage, and on the screen
     
     // FlowTools
     int                 angle;  //kinect angle
@@ -63,6 +149,10 @@ public:
     
     // MouseDraw
     ftDrawMouseForces	mouseForces;
+    // and the dancers, each a force of its own
+    BlobForces			blobForces;
+    SilhouetteContours	silhouetteContours;	// and their outlines, as walls and emitters
+    void				addForce(ftDrawForceType _type, ofTexture& _texture, float _strength);
     
     // Visualisations
     ofParameterGroup	visualizeParameters;
@@ -126,5 +216,7 @@ public:
     
     void				drawSource()			{ drawSource(0, 0, ofGetWindowWidth(), ofGetWindowHeight()); }
     void				drawSource(int _x, int _y, int _width, int _height);
+    void				drawPointCloud()		{ drawPointCloud(0, 0, ofGetWindowWidth(), ofGetWindowHeight()); }
+    void				drawPointCloud(int _x, int _y, int _width, int _height);
     
 };